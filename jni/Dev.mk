@@ -1,55 +1,81 @@
 CC     = gcc
-CFLAGS = -shared -Wall -O3 -fpic \
+CFLAGS = -Wall -O3 \
          -I$(JAVA_HOME)/include \
          -I$(JAVA_HOME)/include/$(shell uname | tr A-Z a-z)
 OUTDIR = ../target
 
-all: $(OUTDIR)/libspokestack-android.jnilib
-
-clean:
-	$(RM) $(OUTDIR)/libspokestack-android.jnilib
-	$(RM) $(OUTDIR)/libspokestack-android.so
-
-rebuild: clean all
-
-$(OUTDIR)/libspokestack-android.so: \
+SOURCES = \
+	aec.cpp \
 	agc.cpp \
 	vad.cpp \
 	ans.cpp \
+	preroll.cpp \
+	trace.cpp \
+	qmf.cpp \
 	filter_audio/other/complex_bit_reverse.c \
 	filter_audio/other/complex_fft.c \
 	filter_audio/other/copy_set_operations.c \
 	filter_audio/other/cross_correlation.c \
+	filter_audio/other/delay_estimator.c \
+	filter_audio/other/delay_estimator_wrapper.c \
 	filter_audio/other/division_operations.c \
 	filter_audio/other/dot_product_with_scale.c \
 	filter_audio/other/downsample_fast.c \
 	filter_audio/other/energy.c \
+	filter_audio/other/fft4g.c \
 	filter_audio/other/get_scaling_square.c \
 	filter_audio/other/min_max_operations.c \
+	filter_audio/other/randomization_functions.c \
 	filter_audio/other/real_fft.c \
 	filter_audio/other/resample_by_2.c \
 	filter_audio/other/resample_by_2_internal.c \
 	filter_audio/other/resample_fractional.c \
 	filter_audio/other/resample_48khz.c \
+	filter_audio/other/ring_buffer.c \
 	filter_audio/other/spl_init.c \
 	filter_audio/other/spl_sqrt.c \
 	filter_audio/other/spl_sqrt_floor.c \
+	filter_audio/other/splitting_filter.c \
 	filter_audio/other/vector_scaling_operations.c \
 	filter_audio/vad/vad_core.c \
 	filter_audio/vad/vad_filterbank.c \
 	filter_audio/vad/vad_gmm.c \
 	filter_audio/vad/vad_sp.c \
 	filter_audio/vad/webrtc_vad.c \
+	filter_audio/aec/aec_core.c \
+	filter_audio/aec/aec_rdft.c \
+	filter_audio/aec/aec_resampler.c \
+	filter_audio/aec/echo_cancellation.c \
 	filter_audio/agc/analog_agc.c \
 	filter_audio/agc/digital_agc.c \
+	filter_audio/ns/noise_suppression.c \
+	filter_audio/ns/ns_core.c \
 	filter_audio/ns/nsx_core.c \
 	filter_audio/ns/nsx_core_c.c \
 	filter_audio/ns/noise_suppression_x.c
 
+all: $(OUTDIR)/libspokestack-android.jnilib
+
+clean:
+	$(RM) $(OUTDIR)/libspokestack-android.jnilib
+	$(RM) $(OUTDIR)/libspokestack-android.so
+	$(RM) $(OUTDIR)/ans-bench
+
+rebuild: clean all
+
+# compare the fixed/float noise suppressors on the host
+bench: $(OUTDIR)/ans-bench
+	$(OUTDIR)/ans-bench
+
+$(OUTDIR)/libspokestack-android.so: $(SOURCES)
+
 %.so:
-	$(CC) $(CFLAGS) -o $@ $^
+	$(CC) $(CFLAGS) -shared -fpic -o $@ $^
+
+$(OUTDIR)/ans-bench: ans_bench.cpp $(SOURCES)
+	$(CC) $(CFLAGS) -o $@ $^ -lm
 
 %.jnilib: %.so
 	cp $^ $@
 
-.PHONY: all clean rebuild
+.PHONY: all clean rebuild bench
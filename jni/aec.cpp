@@ -0,0 +1,190 @@
+/****************************************************************************
+ *
+ * MODULE:  aec.cpp
+ * PURPOSE: webrtc acoustic echo cancellation (aec) jni wrapper
+ *
+ ***************************************************************************/
+/*-------------------[       Pre Include Defines       ]-------------------*/
+/*-------------------[      Library Include Files      ]-------------------*/
+#include <jni.h>
+#include <stdlib.h>
+#include <string.h>
+/*-------------------[      Project Include Files      ]-------------------*/
+#include "convert.h"
+#include "qmf.h"
+#include "filter_audio/aec/include/echo_cancellation.h"
+/*-------------------[      Macros/Constants/Types     ]-------------------*/
+// canceller instance
+// . 8/16kHz frames are processed directly by the canceller
+// . 32/48kHz near-end frames are split into low/high bands at 32kHz,
+//   and only the low band of the far-end reference is buffered
+typedef struct AecContext {
+   void*    aec;
+   int      rate;
+   int      delay;
+   QmfState nearQmf;
+   QmfState farQmf;
+} AecContext;
+/*-------------------[        Global Variables         ]-------------------*/
+/*-------------------[        Global Prototypes        ]-------------------*/
+/*-------------------[        Module Variables         ]-------------------*/
+/*-------------------[        Module Prototypes        ]-------------------*/
+static void Destroy(AecContext* aec);
+/*-------------------[         Implementation          ]-------------------*/
+/*-----------< FUNCTION: AcousticEchoCanceller_create >----------------------
+// Purpose:    creates and configures a new webrtc echo canceller component
+// Parameters: env    - java environment
+//             self   - java this reference
+//             rate   - sample rate, in Hz (8000/16000/32000/48000)
+//             policy - nonlinear processing policy (0..2) in order of
+//                      aggressiveness
+//             delay  - playback delay of the far-end reference, in ms
+// Returns:    pointer to the opaque canceller instance if successful
+//             null otherwise
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+jlong JNICALL Java_io_spokestack_spokestack_webrtc_AcousticEchoCanceller_create(
+      JNIEnv* env,
+      jobject self,
+      jint    rate,
+      jint    policy,
+      jint    delay) {
+   AecContext* aec = (AecContext*)calloc(1, sizeof(AecContext));
+   if (aec == NULL)
+      return 0;
+   aec->rate = rate;
+   aec->delay = delay;
+   // create and initialize the canceller instance
+   // the canceller runs at 32kHz (split bands) for full-band audio
+   int aecRate = rate > 32000 ? 32000 : rate;
+   int result = WebRtcAec_Create(&aec->aec);
+   if (result == 0) {
+      result = WebRtcAec_Init(aec->aec, aecRate, aecRate);
+      // configure the aec instance
+      if (result == 0) {
+         AecConfig config; memset(&config, 0, sizeof(config));
+         config.nlpMode       = policy;
+         config.skewMode      = kAecFalse;
+         config.metricsMode   = kAecFalse;
+         config.delay_logging = kAecFalse;
+         result = WebRtcAec_set_config(aec->aec, config);
+      }
+      // configure the band splitters
+      if (result == 0 && rate >= 32000)
+         result = Qmf_Init(&aec->nearQmf, rate);
+      if (result == 0 && rate >= 32000)
+         result = Qmf_Init(&aec->farQmf, rate);
+   }
+   // if something went wrong, cleanup
+   if (result != 0) {
+      Destroy(aec);
+      aec = NULL;
+   }
+   return (jlong)aec;
+}
+/*-----------< FUNCTION: AcousticEchoCanceller_destroy >---------------------
+// Purpose:    releases aec resources
+// Parameters: env  - java environment
+//             self - java this reference
+//             aec  - aec handle returned by create()
+// Returns:    none
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+void JNICALL Java_io_spokestack_spokestack_webrtc_AcousticEchoCanceller_destroy(
+      JNIEnv* env,
+      jobject self,
+      jlong   aec) {
+   Destroy((AecContext*)aec);
+}
+/*-----------< FUNCTION: AcousticEchoCanceller_process >---------------------
+// Purpose:    processes a 10ms audio frame, cancelling the echo of the
+//             far-end reference from the near-end signal
+// Parameters: env    - java environment
+//             self   - java this reference
+//             handle - canceller handle returned by create()
+//             near   - near-end (microphone) buffer (16-bit samples),
+//                      updated in place
+//             far    - far-end (playback) reference buffer (16-bit samples)
+//             offset - offset, in bytes, to start reading/writing the buffers
+// Returns:    0 if successful
+//             -1 on error
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+jint JNICALL Java_io_spokestack_spokestack_webrtc_AcousticEchoCanceller_process(
+      JNIEnv* env,
+      jobject self,
+      jlong   handle,
+      jobject near,
+      jobject far,
+      jint    offset) {
+   AecContext* aec = (AecContext*)handle;
+   int16_t* nearFrame = (int16_t*)env->GetDirectBufferAddress(near);
+   int16_t* farFrame = (int16_t*)env->GetDirectBufferAddress(far);
+   nearFrame += offset / sizeof(int16_t);
+   farFrame += offset / sizeof(int16_t);
+   float nearLow[QMF_BAND_LENGTH];
+   float nearHigh[QMF_BAND_LENGTH];
+   float outLow[QMF_BAND_LENGTH];
+   float outHigh[QMF_BAND_LENGTH];
+   float farLow[QMF_BAND_LENGTH];
+   int result;
+   if (aec->rate < 32000) {
+      int length = aec->rate / 100;
+      S16ToFloat(farFrame, farLow, length);
+      result = WebRtcAec_BufferFarend(aec->aec, farLow, length);
+      if (result == 0) {
+         S16ToFloat(nearFrame, nearLow, length);
+         result = WebRtcAec_Process(
+            aec->aec,
+            nearLow,
+            NULL,
+            outLow,
+            NULL,
+            length,
+            aec->delay,
+            0);
+      }
+      if (result == 0)
+         FloatToS16(outLow, nearFrame, length);
+   } else {
+      // split both signals into bands, cancel in the split domain,
+      // and merge the near-end bands back in place
+      int16_t low[QMF_BAND_LENGTH];
+      int16_t high[QMF_BAND_LENGTH];
+      Qmf_Analyze(&aec->farQmf, farFrame, low, high);
+      S16ToFloat(low, farLow, QMF_BAND_LENGTH);
+      result = WebRtcAec_BufferFarend(aec->aec, farLow, QMF_BAND_LENGTH);
+      if (result == 0) {
+         Qmf_Analyze(&aec->nearQmf, nearFrame, low, high);
+         S16ToFloat(low, nearLow, QMF_BAND_LENGTH);
+         S16ToFloat(high, nearHigh, QMF_BAND_LENGTH);
+         result = WebRtcAec_Process(
+            aec->aec,
+            nearLow,
+            nearHigh,
+            outLow,
+            outHigh,
+            QMF_BAND_LENGTH,
+            aec->delay,
+            0);
+      }
+      if (result == 0) {
+         FloatToS16(outLow, low, QMF_BAND_LENGTH);
+         FloatToS16(outHigh, high, QMF_BAND_LENGTH);
+         Qmf_Synthesize(&aec->nearQmf, low, high, nearFrame);
+      }
+   }
+   return result;
+}
+/*-----------< FUNCTION: Destroy >-------------------------------------------
+// Purpose:    releases a canceller instance
+// Parameters: aec - canceller instance to release
+// Returns:    none
+---------------------------------------------------------------------------*/
+void Destroy(AecContext* aec) {
+   if (aec != NULL) {
+      if (aec->aec != NULL)
+         WebRtcAec_Free(aec->aec);
+      free(aec);
+   }
+}
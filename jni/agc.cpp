@@ -7,22 +7,42 @@
 /*-------------------[       Pre Include Defines       ]-------------------*/
 /*-------------------[      Library Include Files      ]-------------------*/
 #include <jni.h>
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 /*-------------------[      Project Include Files      ]-------------------*/
 #include "filter_audio/agc/include/gain_control.h"
+#include "trace.h"
 /*-------------------[      Macros/Constants/Types     ]-------------------*/
 #define MIC_MAX      255   // maximum virtual mic level
 #define MIC_TARGET   180   // -3dBFS
+#define MIN_ENERGY   1.0   // energy floor for level calculations
+
+// telemetry values reported for each processed frame
+#define LEVEL_GAIN        0   // applied gain, in dB
+#define LEVEL_RMS         1   // post-gain rms level, in dBFS
+#define LEVEL_SATURATED   2   // 1 if the agc detected saturation, else 0
+#define LEVEL_COUNT       3
+
+// agc instance
+struct AgcContext {
+   void* agc;
+   int   mode;
+};
 /*-------------------[        Global Variables         ]-------------------*/
 /*-------------------[        Global Prototypes        ]-------------------*/
 /*-------------------[        Module Variables         ]-------------------*/
+static int g_trace_levels = TRACE_UNREGISTERED;
 /*-------------------[        Module Prototypes        ]-------------------*/
+static double Energy(const int16_t* frame, int length);
 /*-------------------[         Implementation          ]-------------------*/
 /*-----------< FUNCTION: AutomaticGainControl_create >-----------------------
 // Purpose:    creates and configures a new webrtc agc component
 // Parameters: env               - java environment
 //             self              - java this reference
 //             rate              - sample rate, in Hz
+//             mode              - agc mode (kAgcModeAdaptiveDigital or
+//                                 kAgcModeFixedDigital)
 //             targetLeveldBFS   - target peak energy, in dB full scale
 //             compressionGaindB - dynamic range compression rate, in dB
 //             limiterEnable     - true to enable the agc's peak limiter
@@ -34,29 +54,35 @@ jlong JNICALL Java_io_spokestack_spokestack_webrtc_AutomaticGainControl_create(
       JNIEnv*  env,
       jobject  self,
       jint     rate,
+      jint     mode,
       jint     targetLeveldBFS,
       jint     compressionGaindB,
       jboolean limiterEnable) {
+   AgcContext* context = (AgcContext*)calloc(1, sizeof(AgcContext));
+   if (context == NULL)
+      return 0;
+   context->mode = mode;
    // create and initialize the agc instance
-   void* agc = NULL;
-   int result = WebRtcAgc_Create(&agc);
+   int result = WebRtcAgc_Create(&context->agc);
    if (result == 0) {
-      result = WebRtcAgc_Init(agc, 0, MIC_MAX, kAgcModeAdaptiveDigital, rate);
+      result = WebRtcAgc_Init(context->agc, 0, MIC_MAX, mode, rate);
       if (result == 0) {
          // configure the agc
          WebRtcAgc_config_t config; memset(&config, 0, sizeof(config));
          config.targetLevelDbfs   = targetLeveldBFS;
          config.limiterEnable     = limiterEnable ? kAgcTrue : kAgcFalse;
          config.compressionGaindB = compressionGaindB;
-         result = WebRtcAgc_set_config(agc, config);
-      }
-      // if something went wrong, clean up
-      if (result != 0) {
-         WebRtcAgc_Free(agc);
-         agc = NULL;
+         result = WebRtcAgc_set_config(context->agc, config);
       }
    }
-   return (jlong)agc;
+   // if something went wrong, clean up
+   if (result != 0) {
+      if (context->agc != NULL)
+         WebRtcAgc_Free(context->agc);
+      free(context);
+      context = NULL;
+   }
+   return (jlong)context;
 }
 /*-----------< FUNCTION: AutomaticGainControl_destroy >----------------------
 // Purpose:    releases agc resources
@@ -70,49 +96,101 @@ void JNICALL Java_io_spokestack_spokestack_webrtc_AutomaticGainControl_destroy(
       JNIEnv* env,
       jobject self,
       jlong   agc) {
-   WebRtcAgc_Free((void*)agc);
+   AgcContext* context = (AgcContext*)agc;
+   if (context != NULL) {
+      WebRtcAgc_Free(context->agc);
+      free(context);
+   }
 }
 /*-----------< FUNCTION: AutomaticGainControl_process >----------------------
-// Purpose:    processes an audio frame, applying gain as needed
+// Purpose:    processes an audio frame, applying gain as needed, and
+//             reports the resulting levels
 // Parameters: env    - java environment
 //             self   - java this reference
 //             agc    - agc handle returned by create()
 //             buffer - sample buffer (16-bit samples)
 //             length - size, in bytes, of the buffer
-// Returns:    1 if voiced speech was detected
-//             0 if not detected
+//             levels - telemetry output (LEVEL_COUNT floats, see LEVEL_*),
+//                      or null to skip measuring levels unless traced
+// Returns:    0 if successful
 //             -1 on error
 ---------------------------------------------------------------------------*/
 extern "C" JNIEXPORT
 jint JNICALL Java_io_spokestack_spokestack_webrtc_AutomaticGainControl_process(
-      JNIEnv* env,
-      jobject self,
-      jlong   agc,
-      jobject buffer,
-      jint    length) {
+      JNIEnv*     env,
+      jobject     self,
+      jlong       agc,
+      jobject     buffer,
+      jint        length,
+      jfloatArray levels) {
+   AgcContext* context = (AgcContext*)agc;
    int16_t* frame = (int16_t*)env->GetDirectBufferAddress(buffer);
+   int samples = length / 2;
    uint8_t saturated = 0;
    int32_t mic_level = 0;
-   // first call virtualmic to analyze the audio frame and set the mic level
-   int result = WebRtcAgc_VirtualMic(
-      (void*)agc,
-      frame,
-      NULL,
-      length / 2,
-      MIC_TARGET,
-      &mic_level);
+   // measure the input level, before any gain is applied,
+   // only if the levels are requested or traced
+   bool measure = levels != NULL || Trace_IsEnabled();
+   double input = measure ? Energy(frame, samples) : MIN_ENERGY;
+   // in adaptive mode, first call virtualmic to analyze the audio frame
+   // and set the mic level
+   int result = 0;
+   if (context->mode == kAgcModeAdaptiveDigital)
+      result = WebRtcAgc_VirtualMic(
+         context->agc,
+         frame,
+         NULL,
+         samples,
+         MIC_TARGET,
+         &mic_level);
    // call process to adjust the audio levels to the target
    if (result == 0)
       result = WebRtcAgc_Process(
-         (void*)agc,
+         context->agc,
          frame,
          NULL,
-         length / 2,
+         samples,
          frame,
          NULL,
          MIC_TARGET,
          &mic_level,
          0,
          &saturated);
+   // report the applied gain and output level
+   if (result == 0 && samples > 0 && measure) {
+      double output = Energy(frame, samples);
+      jfloat values[LEVEL_COUNT];
+      values[LEVEL_GAIN] = (jfloat)(10 * log10(output / input));
+      values[LEVEL_RMS] = (jfloat)(10 * log10(
+         output / samples / (32768.0 * 32768.0)));
+      values[LEVEL_SATURATED] = saturated ? 1 : 0;
+      if (levels != NULL)
+         env->SetFloatArrayRegion(levels, 0, LEVEL_COUNT, values);
+      if (Trace_IsEnabled()) {
+         if (g_trace_levels == TRACE_UNREGISTERED)
+            g_trace_levels = Trace_Register(
+               "agc",
+               "agc: gain %.1fdB rms %.1fdBFS saturated %.0f",
+               "gain,rms,saturated");
+         Trace_Record(
+            g_trace_levels,
+            values[LEVEL_GAIN],
+            values[LEVEL_RMS],
+            values[LEVEL_SATURATED],
+            0);
+      }
+   }
    return result;
 }
+/*-----------< FUNCTION: Energy >--------------------------------------------
+// Purpose:    computes the energy of a frame
+// Parameters: frame  - sample frame
+//             length - number of samples
+// Returns:    the sum of squared samples, floored at MIN_ENERGY
+---------------------------------------------------------------------------*/
+double Energy(const int16_t* frame, int length) {
+   int64_t sum = 0;
+   for (int i = 0; i < length; i++)
+      sum += (int32_t)frame[i] * frame[i];
+   return sum > MIN_ENERGY ? (double)sum : MIN_ENERGY;
+}
@@ -7,19 +7,96 @@
 /*-------------------[       Pre Include Defines       ]-------------------*/
 /*-------------------[      Library Include Files      ]-------------------*/
 #include <jni.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 /*-------------------[      Project Include Files      ]-------------------*/
+#include "ans.h"
+#include "convert.h"
+#include "qmf.h"
+#include "trace.h"
+#include "filter_audio/ns/include/noise_suppression.h"
 #include "filter_audio/ns/include/noise_suppression_x.h"
 /*-------------------[      Macros/Constants/Types     ]-------------------*/
+#define ANS_MAX_DELAY         96          // suppressor delay at 16kHz bands
+#define ANS_INITIAL_POLICY    0           // adaptive starting policy (mild)
+#define ANS_SMOOTHING         0.3f        // frame energy smoothing factor
+#define ANS_MIN_WINDOWS       8           // noise floor minimum windows
+#define ANS_MIN_FRAMES        15          // frames per minimum window
+#define ANS_SPEECH_DECAY      0.9954f     // speech peak decay (2dB/s)
+#define ANS_SPEECH_NOMINAL    1.07e6f     // nominal speech energy (-30dBFS)
+#define ANS_FULL_SCALE        1.07374e9f  // full-scale sample energy
+#define ANS_HYSTERESIS_DB     3.0f        // snr margin for relaxing policy
+#define ANS_ENGAGE_FRAMES     5           // hold before more suppression
+#define ANS_RELEASE_FRAMES    100         // hold before less suppression
+
+// policy transition states
+// . bypass->policy transitions prime the reinitialized suppressor for a
+//   frame, then crossfade from the dry signal over the next frame
+// . policy->bypass transitions crossfade to the dry signal over a frame
+#define ANS_RAMP_NONE         0
+#define ANS_RAMP_PRIME        1
+#define ANS_RAMP_IN           2
+#define ANS_RAMP_OUT          3
+
+// suppressor instance
+// . 8/16kHz frames are processed directly by the suppressor
+// . 32/48kHz frames are split into low/high bands at 32kHz,
+//   which the suppressor processes jointly
+// . adaptive instances track the noise floor and speech level of the
+//   input, and select the least aggressive policy that suits the snr,
+//   bypassing the suppressor entirely in quiet environments
+// . bypassed audio is delayed to match the suppressor's latency, so
+//   that transitions are seamless
+struct AnsContext {
+   int        backend;
+   int        rate;
+   int        length;                     // band length, in samples
+   int        delay;                      // suppressor delay, in samples
+   int        adaptive;                   // nonzero to track the snr
+   int        policy;                     // active policy
+   int        hold;                       // frames a change has been pending
+   int        ramp;                       // transition state (ANS_RAMP_*)
+   int        frames;                     // frames tracked
+   float      energy;                     // smoothed frame energy
+   float      minima[ANS_MIN_WINDOWS];    // windowed energy minima
+   float      noise;                      // noise floor energy estimate
+   float      speech;                     // speech peak energy estimate
+   NsxHandle* nsx;
+   NsHandle*  ns;
+   QmfState   qmf;
+   int16_t    history[2][ANS_MAX_DELAY];  // bypass delay lines (low/high)
+};
 /*-------------------[        Global Variables         ]-------------------*/
 /*-------------------[        Global Prototypes        ]-------------------*/
 /*-------------------[        Module Variables         ]-------------------*/
+// lower snr bounds (dB) of the bypass, mild, medium and aggressive
+// policies, below which very aggressive suppression is used
+static const float g_bounds[] = { 35.0f, 25.0f, 15.0f, 8.0f };
+static int g_trace_policy = TRACE_UNREGISTERED;
 /*-------------------[        Module Prototypes        ]-------------------*/
+static int  InitSuppressor(AnsContext* ans, int policy);
+static int  SetPolicy(AnsContext* ans, int policy);
+static int  ProcessFrame(AnsContext* ans, int16_t* low, int16_t* high);
+static int  ProcessBands(AnsContext* ans, int16_t* low, int16_t* high);
+static void Track(AnsContext* ans, const int16_t* low);
+static void Adapt(AnsContext* ans);
+static int  Classify(float snr);
+static void Delay(int16_t* history, int16_t* band, int length, int delay);
+static void Crossfade(
+   const int16_t* from,
+   const int16_t* to,
+   int16_t*       output,
+   int            length);
 /*-------------------[         Implementation          ]-------------------*/
 /*-----------< FUNCTION: AcousticNoiseSuppressor_create >--------------------
 // Purpose:    creates and configures a new webrtc noise suppressor component
-// Parameters: env  - java environment
-//             self - java this reference
-//             policy - suppressor policy (0..2) in order of aggressiveness
+// Parameters: env        - java environment
+//             self       - java this reference
+//             sampleRate - sample rate, in Hz (8000/16000/32000/48000)
+//             policy     - suppressor policy (0..3) in order of
+//                          aggressiveness
+//             backend    - suppressor implementation (ANS_BACKEND_*)
 // Returns:    pointer to the opaque suppressor instance if successful
 //             null otherwise
 ---------------------------------------------------------------------------*/
@@ -28,22 +105,9 @@ jlong JNICALL Java_io_spokestack_spokestack_webrtc_AcousticNoiseSuppressor_creat
       JNIEnv* env,
       jobject self,
       jint    sampleRate,
-      jint    policy) {
-   // create and initialize the suppressor instance
-   NsxHandle* ans = NULL;
-   int result = WebRtcNsx_Create(&ans);
-   if (result == 0) {
-      result = WebRtcNsx_Init(ans, sampleRate);
-      // configure the ans instance
-      if (result == 0)
-         result = WebRtcNsx_set_policy(ans, policy);
-      // if something went wrong, cleanup
-      if (result != 0) {
-         WebRtcNsx_Free(ans);
-         ans = NULL;
-      }
-   }
-   return (jlong)ans;
+      jint    policy,
+      jint    backend) {
+   return (jlong)Ans_Create(sampleRate, policy, backend);
 }
 /*-----------< FUNCTION: AcousticNoiseSuppressor_destroy >-------------------
 // Purpose:    releases ans resources
@@ -57,10 +121,10 @@ void JNICALL Java_io_spokestack_spokestack_webrtc_AcousticNoiseSuppressor_destro
       JNIEnv* env,
       jobject self,
       jlong   ans) {
-   WebRtcNsx_Free((NsxHandle*)ans);
+   Ans_Destroy((AnsContext*)ans);
 }
 /*-----------< FUNCTION: AcousticNoiseSuppressor_process >-------------------
-// Purpose:    processes an audio frame, suppressing noise
+// Purpose:    processes a 10ms audio frame, suppressing noise
 // Parameters: env    - java environment
 //             self   - java this reference
 //             ans    - suppressor handle returned by create()
@@ -78,5 +142,398 @@ jint JNICALL Java_io_spokestack_spokestack_webrtc_AcousticNoiseSuppressor_proces
       jint    offset) {
    int16_t* frame = (int16_t*)env->GetDirectBufferAddress(buffer);
    frame += offset / sizeof(int16_t);
-   return WebRtcNsx_Process((NsxHandle*)ans, frame, NULL, frame, NULL);
+   return Ans_Process((AnsContext*)ans, frame);
+}
+/*-----------< FUNCTION: AcousticNoiseSuppressor_policy >--------------------
+// Purpose:    retrieves the active suppressor policy
+// Parameters: env  - java environment
+//             self - java this reference
+//             ans  - suppressor handle returned by create()
+// Returns:    the policy (0..3), or -1 if suppression is bypassed
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+jint JNICALL Java_io_spokestack_spokestack_webrtc_AcousticNoiseSuppressor_policy(
+      JNIEnv* env,
+      jobject self,
+      jlong   ans) {
+   return Ans_GetPolicy((AnsContext*)ans);
+}
+/*-----------< FUNCTION: AcousticNoiseSuppressor_snr >-----------------------
+// Purpose:    retrieves the estimated signal-to-noise ratio of the input
+// Parameters: env  - java environment
+//             self - java this reference
+//             ans  - suppressor handle returned by create()
+// Returns:    the snr, in dB
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+jfloat JNICALL Java_io_spokestack_spokestack_webrtc_AcousticNoiseSuppressor_snr(
+      JNIEnv* env,
+      jobject self,
+      jlong   ans) {
+   return Ans_GetSnr((AnsContext*)ans);
+}
+/*-----------< FUNCTION: AcousticNoiseSuppressor_noise >---------------------
+// Purpose:    retrieves the estimated noise floor of the input
+// Parameters: env  - java environment
+//             self - java this reference
+//             ans  - suppressor handle returned by create()
+// Returns:    the noise level, in dBFS
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+jfloat JNICALL Java_io_spokestack_spokestack_webrtc_AcousticNoiseSuppressor_noise(
+      JNIEnv* env,
+      jobject self,
+      jlong   ans) {
+   return Ans_GetNoiseLevel((AnsContext*)ans);
+}
+/*-----------< FUNCTION: Ans_Create >----------------------------------------
+// Purpose:    creates and configures a new suppressor instance
+// Parameters: rate    - sample rate, in Hz (8000/16000/32000/48000)
+//             policy  - suppressor policy (0..3) in order of aggressiveness,
+//                       or ANS_POLICY_ADAPTIVE
+//             backend - suppressor implementation (ANS_BACKEND_*)
+// Returns:    pointer to the suppressor instance if successful
+//             null otherwise
+---------------------------------------------------------------------------*/
+AnsContext* Ans_Create(int rate, int policy, int backend) {
+   AnsContext* ans = (AnsContext*)calloc(1, sizeof(AnsContext));
+   if (ans == NULL)
+      return NULL;
+   ans->backend = backend;
+   ans->rate = rate;
+   ans->length = rate < 32000 ? rate / 100 : QMF_BAND_LENGTH;
+   // the suppressor's output lags its input by its analysis window
+   // (128/256 samples) less its block length
+   ans->delay = (ans->length == 80 ? 128 : 256) - ans->length;
+   ans->adaptive = policy == ANS_POLICY_ADAPTIVE;
+   ans->policy = ans->adaptive ? ANS_INITIAL_POLICY : policy;
+   // create and initialize the suppressor instance
+   int result = -1;
+   if (backend == ANS_BACKEND_FIXED)
+      result = WebRtcNsx_Create(&ans->nsx);
+   else if (backend == ANS_BACKEND_FLOAT)
+      result = WebRtcNs_Create(&ans->ns);
+   if (result == 0)
+      result = InitSuppressor(ans, ans->policy);
+   // configure the band splitter
+   if (result == 0 && rate >= 32000)
+      result = Qmf_Init(&ans->qmf, rate);
+   // if something went wrong, cleanup
+   if (result != 0) {
+      Ans_Destroy(ans);
+      ans = NULL;
+   }
+   return ans;
+}
+/*-----------< FUNCTION: Ans_Destroy >---------------------------------------
+// Purpose:    releases a suppressor instance
+// Parameters: ans - suppressor instance to release
+// Returns:    none
+---------------------------------------------------------------------------*/
+void Ans_Destroy(AnsContext* ans) {
+   if (ans != NULL) {
+      if (ans->nsx != NULL)
+         WebRtcNsx_Free(ans->nsx);
+      if (ans->ns != NULL)
+         WebRtcNs_Free(ans->ns);
+      free(ans);
+   }
+}
+/*-----------< FUNCTION: Ans_Process >---------------------------------------
+// Purpose:    suppresses noise in a 10ms audio frame, in place
+// Parameters: ans   - suppressor instance
+//             frame - sample frame (rate / 100 16-bit samples)
+// Returns:    0 if successful
+//             -1 on error
+---------------------------------------------------------------------------*/
+int Ans_Process(AnsContext* ans, int16_t* frame) {
+   if (ans->rate < 32000)
+      return ProcessFrame(ans, frame, NULL);
+   // split the frame into bands, suppress, and merge back in place
+   // bands are split even when bypassed, to keep the filters primed
+   int16_t low[QMF_BAND_LENGTH];
+   int16_t high[QMF_BAND_LENGTH];
+   Qmf_Analyze(&ans->qmf, frame, low, high);
+   int result = ProcessFrame(ans, low, high);
+   if (result == 0)
+      Qmf_Synthesize(&ans->qmf, low, high, frame);
+   return result;
+}
+/*-----------< FUNCTION: Ans_GetPolicy >-------------------------------------
+// Purpose:    retrieves the active suppressor policy
+// Parameters: ans - suppressor instance
+// Returns:    the policy (0..3), or ANS_POLICY_BYPASS
+---------------------------------------------------------------------------*/
+int Ans_GetPolicy(const AnsContext* ans) {
+   return ans->policy;
+}
+/*-----------< FUNCTION: Ans_GetSnr >----------------------------------------
+// Purpose:    retrieves the estimated signal-to-noise ratio of the input
+// Parameters: ans - suppressor instance
+// Returns:    the snr, in dB
+//             speech quieter than a nominal level is assumed to be at
+//             that level, so that silence in a quiet room is high-snr
+---------------------------------------------------------------------------*/
+float Ans_GetSnr(const AnsContext* ans) {
+   if (ans->frames == 0)
+      return 0;
+   float speech = ans->speech > ANS_SPEECH_NOMINAL
+      ? ans->speech
+      : ANS_SPEECH_NOMINAL;
+   return 10 * log10f(speech / ans->noise);
+}
+/*-----------< FUNCTION: Ans_GetNoiseLevel >---------------------------------
+// Purpose:    retrieves the estimated noise floor of the input
+// Parameters: ans - suppressor instance
+// Returns:    the noise level, in dBFS
+---------------------------------------------------------------------------*/
+float Ans_GetNoiseLevel(const AnsContext* ans) {
+   if (ans->frames == 0)
+      return 0;
+   return 10 * log10f(ans->noise / ANS_FULL_SCALE);
+}
+/*-----------< FUNCTION: InitSuppressor >------------------------------------
+// Purpose:    (re)initializes the suppressor, discarding its estimates
+// Parameters: ans    - suppressor instance
+//             policy - suppressor policy (0..3)
+// Returns:    0 if successful
+//             -1 on error
+---------------------------------------------------------------------------*/
+int InitSuppressor(AnsContext* ans, int policy) {
+   // the suppressor runs at 32kHz (split bands) for full-band audio
+   int nsRate = ans->rate > 32000 ? 32000 : ans->rate;
+   int result = -1;
+   if (ans->backend == ANS_BACKEND_FIXED) {
+      result = WebRtcNsx_Init(ans->nsx, nsRate);
+      if (result == 0)
+         result = WebRtcNsx_set_policy(ans->nsx, policy);
+   } else if (ans->backend == ANS_BACKEND_FLOAT) {
+      result = WebRtcNs_Init(ans->ns, nsRate);
+      if (result == 0)
+         result = WebRtcNs_set_policy(ans->ns, policy);
+   }
+   return result;
+}
+/*-----------< FUNCTION: SetPolicy >-----------------------------------------
+// Purpose:    switches the active policy of an adaptive suppressor
+// Parameters: ans    - suppressor instance
+//             policy - new suppressor policy (0..3 or ANS_POLICY_BYPASS)
+// Returns:    0 if successful
+//             -1 on error
+---------------------------------------------------------------------------*/
+int SetPolicy(AnsContext* ans, int policy) {
+   int previous = ans->policy;
+   ans->policy = policy;
+   if (Trace_IsEnabled()) {
+      if (g_trace_policy == TRACE_UNREGISTERED)
+         g_trace_policy = Trace_Register(
+            "ans",
+            "ans: policy %.0f -> %.0f snr %.1fdB",
+            NULL);
+      Trace_Record(g_trace_policy, previous, policy, Ans_GetSnr(ans), 0);
+   }
+   if (policy == ANS_POLICY_BYPASS) {
+      ans->ramp = ANS_RAMP_OUT;
+      return 0;
+   }
+   // the suppressor's estimates are stale after a bypass, so restart it
+   if (previous == ANS_POLICY_BYPASS) {
+      ans->ramp = ANS_RAMP_PRIME;
+      return InitSuppressor(ans, policy);
+   }
+   if (ans->backend == ANS_BACKEND_FIXED)
+      return WebRtcNsx_set_policy(ans->nsx, policy);
+   return WebRtcNs_set_policy(ans->ns, policy);
+}
+/*-----------< FUNCTION: ProcessFrame >--------------------------------------
+// Purpose:    tracks the input snr and suppresses a 10ms frame, adapting
+//             the policy if configured
+// Parameters: ans  - suppressor instance
+//             low  - low band (or full band below 32kHz), in place
+//             high - high band, in place (null below 32kHz)
+// Returns:    0 if successful
+//             -1 on error
+---------------------------------------------------------------------------*/
+int ProcessFrame(AnsContext* ans, int16_t* low, int16_t* high) {
+   Track(ans, low);
+   if (!ans->adaptive)
+      return ProcessBands(ans, low, high);
+   Adapt(ans);
+   // delay the dry signal to match the suppressor
+   int16_t dryLow[QMF_BAND_LENGTH];
+   int16_t dryHigh[QMF_BAND_LENGTH];
+   memcpy(dryLow, low, ans->length * sizeof(int16_t));
+   Delay(ans->history[0], dryLow, ans->length, ans->delay);
+   if (high != NULL) {
+      memcpy(dryHigh, high, ans->length * sizeof(int16_t));
+      Delay(ans->history[1], dryHigh, ans->length, ans->delay);
+   }
+   // bypass the suppressor entirely once transitions have completed
+   if (ans->policy == ANS_POLICY_BYPASS && ans->ramp == ANS_RAMP_NONE) {
+      memcpy(low, dryLow, ans->length * sizeof(int16_t));
+      if (high != NULL)
+         memcpy(high, dryHigh, ans->length * sizeof(int16_t));
+      return 0;
+   }
+   int result = ProcessBands(ans, low, high);
+   if (result != 0)
+      return result;
+   switch (ans->ramp) {
+      case ANS_RAMP_PRIME:
+         memcpy(low, dryLow, ans->length * sizeof(int16_t));
+         if (high != NULL)
+            memcpy(high, dryHigh, ans->length * sizeof(int16_t));
+         ans->ramp = ANS_RAMP_IN;
+         break;
+      case ANS_RAMP_IN:
+         Crossfade(dryLow, low, low, ans->length);
+         if (high != NULL)
+            Crossfade(dryHigh, high, high, ans->length);
+         ans->ramp = ANS_RAMP_NONE;
+         break;
+      case ANS_RAMP_OUT:
+         Crossfade(low, dryLow, low, ans->length);
+         if (high != NULL)
+            Crossfade(high, dryHigh, high, ans->length);
+         ans->ramp = ANS_RAMP_NONE;
+         break;
+   }
+   return 0;
+}
+/*-----------< FUNCTION: ProcessBands >--------------------------------------
+// Purpose:    runs the configured suppressor over a 10ms frame
+// Parameters: ans  - suppressor instance
+//             low  - low band (or full band below 32kHz), in place
+//             high - high band, in place (null below 32kHz)
+// Returns:    0 if successful
+//             -1 on error
+---------------------------------------------------------------------------*/
+int ProcessBands(AnsContext* ans, int16_t* low, int16_t* high) {
+   if (ans->backend == ANS_BACKEND_FIXED)
+      return WebRtcNsx_Process(ans->nsx, low, high, low, high);
+   // the float suppressor operates on 16-bit scaled floats,
+   // converted in vectorizable loops
+   int length = ans->rate < 32000 ? ans->rate / 100 : QMF_BAND_LENGTH;
+   float lowIn[QMF_BAND_LENGTH];
+   float lowOut[QMF_BAND_LENGTH];
+   float highIn[QMF_BAND_LENGTH];
+   float highOut[QMF_BAND_LENGTH];
+   S16ToFloat(low, lowIn, length);
+   if (high != NULL)
+      S16ToFloat(high, highIn, length);
+   int result = WebRtcNs_Process(
+      ans->ns,
+      lowIn,
+      high != NULL ? highIn : NULL,
+      lowOut,
+      high != NULL ? highOut : NULL);
+   if (result == 0) {
+      FloatToS16(lowOut, low, length);
+      if (high != NULL)
+         FloatToS16(highOut, high, length);
+   }
+   return result;
+}
+/*-----------< FUNCTION: Track >--------------------------------------------
+// Purpose:    updates the noise floor and speech level estimates
+// Parameters: ans - suppressor instance
+//             low - low band (or full band below 32kHz)
+// Returns:    none
+---------------------------------------------------------------------------*/
+void Track(AnsContext* ans, const int16_t* low) {
+   float energy = 0;
+   for (int i = 0; i < ans->length; i++)
+      energy += (float)low[i] * low[i];
+   energy = energy / ans->length + 1;
+   // the noise floor is the minimum smoothed energy over the last
+   // ANS_MIN_WINDOWS * ANS_MIN_FRAMES frames (minimum statistics),
+   // so it follows dips immediately and rises within that period
+   int window = (ans->frames / ANS_MIN_FRAMES) % ANS_MIN_WINDOWS;
+   if (ans->frames == 0) {
+      ans->energy = energy;
+      for (int i = 0; i < ANS_MIN_WINDOWS; i++)
+         ans->minima[i] = energy;
+   } else {
+      ans->energy += (energy - ans->energy) * ANS_SMOOTHING;
+   }
+   if (ans->frames % ANS_MIN_FRAMES == 0)
+      ans->minima[window] = ans->energy;
+   else
+      ans->minima[window] = fminf(ans->minima[window], ans->energy);
+   ans->noise = ans->minima[0];
+   for (int i = 1; i < ANS_MIN_WINDOWS; i++)
+      ans->noise = fminf(ans->noise, ans->minima[i]);
+   ans->frames++;
+   // the speech level holds peaks and decays slowly
+   ans->speech = fmaxf(energy, ans->speech * ANS_SPEECH_DECAY);
+}
+/*-----------< FUNCTION: Adapt >--------------------------------------------
+// Purpose:    steps the policy of an adaptive suppressor toward the snr
+// Parameters: ans - suppressor instance
+// Returns:    none
+---------------------------------------------------------------------------*/
+void Adapt(AnsContext* ans) {
+   if (ans->ramp != ANS_RAMP_NONE)
+      return;
+   // relaxing the policy requires a margin above the snr bound,
+   // and must persist much longer than an increase
+   float snr = Ans_GetSnr(ans);
+   int target = Classify(snr);
+   if (target < ans->policy)
+      target = Classify(snr - ANS_HYSTERESIS_DB);
+   if (target == ans->policy) {
+      ans->hold = 0;
+      return;
+   }
+   int hold = target > ans->policy ? ANS_ENGAGE_FRAMES : ANS_RELEASE_FRAMES;
+   if (++ans->hold < hold)
+      return;
+   // step one policy at a time
+   ans->hold = 0;
+   SetPolicy(ans, ans->policy + (target > ans->policy ? 1 : -1));
+}
+/*-----------< FUNCTION: Classify >-----------------------------------------
+// Purpose:    maps an snr to the least aggressive suitable policy
+// Parameters: snr - signal-to-noise ratio, in dB
+// Returns:    the policy (0..3), or ANS_POLICY_BYPASS
+---------------------------------------------------------------------------*/
+int Classify(float snr) {
+   int count = sizeof(g_bounds) / sizeof(g_bounds[0]);
+   for (int i = 0; i < count; i++)
+      if (snr >= g_bounds[i])
+         return ANS_POLICY_BYPASS + i;
+   return ANS_POLICY_BYPASS + count;
+}
+/*-----------< FUNCTION: Delay >--------------------------------------------
+// Purpose:    delays a band in place through a delay line
+// Parameters: history - delay line (delay samples)
+//             band    - band samples, in place
+//             length  - number of band samples
+//             delay   - delay, in samples (<= length)
+// Returns:    none
+---------------------------------------------------------------------------*/
+void Delay(int16_t* history, int16_t* band, int length, int delay) {
+   int16_t tail[ANS_MAX_DELAY];
+   memcpy(tail, band + length - delay, delay * sizeof(int16_t));
+   memmove(band + delay, band, (length - delay) * sizeof(int16_t));
+   memcpy(band, history, delay * sizeof(int16_t));
+   memcpy(history, tail, delay * sizeof(int16_t));
+}
+/*-----------< FUNCTION: Crossfade >----------------------------------------
+// Purpose:    linearly crossfades between two signals over a band
+// Parameters: from   - signal at the start of the band
+//             to     - signal at the end of the band
+//             output - crossfaded output (may alias either input)
+//             length - number of band samples
+// Returns:    none
+---------------------------------------------------------------------------*/
+void Crossfade(
+      const int16_t* from,
+      const int16_t* to,
+      int16_t*       output,
+      int            length) {
+   for (int i = 0; i < length; i++) {
+      float gain = (i + 0.5f) / length;
+      output[i] = (int16_t)(from[i] + gain * (to[i] - from[i]));
+   }
 }
@@ -0,0 +1,32 @@
+/****************************************************************************
+ *
+ * MODULE:  ans.h
+ * PURPOSE: webrtc acoustic noise suppression (ans) interface
+ *
+ ***************************************************************************/
+#ifndef __ANS_H
+#define __ANS_H
+/*-------------------[       Pre Include Defines       ]-------------------*/
+/*-------------------[      Library Include Files      ]-------------------*/
+#include <stdint.h>
+/*-------------------[      Project Include Files      ]-------------------*/
+/*-------------------[      Macros/Constants/Types     ]-------------------*/
+#define ANS_BACKEND_FIXED  0     // fixed-point suppressor (nsx)
+#define ANS_BACKEND_FLOAT  1     // floating-point suppressor (ns)
+
+#define ANS_POLICY_BYPASS   -1   // suppression disabled (adaptive only)
+#define ANS_POLICY_ADAPTIVE -2   // policy tracks the input snr
+
+typedef struct AnsContext AnsContext;
+/*-------------------[        Global Variables         ]-------------------*/
+/*-------------------[        Global Prototypes        ]-------------------*/
+AnsContext* Ans_Create(int rate, int policy, int backend);
+void        Ans_Destroy(AnsContext* ans);
+int         Ans_Process(AnsContext* ans, int16_t* frame);
+int         Ans_GetPolicy(const AnsContext* ans);
+float       Ans_GetSnr(const AnsContext* ans);
+float       Ans_GetNoiseLevel(const AnsContext* ans);
+/*-------------------[        Module Variables         ]-------------------*/
+/*-------------------[        Module Prototypes        ]-------------------*/
+/*-------------------[         Implementation          ]-------------------*/
+#endif
@@ -0,0 +1,199 @@
+/****************************************************************************
+ *
+ * MODULE:  ans_bench.cpp
+ * PURPOSE: host benchmark comparing the ans suppressor backends
+ *
+ ***************************************************************************/
+/*-------------------[       Pre Include Defines       ]-------------------*/
+/*-------------------[      Library Include Files      ]-------------------*/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+/*-------------------[      Project Include Files      ]-------------------*/
+#include "ans.h"
+/*-------------------[      Macros/Constants/Types     ]-------------------*/
+#define SIGNAL_SECONDS     30       // length of the synthetic signal
+#define INPUT_SNR_DB       5.0      // speech-to-noise ratio of the input
+#define MAX_DELAY_MS       20       // maximum suppressor alignment delay
+#define POLICY             1        // medium suppression
+/*-------------------[        Global Variables         ]-------------------*/
+/*-------------------[        Global Prototypes        ]-------------------*/
+/*-------------------[        Module Variables         ]-------------------*/
+static uint32_t g_seed = 42;
+/*-------------------[        Module Prototypes        ]-------------------*/
+static void Synthesize(int rate, int length, float* clean, int16_t* noisy);
+static double Benchmark(
+   int            rate,
+   int            backend,
+   int            length,
+   const int16_t* noisy,
+   int16_t*       output);
+static double MeasureSnr(
+   int            rate,
+   int            length,
+   const float*   clean,
+   const int16_t* output);
+static double Noise();
+static double Now();
+/*-------------------[         Implementation          ]-------------------*/
+/*-----------< FUNCTION: main >----------------------------------------------
+// Purpose:    benchmark entry point
+// Parameters: none
+// Returns:    0 if successful
+//             1 on error
+---------------------------------------------------------------------------*/
+int main() {
+   static const int rates[] = { 8000, 16000, 32000, 48000 };
+   static const char* names[] = { "fixed", "float" };
+   printf("%-6s %-6s %12s %10s %10s\n",
+      "rate", "ans", "us/frame", "snr-in", "snr-out");
+   for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+      int rate = rates[r];
+      int length = rate * SIGNAL_SECONDS;
+      float* clean = (float*)malloc(length * sizeof(float));
+      int16_t* noisy = (int16_t*)malloc(length * sizeof(int16_t));
+      int16_t* output = (int16_t*)malloc(length * sizeof(int16_t));
+      Synthesize(rate, length, clean, noisy);
+      double input = MeasureSnr(rate, length, clean, noisy);
+      for (int backend = ANS_BACKEND_FIXED;
+           backend <= ANS_BACKEND_FLOAT;
+           backend++) {
+         double elapsed = Benchmark(rate, backend, length, noisy, output);
+         if (elapsed < 0) {
+            fprintf(stderr, "failed to run %s at %d\n", names[backend], rate);
+            return 1;
+         }
+         printf("%-6d %-6s %12.2f %10.2f %10.2f\n",
+            rate,
+            names[backend],
+            elapsed * 1e6 / (length / (rate / 100)),
+            input,
+            MeasureSnr(rate, length, clean, output));
+      }
+      free(output);
+      free(noisy);
+      free(clean);
+   }
+   return 0;
+}
+/*-----------< FUNCTION: Synthesize >----------------------------------------
+// Purpose:    generates a speech-like signal and its noisy version
+// Parameters: rate   - sample rate, in Hz
+//             length - number of samples to generate
+//             clean  - clean signal output
+//             noisy  - clean signal + white noise output
+// Returns:    none
+---------------------------------------------------------------------------*/
+void Synthesize(int rate, int length, float* clean, int16_t* noisy) {
+   // voiced bursts (400ms on, 300ms off) of a harmonic series
+   // with a slowly varying fundamental
+   double phase = 0;
+   double power = 0;
+   for (int i = 0; i < length; i++) {
+      double t = (double)i / rate;
+      double f0 = 140 + 30 * sin(2 * M_PI * 0.7 * t);
+      phase += 2 * M_PI * f0 / rate;
+      double burst = fmod(t, 0.7) < 0.4 ? sin(M_PI * fmod(t, 0.7) / 0.4) : 0;
+      double sample = 0;
+      for (int h = 1; h * f0 < rate / 2 && h <= 40; h++)
+         sample += sin(h * phase) / h;
+      clean[i] = (float)(2000 * burst * sample);
+      power += clean[i] * clean[i];
+   }
+   // add white noise at the configured snr
+   double scale = sqrt(power / length / pow(10, INPUT_SNR_DB / 10));
+   for (int i = 0; i < length; i++) {
+      double sample = clean[i] + scale * Noise();
+      sample = sample > 32767 ? 32767 : sample < -32768 ? -32768 : sample;
+      noisy[i] = (int16_t)sample;
+   }
+}
+/*-----------< FUNCTION: Benchmark >-----------------------------------------
+// Purpose:    runs a suppressor backend over a signal
+// Parameters: rate    - sample rate, in Hz
+//             backend - suppressor implementation (ANS_BACKEND_*)
+//             length  - number of samples
+//             noisy   - input signal
+//             output  - suppressed signal output
+// Returns:    total processing time, in seconds
+//             -1 on error
+---------------------------------------------------------------------------*/
+double Benchmark(
+      int            rate,
+      int            backend,
+      int            length,
+      const int16_t* noisy,
+      int16_t*       output) {
+   AnsContext* ans = Ans_Create(rate, POLICY, backend);
+   if (ans == NULL)
+      return -1;
+   for (int i = 0; i < length; i++)
+      output[i] = noisy[i];
+   int frameSize = rate / 100;
+   double start = Now();
+   for (int offset = 0; offset + frameSize <= length; offset += frameSize) {
+      if (Ans_Process(ans, output + offset) != 0) {
+         Ans_Destroy(ans);
+         return -1;
+      }
+   }
+   double elapsed = Now() - start;
+   Ans_Destroy(ans);
+   return elapsed;
+}
+/*-----------< FUNCTION: MeasureSnr >----------------------------------------
+// Purpose:    computes the snr of a signal against the clean reference,
+//             aligned to compensate for the suppressor's delay
+// Parameters: rate   - sample rate, in Hz
+//             length - number of samples
+//             clean  - clean reference signal
+//             output - signal to measure
+// Returns:    the best aligned snr, in dB
+---------------------------------------------------------------------------*/
+double MeasureSnr(
+      int            rate,
+      int            length,
+      const float*   clean,
+      const int16_t* output) {
+   int maxDelay = rate * MAX_DELAY_MS / 1000;
+   double best = -INFINITY;
+   for (int delay = 0; delay <= maxDelay; delay++) {
+      double signal = 0;
+      double error = 0;
+      for (int i = maxDelay; i < length; i++) {
+         double x = clean[i - delay];
+         double e = output[i] - x;
+         signal += x * x;
+         error += e * e;
+      }
+      double snr = 10 * log10(signal / fmax(error, 1e-9));
+      if (snr > best)
+         best = snr;
+   }
+   return best;
+}
+/*-----------< FUNCTION: Noise >---------------------------------------------
+// Purpose:    generates a deterministic unit-variance white noise sample
+// Parameters: none
+// Returns:    the noise sample
+---------------------------------------------------------------------------*/
+double Noise() {
+   // sum of 12 uniform samples (irwin-hall approximation)
+   double sum = 0;
+   for (int i = 0; i < 12; i++) {
+      g_seed = g_seed * 1664525 + 1013904223;
+      sum += (double)g_seed / 4294967296.0;
+   }
+   return sum - 6;
+}
+/*-----------< FUNCTION: Now >-----------------------------------------------
+// Purpose:    reads the process cpu clock
+// Parameters: none
+// Returns:    the current cpu time, in seconds
+---------------------------------------------------------------------------*/
+double Now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
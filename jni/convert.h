@@ -0,0 +1,56 @@
+/****************************************************************************
+ *
+ * MODULE:  convert.h
+ * PURPOSE: 16-bit/float sample conversion for the float webrtc components
+ *
+ ***************************************************************************/
+#ifndef __CONVERT_H
+#define __CONVERT_H
+/*-------------------[       Pre Include Defines       ]-------------------*/
+/*-------------------[      Library Include Files      ]-------------------*/
+#include <stdint.h>
+/*-------------------[      Project Include Files      ]-------------------*/
+/*-------------------[      Macros/Constants/Types     ]-------------------*/
+/*-------------------[        Global Variables         ]-------------------*/
+/*-------------------[        Global Prototypes        ]-------------------*/
+/*-------------------[        Module Variables         ]-------------------*/
+/*-------------------[        Module Prototypes        ]-------------------*/
+/*-------------------[         Implementation          ]-------------------*/
+/*-----------< FUNCTION: S16ToFloat >----------------------------------------
+// Purpose:    converts 16-bit samples to 16-bit scaled floats
+// Parameters: input  - 16-bit samples
+//             output - float samples
+//             length - number of samples to convert
+// Returns:    none
+---------------------------------------------------------------------------*/
+static inline void S16ToFloat(
+      const int16_t* input,
+      float*         output,
+      int            length) {
+   for (int i = 0; i < length; i++)
+      output[i] = input[i];
+}
+/*-----------< FUNCTION: FloatToS16 >----------------------------------------
+// Purpose:    converts 16-bit scaled floats to saturated 16-bit samples,
+//             rounding to nearest (as webrtc's FloatS16ToS16 does), so that
+//             the conversion adds no dc bias
+// Parameters: input  - float samples
+//             output - 16-bit samples
+//             length - number of samples to convert
+// Returns:    none
+---------------------------------------------------------------------------*/
+static inline void FloatToS16(
+      const float* input,
+      int16_t*     output,
+      int          length) {
+   for (int i = 0; i < length; i++) {
+      float sample = input[i];
+      sample = sample > 32767.0f ? 32767.0f : sample;
+      sample = sample < -32768.0f ? -32768.0f : sample;
+      // round half away from zero; the selects keep the loop vectorizable,
+      // and the clamped range still truncates into int16 range
+      sample += sample > 0 ? 0.5f : -0.5f;
+      output[i] = (int16_t)sample;
+   }
+}
+#endif
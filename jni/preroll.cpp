@@ -0,0 +1,182 @@
+/****************************************************************************
+ *
+ * MODULE:  preroll.cpp
+ * PURPOSE: pre-roll audio history ring jni wrapper
+ *
+ ***************************************************************************/
+/*-------------------[       Pre Include Defines       ]-------------------*/
+/*-------------------[      Library Include Files      ]-------------------*/
+#include <jni.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+/*-------------------[      Project Include Files      ]-------------------*/
+/*-------------------[      Macros/Constants/Types     ]-------------------*/
+#define MULAW_BIAS   0x84     // g.711 mu-law encoding bias
+#define MULAW_CLIP   32635    // g.711 mu-law maximum magnitude
+
+// history ring
+// . samples are indexed by their absolute position in the stream, so
+//   the sample at position p is stored at p % capacity
+// . compressed rings store 8-bit g.711 mu-law samples, halving the
+//   memory required for a given history length
+struct PreRollContext {
+   int      capacity;      // ring capacity, in samples
+   int      compress;      // nonzero to store mu-law samples
+   int64_t  position;      // position of the next sample to write
+   int16_t* linear;        // uncompressed sample ring
+   uint8_t* mulaw;         // compressed sample ring
+};
+/*-------------------[        Global Variables         ]-------------------*/
+/*-------------------[        Global Prototypes        ]-------------------*/
+/*-------------------[        Module Variables         ]-------------------*/
+/*-------------------[        Module Prototypes        ]-------------------*/
+static uint8_t MuLawEncode(int16_t sample);
+static int16_t MuLawDecode(uint8_t sample);
+/*-------------------[         Implementation          ]-------------------*/
+/*-----------< FUNCTION: PreRoll_create >------------------------------------
+// Purpose:    creates a new pre-roll history ring
+// Parameters: env      - java environment
+//             self     - java this reference
+//             capacity - ring capacity, in samples
+//             compress - true to store mu-law compressed samples
+// Returns:    pointer to the opaque ring instance if successful
+//             null otherwise
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+jlong JNICALL Java_io_spokestack_spokestack_PreRoll_create(
+      JNIEnv*  env,
+      jobject  self,
+      jint     capacity,
+      jboolean compress) {
+   PreRollContext* ring = (PreRollContext*)calloc(1, sizeof(PreRollContext));
+   if (ring == NULL)
+      return 0;
+   ring->capacity = capacity;
+   ring->compress = compress ? 1 : 0;
+   if (ring->compress)
+      ring->mulaw = (uint8_t*)calloc(capacity, sizeof(uint8_t));
+   else
+      ring->linear = (int16_t*)calloc(capacity, sizeof(int16_t));
+   // if something went wrong, clean up
+   if (ring->mulaw == NULL && ring->linear == NULL) {
+      free(ring);
+      ring = NULL;
+   }
+   return (jlong)ring;
+}
+/*-----------< FUNCTION: PreRoll_destroy >-----------------------------------
+// Purpose:    releases ring resources
+// Parameters: env     - java environment
+//             self    - java this reference
+//             preRoll - ring handle returned by create()
+// Returns:    none
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+void JNICALL Java_io_spokestack_spokestack_PreRoll_destroy(
+      JNIEnv* env,
+      jobject self,
+      jlong   preRoll) {
+   PreRollContext* ring = (PreRollContext*)preRoll;
+   if (ring != NULL) {
+      free(ring->linear);
+      free(ring->mulaw);
+      free(ring);
+   }
+}
+/*-----------< FUNCTION: PreRoll_write >-------------------------------------
+// Purpose:    appends samples to the ring, overwriting the oldest samples
+// Parameters: env     - java environment
+//             self    - java this reference
+//             preRoll - ring handle returned by create()
+//             buffer  - sample buffer (16-bit samples)
+//             length  - size, in bytes, of the samples to write
+// Returns:    none
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+void JNICALL Java_io_spokestack_spokestack_PreRoll_write(
+      JNIEnv* env,
+      jobject self,
+      jlong   preRoll,
+      jobject buffer,
+      jint    length) {
+   PreRollContext* ring = (PreRollContext*)preRoll;
+   const int16_t* samples = (const int16_t*)env->GetDirectBufferAddress(buffer);
+   int count = length / 2;
+   int index = (int)(ring->position % ring->capacity);
+   for (int i = 0; i < count; i++) {
+      if (ring->compress)
+         ring->mulaw[index] = MuLawEncode(samples[i]);
+      else
+         ring->linear[index] = samples[i];
+      if (++index == ring->capacity)
+         index = 0;
+   }
+   ring->position += count;
+}
+/*-----------< FUNCTION: PreRoll_read >--------------------------------------
+// Purpose:    copies samples out of the ring, starting at a position
+// Parameters: env     - java environment
+//             self    - java this reference
+//             preRoll - ring handle returned by create()
+//             from    - position of the first sample to read, which must
+//                       still be held by the ring
+//             buffer  - sample buffer (16-bit samples)
+//             length  - size, in bytes, of the buffer
+// Returns:    the number of samples read
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+jint JNICALL Java_io_spokestack_spokestack_PreRoll_read(
+      JNIEnv* env,
+      jobject self,
+      jlong   preRoll,
+      jlong   from,
+      jobject buffer,
+      jint    length) {
+   PreRollContext* ring = (PreRollContext*)preRoll;
+   int16_t* samples = (int16_t*)env->GetDirectBufferAddress(buffer);
+   if (from < ring->position - ring->capacity || from >= ring->position)
+      return 0;
+   int64_t available = ring->position - from;
+   int count = length / 2 < available ? length / 2 : (int)available;
+   int index = (int)(from % ring->capacity);
+   for (int i = 0; i < count; i++) {
+      if (ring->compress)
+         samples[i] = MuLawDecode(ring->mulaw[index]);
+      else
+         samples[i] = ring->linear[index];
+      if (++index == ring->capacity)
+         index = 0;
+   }
+   return count;
+}
+/*-----------< FUNCTION: MuLawEncode >---------------------------------------
+// Purpose:    compresses a sample using g.711 mu-law
+// Parameters: sample - 16-bit linear sample
+// Returns:    the 8-bit mu-law sample
+---------------------------------------------------------------------------*/
+uint8_t MuLawEncode(int16_t sample) {
+   int sign = (sample >> 8) & 0x80;
+   int magnitude = sign ? -(int)sample : sample;
+   if (magnitude > MULAW_CLIP)
+      magnitude = MULAW_CLIP;
+   magnitude += MULAW_BIAS;
+   int exponent = 7;
+   for (int mask = 0x4000; (magnitude & mask) == 0 && exponent > 0; mask >>= 1)
+      exponent--;
+   int mantissa = (magnitude >> (exponent + 3)) & 0x0F;
+   return (uint8_t)~(sign | (exponent << 4) | mantissa);
+}
+/*-----------< FUNCTION: MuLawDecode >---------------------------------------
+// Purpose:    expands a g.711 mu-law sample
+// Parameters: sample - 8-bit mu-law sample
+// Returns:    the 16-bit linear sample
+---------------------------------------------------------------------------*/
+int16_t MuLawDecode(uint8_t sample) {
+   sample = ~sample;
+   int exponent = (sample >> 4) & 0x07;
+   int mantissa = sample & 0x0F;
+   int magnitude = ((mantissa << 3) + MULAW_BIAS) << exponent;
+   magnitude -= MULAW_BIAS;
+   return (int16_t)(sample & 0x80 ? -magnitude : magnitude);
+}
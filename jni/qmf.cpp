@@ -0,0 +1,195 @@
+/****************************************************************************
+ *
+ * MODULE:  qmf.cpp
+ * PURPOSE: full-band qmf band splitting for the webrtc audio components
+ *
+ ***************************************************************************/
+/*-------------------[       Pre Include Defines       ]-------------------*/
+/*-------------------[      Library Include Files      ]-------------------*/
+#include <string.h>
+/*-------------------[      Project Include Files      ]-------------------*/
+#include "qmf.h"
+#include "filter_audio/other/signal_processing_library.h"
+/*-------------------[      Macros/Constants/Types     ]-------------------*/
+/*-------------------[        Global Variables         ]-------------------*/
+/*-------------------[        Global Prototypes        ]-------------------*/
+/*-------------------[        Module Variables         ]-------------------*/
+// kaiser-windowed sinc lowpass (beta=5.65) designed at the 96kHz
+// intermediate rate, with a 16kHz cutoff and unity dc gain
+static const float kResampleFilter[QMF_FIR_TAPS] = {
+   -6.85294257e-05f, -1.90572305e-04f, -1.26940585e-04f, +1.64000446e-04f,
+   +4.14001502e-04f, +2.56504588e-04f, -3.13104115e-04f, -7.54843723e-04f,
+   -4.50112407e-04f, +5.31864526e-04f, +1.24680785e-03f, +7.25496696e-04f,
+   -8.38953676e-04f, -1.92927175e-03f, -1.10346127e-03f, +1.25641320e-03f,
+   +2.84910172e-03f, +1.60902218e-03f, -1.81107991e-03f, -4.06420293e-03f,
+   -2.27361368e-03f, +2.53732360e-03f, +5.65031408e-03f, +3.13930713e-03f,
+   -3.48229569e-03f, -7.71410311e-03f, -4.26701108e-03f, +4.71624870e-03f,
+   +1.04192958e-02f, +5.75312803e-03f, -6.35394945e-03f, -1.40422589e-02f,
+   -7.76601979e-03f, +8.60312301e-03f, +1.91025435e-02f, +1.06353740e-02f,
+   -1.18890684e-02f, -2.67177938e-02f, -1.51111118e-02f, +1.72432871e-02f,
+   +3.98104354e-02f, +2.33391086e-02f, -2.79636052e-02f, -6.91397225e-02f,
+   -4.48537190e-02f, +6.32251173e-02f, +2.11710243e-01f, +3.18287283e-01f,
+   +3.18287283e-01f, +2.11710243e-01f, +6.32251173e-02f, -4.48537190e-02f,
+   -6.91397225e-02f, -2.79636052e-02f, +2.33391086e-02f, +3.98104354e-02f,
+   +1.72432871e-02f, -1.51111118e-02f, -2.67177938e-02f, -1.18890684e-02f,
+   +1.06353740e-02f, +1.91025435e-02f, +8.60312301e-03f, -7.76601979e-03f,
+   -1.40422589e-02f, -6.35394945e-03f, +5.75312803e-03f, +1.04192958e-02f,
+   +4.71624870e-03f, -4.26701108e-03f, -7.71410311e-03f, -3.48229569e-03f,
+   +3.13930713e-03f, +5.65031408e-03f, +2.53732360e-03f, -2.27361368e-03f,
+   -4.06420293e-03f, -1.81107991e-03f, +1.60902218e-03f, +2.84910172e-03f,
+   +1.25641320e-03f, -1.10346127e-03f, -1.92927175e-03f, -8.38953676e-04f,
+   +7.25496696e-04f, +1.24680785e-03f, +5.31864526e-04f, -4.50112407e-04f,
+   -7.54843723e-04f, -3.13104115e-04f, +2.56504588e-04f, +4.14001502e-04f,
+   +1.64000446e-04f, -1.26940585e-04f, -1.90572305e-04f, -6.85294257e-05f
+};
+/*-------------------[        Module Prototypes        ]-------------------*/
+static void Resample(
+   float*       history,
+   int          historyLength,
+   const float* filter,
+   int          up,
+   int          down,
+   int          inputLength,
+   int16_t*     output);
+/*-------------------[         Implementation          ]-------------------*/
+/*-----------< FUNCTION: Qmf_Init >------------------------------------------
+// Purpose:    initializes a band splitter
+// Parameters: qmf  - splitter state to initialize
+//             rate - full-band sample rate (32000/48000)
+// Returns:    0 if successful
+//             -1 if the sample rate is not supported
+---------------------------------------------------------------------------*/
+int Qmf_Init(QmfState* qmf, int rate) {
+   if (rate != 32000 && rate != 48000)
+      return -1;
+   memset(qmf, 0, sizeof(*qmf));
+   qmf->rate = rate;
+   return 0;
+}
+/*-----------< FUNCTION: Qmf_Analyze >---------------------------------------
+// Purpose:    splits a 10ms full-band frame into low and high bands
+// Parameters: qmf   - splitter state
+//             frame - full-band input frame (rate / 100 samples)
+//             low   - 0-8kHz band output (QMF_BAND_LENGTH samples)
+//             high  - 8-16kHz band output (QMF_BAND_LENGTH samples)
+// Returns:    none
+---------------------------------------------------------------------------*/
+void Qmf_Analyze(
+      QmfState*      qmf,
+      const int16_t* frame,
+      int16_t*       low,
+      int16_t*       high) {
+   int16_t resampled[2 * QMF_BAND_LENGTH];
+   // downsample 48kHz frames to the 32kHz splitting rate
+   if (qmf->rate == 48000) {
+      for (int i = 0; i < 480; i++)
+         qmf->down[QMF_DOWN_HISTORY + i] = frame[i];
+      Resample(
+         qmf->down,
+         QMF_DOWN_HISTORY,
+         kResampleFilter,
+         2,
+         3,
+         480,
+         resampled);
+      frame = resampled;
+   }
+   WebRtcSpl_AnalysisQMF(
+      frame,
+      2 * QMF_BAND_LENGTH,
+      low,
+      high,
+      qmf->analysis1,
+      qmf->analysis2);
+}
+/*-----------< FUNCTION: Qmf_Synthesize >------------------------------------
+// Purpose:    merges low and high bands into a 10ms full-band frame
+// Parameters: qmf   - splitter state
+//             low   - 0-8kHz band input (QMF_BAND_LENGTH samples)
+//             high  - 8-16kHz band input (QMF_BAND_LENGTH samples)
+//             frame - full-band output frame (rate / 100 samples)
+// Returns:    none
+---------------------------------------------------------------------------*/
+void Qmf_Synthesize(
+      QmfState*      qmf,
+      const int16_t* low,
+      const int16_t* high,
+      int16_t*       frame) {
+   if (qmf->rate == 32000) {
+      WebRtcSpl_SynthesisQMF(
+         low,
+         high,
+         QMF_BAND_LENGTH,
+         frame,
+         qmf->synthesis1,
+         qmf->synthesis2);
+   } else {
+      // upsample the 32kHz synthesis back to 48kHz
+      int16_t merged[2 * QMF_BAND_LENGTH];
+      WebRtcSpl_SynthesisQMF(
+         low,
+         high,
+         QMF_BAND_LENGTH,
+         merged,
+         qmf->synthesis1,
+         qmf->synthesis2);
+      for (int i = 0; i < 320; i++)
+         qmf->up[QMF_UP_HISTORY + i] = merged[i];
+      Resample(
+         qmf->up,
+         QMF_UP_HISTORY,
+         kResampleFilter,
+         3,
+         2,
+         320,
+         frame);
+   }
+}
+/*-----------< FUNCTION: Resample >------------------------------------------
+// Purpose:    polyphase rational resampler (up/down)
+// Parameters: history       - input samples, preceded by historyLength
+//                             samples from the previous call
+//             historyLength - number of history samples (taps / up - 1)
+//             filter        - lowpass filter, designed at the up-rate
+//             up            - interpolation factor
+//             down          - decimation factor
+//             inputLength   - number of new input samples, which must be
+//                             a multiple of down
+//             output        - resampled output
+//                             (inputLength * up / down samples)
+// Returns:    none
+---------------------------------------------------------------------------*/
+void Resample(
+      float*       history,
+      int          historyLength,
+      const float* filter,
+      int          up,
+      int          down,
+      int          inputLength,
+      int16_t*     output) {
+   int outputLength = inputLength * up / down;
+   int taps = QMF_FIR_TAPS / up;
+   for (int n = 0; n < outputLength; n++) {
+      // locate the newest input sample contributing to this output
+      // and the filter phase that aligns with it
+      int t = n * down;
+      int j = t / up;
+      int p = t - j * up;
+      const float* x = history + historyLength + j;
+      float sum = 0;
+      for (int i = 0; i < taps; i++)
+         sum += filter[p + i * up] * x[-i];
+      // restore the interpolation gain and saturate
+      sum *= up;
+      if (sum > 32767.0f)
+         sum = 32767.0f;
+      else if (sum < -32768.0f)
+         sum = -32768.0f;
+      output[n] = (int16_t)(sum + (sum >= 0 ? 0.5f : -0.5f));
+   }
+   // retain the tail of the input for the next frame
+   memmove(
+      history,
+      history + inputLength,
+      historyLength * sizeof(float));
+}
@@ -0,0 +1,48 @@
+/****************************************************************************
+ *
+ * MODULE:  qmf.h
+ * PURPOSE: full-band qmf band splitting for the webrtc audio components
+ *
+ ***************************************************************************/
+#ifndef __QMF_H
+#define __QMF_H
+/*-------------------[       Pre Include Defines       ]-------------------*/
+/*-------------------[      Library Include Files      ]-------------------*/
+#include <stdint.h>
+/*-------------------[      Project Include Files      ]-------------------*/
+/*-------------------[      Macros/Constants/Types     ]-------------------*/
+#define QMF_BAND_LENGTH    160   // samples per band per 10ms frame
+#define QMF_FIR_TAPS       96    // 48<->32kHz resampling filter length
+#define QMF_DOWN_HISTORY   (QMF_FIR_TAPS / 2 - 1)
+#define QMF_UP_HISTORY     (QMF_FIR_TAPS / 3 - 1)
+
+// band splitter state
+// . 32kHz frames are split directly into 0-8kHz/8-16kHz bands
+// . 48kHz frames are resampled to 32kHz before splitting and back to
+//   48kHz after synthesis, so the 16-24kHz band is discarded
+typedef struct QmfState {
+   int      rate;                            // full-band sample rate
+   int32_t  analysis1[6];                    // analysis filter state
+   int32_t  analysis2[6];
+   int32_t  synthesis1[6];                   // synthesis filter state
+   int32_t  synthesis2[6];
+   float    down[QMF_DOWN_HISTORY + 480];    // 48->32kHz input history
+   float    up[QMF_UP_HISTORY + 320];        // 32->48kHz input history
+} QmfState;
+/*-------------------[        Global Variables         ]-------------------*/
+/*-------------------[        Global Prototypes        ]-------------------*/
+int  Qmf_Init(QmfState* qmf, int rate);
+void Qmf_Analyze(
+   QmfState*      qmf,
+   const int16_t* frame,
+   int16_t*       low,
+   int16_t*       high);
+void Qmf_Synthesize(
+   QmfState*      qmf,
+   const int16_t* low,
+   const int16_t* high,
+   int16_t*       frame);
+/*-------------------[        Module Variables         ]-------------------*/
+/*-------------------[        Module Prototypes        ]-------------------*/
+/*-------------------[         Implementation          ]-------------------*/
+#endif
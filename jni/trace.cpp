@@ -0,0 +1,344 @@
+/****************************************************************************
+ *
+ * MODULE:  trace.cpp
+ * PURPOSE: binary trace ring and jni wrapper
+ *
+ ***************************************************************************/
+/*-------------------[       Pre Include Defines       ]-------------------*/
+/*-------------------[      Library Include Files      ]-------------------*/
+#include <jni.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+/*-------------------[      Project Include Files      ]-------------------*/
+#include "trace.h"
+/*-------------------[      Macros/Constants/Types     ]-------------------*/
+// trace record
+// . the stamp is the record's sequence number + 1, and is cleared while
+//   the record is being written, so that the reader can detect records
+//   that are incomplete or were overwritten while they were copied
+struct TraceRecord {
+   uint64_t stamp;                   // sequence number + 1, or 0 if busy
+   int64_t  time;                    // monotonic timestamp, in ns
+   int32_t  id;                      // event id
+   int32_t  reserved;
+   double   args[TRACE_MAX_ARGS];    // numeric arguments
+};
+
+// trace ring
+// . any number of threads may record into the ring, each claiming a
+//   sequence number with an atomic increment, so recording never blocks
+// . a single thread drains the ring, and records that are overwritten
+//   before they are drained are counted as lost
+struct TraceRing {
+   uint64_t     mask;                // capacity - 1 (capacity is 2^n)
+   uint64_t     head;                // next sequence number to claim
+   uint64_t     tail;                // next sequence number to drain
+   int64_t      lost;                // number of records lost
+   TraceRecord* records;             // record ring
+};
+
+// trace event type
+struct TraceEvent {
+   char* name;                       // event name
+   char* format;                     // printf-style message format
+   char* args;                       // comma-separated argument names
+};
+/*-------------------[        Global Variables         ]-------------------*/
+/*-------------------[        Global Prototypes        ]-------------------*/
+/*-------------------[        Module Variables         ]-------------------*/
+// the ring is allocated on first enable and never released, so that
+// recording threads never observe a dangling ring
+static TraceRing*      g_ring = NULL;
+static TraceEvent      g_events[TRACE_MAX_EVENTS];
+static int             g_event_count = 0;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+/*-------------------[        Module Prototypes        ]-------------------*/
+static TraceEvent* GetEvent(int id);
+/*-------------------[         Implementation          ]-------------------*/
+/*-----------< FUNCTION: Trace_Enable >--------------------------------------
+// Purpose:    allocates the trace ring, if it has not been allocated
+// Parameters: capacity - minimum ring capacity, in records
+// Returns:    the ring capacity if successful
+//             -1 otherwise
+---------------------------------------------------------------------------*/
+int Trace_Enable(int capacity) {
+   pthread_mutex_lock(&g_lock);
+   TraceRing* ring = g_ring;
+   if (ring == NULL && capacity > 0) {
+      uint64_t size = 1;
+      while (size < (uint64_t)capacity)
+         size <<= 1;
+      ring = (TraceRing*)calloc(1, sizeof(TraceRing));
+      if (ring != NULL) {
+         ring->mask = size - 1;
+         ring->records = (TraceRecord*)calloc(size, sizeof(TraceRecord));
+         if (ring->records == NULL) {
+            free(ring);
+            ring = NULL;
+         }
+      }
+      if (ring != NULL)
+         __atomic_store_n(&g_ring, ring, __ATOMIC_RELEASE);
+   }
+   pthread_mutex_unlock(&g_lock);
+   return ring != NULL ? (int)(ring->mask + 1) : -1;
+}
+/*-----------< FUNCTION: Trace_IsEnabled >-----------------------------------
+// Purpose:    determines whether records are being traced
+// Parameters: none
+// Returns:    nonzero if the trace ring has been allocated
+---------------------------------------------------------------------------*/
+int Trace_IsEnabled() {
+   return __atomic_load_n(&g_ring, __ATOMIC_ACQUIRE) != NULL;
+}
+/*-----------< FUNCTION: Trace_Register >------------------------------------
+// Purpose:    registers a native trace event type
+// Parameters: name   - unique event name
+//             format - printf-style message format, applied to the
+//                      event arguments (as doubles) when drained
+//             args   - comma-separated argument names, or null for an
+//                      event that is not a counter
+// Returns:    the event id if successful (or the id of the event previously
+//             registered with the same name)
+//             TRACE_UNREGISTERED otherwise
+---------------------------------------------------------------------------*/
+int Trace_Register(const char* name, const char* format, const char* args) {
+   int id = TRACE_UNREGISTERED;
+   pthread_mutex_lock(&g_lock);
+   for (int i = 0; i < g_event_count; i++)
+      if (strcmp(g_events[i].name, name) == 0)
+         id = TRACE_NATIVE_BASE + i;
+   if (id == TRACE_UNREGISTERED && g_event_count < TRACE_MAX_EVENTS) {
+      TraceEvent* event = &g_events[g_event_count];
+      event->name = strdup(name);
+      event->format = strdup(format != NULL ? format : name);
+      event->args = strdup(args != NULL ? args : "");
+      if (event->name != NULL && event->format != NULL && event->args != NULL)
+         id = TRACE_NATIVE_BASE + g_event_count++;
+      else {
+         free(event->name);
+         free(event->format);
+         free(event->args);
+         memset(event, 0, sizeof(*event));
+      }
+   }
+   pthread_mutex_unlock(&g_lock);
+   return id;
+}
+/*-----------< FUNCTION: Trace_Record >--------------------------------------
+// Purpose:    appends a record to the trace ring, if tracing is enabled
+// Parameters: id - registered event id
+//             a0 - first event argument
+//             a1 - second event argument
+//             a2 - third event argument
+//             a3 - fourth event argument
+// Returns:    none
+---------------------------------------------------------------------------*/
+void Trace_Record(int id, double a0, double a1, double a2, double a3) {
+   TraceRing* ring = __atomic_load_n(&g_ring, __ATOMIC_ACQUIRE);
+   if (ring == NULL || id == TRACE_UNREGISTERED)
+      return;
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   uint64_t seq = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+   TraceRecord* record = &ring->records[seq & ring->mask];
+   __atomic_store_n(&record->stamp, 0, __ATOMIC_RELAXED);
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+   record->time = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+   record->id = id;
+   record->args[0] = a0;
+   record->args[1] = a1;
+   record->args[2] = a2;
+   record->args[3] = a3;
+   __atomic_store_n(&record->stamp, seq + 1, __ATOMIC_RELEASE);
+}
+/*-----------< FUNCTION: Trace_Drain >---------------------------------------
+// Purpose:    copies records out of the trace ring, oldest first
+//             this function must not be called concurrently
+// Parameters: entries - the entry buffer to fill
+//             count   - the capacity of the entry buffer
+// Returns:    the number of entries drained
+---------------------------------------------------------------------------*/
+int Trace_Drain(TraceEntry* entries, int count) {
+   TraceRing* ring = __atomic_load_n(&g_ring, __ATOMIC_ACQUIRE);
+   if (ring == NULL)
+      return 0;
+   uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+   uint64_t tail = ring->tail;
+   uint64_t capacity = ring->mask + 1;
+   // skip records that have already been overwritten
+   if (head - tail > capacity) {
+      ring->lost += (int64_t)(head - tail - capacity);
+      tail = head - capacity;
+   }
+   int drained = 0;
+   while (tail != head && drained < count) {
+      TraceRecord* record = &ring->records[tail & ring->mask];
+      uint64_t stamp = __atomic_load_n(&record->stamp, __ATOMIC_ACQUIRE);
+      // stop at a record that is still being written
+      if (stamp < tail + 1)
+         break;
+      if (stamp == tail + 1) {
+         TraceEntry* entry = &entries[drained];
+         entry->time = record->time;
+         entry->id = record->id;
+         entry->reserved = 0;
+         memcpy(entry->args, record->args, sizeof(entry->args));
+         // keep the copy only if the record was not overwritten during it
+         __atomic_thread_fence(__ATOMIC_ACQUIRE);
+         if (__atomic_load_n(&record->stamp, __ATOMIC_RELAXED) == stamp)
+            drained++;
+         else
+            ring->lost++;
+      } else {
+         ring->lost++;
+      }
+      tail++;
+   }
+   ring->tail = tail;
+   return drained;
+}
+/*-----------< FUNCTION: Trace_GetLost >-------------------------------------
+// Purpose:    retrieves the number of records lost to ring overflow
+// Parameters: none
+// Returns:    the lost record count
+---------------------------------------------------------------------------*/
+int64_t Trace_GetLost() {
+   TraceRing* ring = __atomic_load_n(&g_ring, __ATOMIC_ACQUIRE);
+   return ring != NULL ? ring->lost : 0;
+}
+/*-----------< FUNCTION: Trace_GetName >-------------------------------------
+// Purpose:    retrieves the name of a native event type
+// Parameters: id - registered event id
+// Returns:    the event name, or null if the event is not registered
+---------------------------------------------------------------------------*/
+const char* Trace_GetName(int id) {
+   TraceEvent* event = GetEvent(id);
+   return event != NULL ? event->name : NULL;
+}
+/*-----------< FUNCTION: Trace_GetFormat >-----------------------------------
+// Purpose:    retrieves the message format of a native event type
+// Parameters: id - registered event id
+// Returns:    the event format, or null if the event is not registered
+---------------------------------------------------------------------------*/
+const char* Trace_GetFormat(int id) {
+   TraceEvent* event = GetEvent(id);
+   return event != NULL ? event->format : NULL;
+}
+/*-----------< FUNCTION: Trace_GetArgs >-------------------------------------
+// Purpose:    retrieves the argument names of a native event type
+// Parameters: id - registered event id
+// Returns:    the comma-separated argument names, or null if the event
+//             is not registered
+---------------------------------------------------------------------------*/
+const char* Trace_GetArgs(int id) {
+   TraceEvent* event = GetEvent(id);
+   return event != NULL ? event->args : NULL;
+}
+/*-----------< FUNCTION: GetEvent >------------------------------------------
+// Purpose:    looks up a registered native event type
+// Parameters: id - registered event id
+// Returns:    the event type, or null if the event is not registered
+---------------------------------------------------------------------------*/
+TraceEvent* GetEvent(int id) {
+   TraceEvent* event = NULL;
+   pthread_mutex_lock(&g_lock);
+   if (id >= TRACE_NATIVE_BASE && id < TRACE_NATIVE_BASE + g_event_count)
+      event = &g_events[id - TRACE_NATIVE_BASE];
+   pthread_mutex_unlock(&g_lock);
+   return event;
+}
+/*-----------< FUNCTION: TraceRing_allocate >--------------------------------
+// Purpose:    allocates the trace ring, if it has not been allocated
+// Parameters: env      - java environment
+//             type     - java class reference
+//             capacity - minimum ring capacity, in records
+// Returns:    the ring capacity if successful
+//             -1 otherwise
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+jint JNICALL Java_io_spokestack_spokestack_util_TraceRing_allocate(
+      JNIEnv* env,
+      jclass  type,
+      jint    capacity) {
+   return Trace_Enable(capacity);
+}
+/*-----------< FUNCTION: TraceRing_append >----------------------------------
+// Purpose:    appends a record to the trace ring
+// Parameters: env  - java environment
+//             type - java class reference
+//             id   - event id
+//             a0   - first event argument
+//             a1   - second event argument
+//             a2   - third event argument
+//             a3   - fourth event argument
+// Returns:    none
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+void JNICALL Java_io_spokestack_spokestack_util_TraceRing_append(
+      JNIEnv* env,
+      jclass  type,
+      jint    id,
+      jdouble a0,
+      jdouble a1,
+      jdouble a2,
+      jdouble a3) {
+   Trace_Record(id, a0, a1, a2, a3);
+}
+/*-----------< FUNCTION: TraceRing_drain >-----------------------------------
+// Purpose:    copies records out of the trace ring, oldest first
+// Parameters: env    - java environment
+//             type   - java class reference
+//             buffer - direct entry buffer (TraceEntry layout)
+//             count  - the capacity of the buffer, in entries
+// Returns:    the number of entries drained
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+jint JNICALL Java_io_spokestack_spokestack_util_TraceRing_drain(
+      JNIEnv* env,
+      jclass  type,
+      jobject buffer,
+      jint    count) {
+   TraceEntry* entries = (TraceEntry*)env->GetDirectBufferAddress(buffer);
+   return Trace_Drain(entries, count);
+}
+/*-----------< FUNCTION: TraceRing_lost >------------------------------------
+// Purpose:    retrieves the number of records lost to ring overflow
+// Parameters: env  - java environment
+//             type - java class reference
+// Returns:    the lost record count
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+jlong JNICALL Java_io_spokestack_spokestack_util_TraceRing_lost(
+      JNIEnv* env,
+      jclass  type) {
+   return Trace_GetLost();
+}
+/*-----------< FUNCTION: TraceRing_describe >--------------------------------
+// Purpose:    retrieves the name, format and argument names of a native
+//             event type
+// Parameters: env  - java environment
+//             type - java class reference
+//             id   - native event id
+//             part - 0 for the name, 1 for the format, 2 for the arguments
+// Returns:    the requested description, or null if the event is not
+//             registered
+---------------------------------------------------------------------------*/
+extern "C" JNIEXPORT
+jstring JNICALL Java_io_spokestack_spokestack_util_TraceRing_describe(
+      JNIEnv* env,
+      jclass  type,
+      jint    id,
+      jint    part) {
+   const char* value = NULL;
+   switch (part) {
+      case 0: value = Trace_GetName(id); break;
+      case 1: value = Trace_GetFormat(id); break;
+      case 2: value = Trace_GetArgs(id); break;
+      default: break;
+   }
+   return value != NULL ? env->NewStringUTF(value) : NULL;
+}
@@ -0,0 +1,40 @@
+/****************************************************************************
+ *
+ * MODULE:  trace.h
+ * PURPOSE: binary trace ring interface
+ *
+ ***************************************************************************/
+#ifndef __TRACE_H
+#define __TRACE_H
+/*-------------------[       Pre Include Defines       ]-------------------*/
+/*-------------------[      Library Include Files      ]-------------------*/
+#include <stdint.h>
+/*-------------------[      Project Include Files      ]-------------------*/
+/*-------------------[      Macros/Constants/Types     ]-------------------*/
+#define TRACE_MAX_ARGS      4        // numeric arguments per record
+#define TRACE_MAX_EVENTS    256      // maximum native event types
+#define TRACE_NATIVE_BASE   0x10000  // first native event id
+#define TRACE_UNREGISTERED  -1       // event id before registration
+
+// drained trace record
+typedef struct TraceEntry {
+   int64_t  time;                    // monotonic timestamp, in ns
+   int32_t  id;                      // event id
+   int32_t  reserved;
+   double   args[TRACE_MAX_ARGS];    // numeric arguments
+} TraceEntry;
+/*-------------------[        Global Variables         ]-------------------*/
+/*-------------------[        Global Prototypes        ]-------------------*/
+int         Trace_Enable(int capacity);
+int         Trace_IsEnabled();
+int         Trace_Register(const char* name, const char* format, const char* args);
+void        Trace_Record(int id, double a0, double a1, double a2, double a3);
+int         Trace_Drain(TraceEntry* entries, int count);
+int64_t     Trace_GetLost();
+const char* Trace_GetName(int id);
+const char* Trace_GetFormat(int id);
+const char* Trace_GetArgs(int id);
+/*-------------------[        Module Variables         ]-------------------*/
+/*-------------------[        Module Prototypes        ]-------------------*/
+/*-------------------[         Implementation          ]-------------------*/
+#endif
@@ -0,0 +1,306 @@
+package io.spokestack.spokestack;
+
+import java.util.List;
+
+/**
+ * asynchronous speech event dispatcher.
+ *
+ * <p>
+ * The dispatcher queues speech events, along with a snapshot of the speech
+ * context at the time they were raised, and delivers them to listeners on
+ * a dedicated thread, so that slow listeners cannot stall the thread that
+ * raised them. The thread is started by the first queued event, and exits
+ * after it has been idle for a second. Listeners receive a read-only view
+ * of the snapshot, which does not hold the frame buffer; changes they make
+ * to the view do not affect the speech context.
+ * </p>
+ *
+ * <p>
+ * The queue is bounded, and raising an event never blocks on delivery.
+ * When the queue is full, TRACE and PARTIAL_RECOGNIZE events are dropped,
+ * and other events displace the oldest queued TRACE event (or are dropped
+ * if the queue has grown to twice its capacity). A PARTIAL_RECOGNIZE event
+ * that arrives while the previous one is still queued replaces it, since
+ * only the latest partial transcript is of interest. Trace messages are
+ * formatted on the dispatcher thread.
+ * </p>
+ *
+ * <p>
+ * Events are captured into records preallocated for a full queue, which
+ * are linked into the queue and, for TRACE events, into a list of queued
+ * traces, so that raising an event (including evicting a trace to make
+ * room for it) takes constant time under the lock and never allocates.
+ * </p>
+ */
+final class EventDispatcher {
+    // time to wait for an event before exiting the dispatcher thread, in ms
+    private static final long IDLE_TIMEOUT = 1000;
+
+    private final Object lock = new Object();
+    private final SpeechContext owner;
+    private final List<OnSpeechEventListener> listeners;
+    private final SpeechContext view;
+    private final int capacity;
+
+    // queued records, in delivery order
+    private Record head;
+    private Record tail;
+    private int size;
+
+    // queued TRACE records, oldest first
+    private Record traceHead;
+    private Record traceTail;
+
+    // unused records
+    private Record spares;
+    private Record partial;
+    private Thread thread;
+    private volatile long dropped;
+
+    /**
+     * constructs a new dispatcher instance.
+     * @param context        the speech context raising events
+     * @param eventListeners the listeners to notify, which must be safe to
+     *                       iterate while they are modified
+     * @param queueSize      the maximum number of events to queue
+     */
+    EventDispatcher(
+            SpeechContext context,
+            List<OnSpeechEventListener> eventListeners,
+            int queueSize) {
+        if (queueSize < 1)
+            throw new IllegalArgumentException("event-queue-size");
+
+        this.owner = context;
+        this.listeners = eventListeners;
+        this.view = new SpeechContext(new SpeechConfig());
+        this.capacity = queueSize;
+
+        // the queue holds at most twice its capacity,
+        // plus the record being delivered
+        for (int i = 0; i < queueSize * 2 + 1; i++)
+            recycle(new Record());
+    }
+
+    /**
+     * @return the number of events dropped because the queue was full
+     */
+    long getDropped() {
+        return this.dropped;
+    }
+
+    /**
+     * queues an event for delivery.
+     * @param context the speech context to snapshot
+     * @param event   the event to deliver
+     * @param format  the trace message format string, or null to use the
+     *                context's current message
+     * @param params  the trace message format parameters
+     */
+    void post(
+            SpeechContext context,
+            SpeechContext.Event event,
+            String format,
+            Object[] params) {
+        boolean partialEvent = event == SpeechContext.Event.PARTIAL_RECOGNIZE;
+        boolean droppable = partialEvent || event == SpeechContext.Event.TRACE;
+        synchronized (this.lock) {
+            // replace a queued partial transcript with the latest one
+            if (partialEvent && this.partial != null) {
+                this.partial.capture(context, event, format, params);
+                return;
+            }
+
+            // make room for the event, or drop it
+            if (this.size >= this.capacity) {
+                boolean admitted = !droppable
+                    && (evictTrace() || this.size < this.capacity * 2);
+                if (!admitted) {
+                    this.dropped++;
+                    return;
+                }
+            }
+
+            Record record = this.spares;
+            this.spares = record.next;
+            record.capture(context, event, format, params);
+            enqueue(record);
+
+            // partial transcripts can only be replaced until a
+            // subsequent non-trace event is queued
+            if (partialEvent)
+                this.partial = record;
+            else if (event != SpeechContext.Event.TRACE)
+                this.partial = null;
+
+            if (this.thread == null) {
+                this.thread = new Thread(
+                    this::run,
+                    "Spokestack-event-dispatcher");
+                this.thread.setDaemon(true);
+                this.thread.start();
+            } else {
+                this.lock.notify();
+            }
+        }
+    }
+
+    private boolean evictTrace() {
+        Record record = this.traceHead;
+        if (record == null)
+            return false;
+        unlink(record);
+        recycle(record);
+        this.dropped++;
+        return true;
+    }
+
+    private void enqueue(Record record) {
+        record.prev = this.tail;
+        record.next = null;
+        if (this.tail == null)
+            this.head = record;
+        else
+            this.tail.next = record;
+        this.tail = record;
+        this.size++;
+
+        if (record.event == SpeechContext.Event.TRACE) {
+            if (this.traceTail == null)
+                this.traceHead = record;
+            else
+                this.traceTail.nextTrace = record;
+            this.traceTail = record;
+        }
+    }
+
+    private void unlink(Record record) {
+        if (record.prev == null)
+            this.head = record.next;
+        else
+            record.prev.next = record.next;
+        if (record.next == null)
+            this.tail = record.prev;
+        else
+            record.next.prev = record.prev;
+        this.size--;
+
+        // traces leave the queue oldest first, whether they are
+        // delivered or evicted
+        if (record == this.traceHead) {
+            this.traceHead = record.nextTrace;
+            if (this.traceHead == null)
+                this.traceTail = null;
+        }
+    }
+
+    private void run() {
+        for (Record record = next(); record != null; record = next()) {
+            record.restore(this.view);
+            for (OnSpeechEventListener listener : this.listeners) {
+                try {
+                    listener.onEvent(record.event, this.view);
+                } catch (Exception e) {
+                    if (record.event != SpeechContext.Event.TRACE)
+                        this.owner.traceInfo("dispatch-failed: %s", e);
+                }
+            }
+            synchronized (this.lock) {
+                recycle(record);
+            }
+        }
+    }
+
+    private Record next() {
+        synchronized (this.lock) {
+            if (this.head == null) {
+                try {
+                    this.lock.wait(IDLE_TIMEOUT);
+                } catch (InterruptedException e) {
+                    // exit, leaving queued events for the next thread
+                    this.thread = null;
+                    return null;
+                }
+            }
+            Record record = this.head;
+            if (record == null) {
+                this.thread = null;
+                return null;
+            }
+            unlink(record);
+            if (record == this.partial)
+                this.partial = null;
+            return record;
+        }
+    }
+
+    private void recycle(Record record) {
+        record.clear();
+        record.next = this.spares;
+        this.spares = record;
+    }
+
+    /**
+     * a queued event and its speech context snapshot.
+     */
+    private static final class Record {
+        private Record prev;
+        private Record next;
+        private Record nextTrace;
+        private SpeechContext.Event event;
+        private String format;
+        private Object[] params;
+        private String message;
+        private String transcript;
+        private double confidence;
+        private Throwable error;
+        private boolean speech;
+        private boolean active;
+        private boolean managed;
+        private long samplePosition;
+
+        void capture(
+                SpeechContext context,
+                SpeechContext.Event type,
+                String messageFormat,
+                Object[] messageParams) {
+            this.event = type;
+            this.format = messageFormat;
+            this.params = messageParams;
+            this.message = messageFormat == null ? context.getMessage() : null;
+            this.transcript = context.getTranscript();
+            this.confidence = context.getConfidence();
+            this.error = context.getError();
+            this.speech = context.isSpeech();
+            this.active = context.isActive();
+            this.managed = context.isManaged();
+            this.samplePosition = context.getSamplePosition();
+        }
+
+        void restore(SpeechContext context) {
+            context.setMessage(this.format != null
+                ? String.format(this.format, this.params)
+                : this.message);
+            context
+                .setTranscript(this.transcript)
+                .setConfidence(this.confidence)
+                .setError(this.error)
+                .setSpeech(this.speech)
+                .setActive(this.active)
+                .setSamplePosition(this.samplePosition);
+            context.setManaged(this.managed);
+        }
+
+        void clear() {
+            this.prev = null;
+            this.next = null;
+            this.nextTrace = null;
+            this.event = null;
+            this.format = null;
+            this.params = null;
+            this.message = null;
+            this.transcript = null;
+            this.error = null;
+        }
+    }
+}
@@ -0,0 +1,216 @@
+package io.spokestack.spokestack;
+
+import java.io.BufferedInputStream;
+import java.io.EOFException;
+import java.io.FileInputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * audio file/stream speech input.
+ *
+ * <p>
+ * This class reads audio from a WAV file or a headerless PCM file (or any
+ * other stream of either), so that the speech pipeline can be run over
+ * recorded audio, such as in regression tests. WAV files must contain
+ * single-channel 16-bit PCM samples at the configured sample rate. Streams
+ * that do not begin with a RIFF header are assumed to contain raw
+ * single-channel 16-bit little-endian PCM samples at the configured
+ * sample rate.
+ * </p>
+ *
+ * <p>
+ * Reads are not paced, so the pipeline processes audio as fast as its
+ * stages allow. The final frame of the stream is zero-padded, and
+ * subsequent reads throw {@link EOFException}, which the speech pipeline
+ * treats as the end of input rather than an error. See
+ * {@link SpeechPipeline#runBatch()} for processing a file to completion on
+ * the calling thread.
+ * </p>
+ *
+ * <p>
+ * This input supports the following configuration properties:
+ * </p>
+ * <ul>
+ *   <li>
+ *      <b>sample-rate</b> (integer): audio sample rate, in Hz
+ *   </li>
+ *   <li>
+ *      <b>input-path</b> (string): file system path to the WAV/PCM file
+ *   </li>
+ * </ul>
+ */
+public final class FileInput implements SpeechInput {
+    private static final int RIFF = 0x46464952;     // "RIFF"
+    private static final int WAVE = 0x45564157;     // "WAVE"
+    private static final int FMT = 0x20746d66;      // "fmt "
+    private static final int DATA = 0x61746164;     // "data"
+    private static final int PCM_FORMAT = 1;
+
+    private final InputStream stream;
+    private byte[] samples;
+    private long remaining;
+    private boolean ended;
+
+    /**
+     * initializes a new file input instance and opens the file.
+     * @param config speech pipeline configuration
+     * @throws IOException if the file cannot be opened or parsed
+     */
+    public FileInput(SpeechConfig config) throws IOException {
+        this(config, new FileInputStream(config.getString("input-path")));
+    }
+
+    /**
+     * initializes a new file input instance over an existing stream.
+     * @param config speech pipeline configuration
+     * @param input  the WAV/PCM stream to read, which is closed along with
+     *               the input
+     * @throws IOException if the stream cannot be read or parsed
+     */
+    public FileInput(SpeechConfig config, InputStream input)
+            throws IOException {
+        this.stream = input.markSupported()
+            ? input
+            : new BufferedInputStream(input);
+        this.remaining = Long.MAX_VALUE;
+
+        // streams without a riff header are raw pcm
+        this.stream.mark(4);
+        int magic;
+        try {
+            magic = readInt();
+        } catch (EOFException e) {
+            magic = 0;
+        }
+        if (magic != RIFF) {
+            this.stream.reset();
+            return;
+        }
+
+        try {
+            parseWave(config.getInteger("sample-rate"));
+        } catch (IOException | RuntimeException e) {
+            this.stream.close();
+            throw e;
+        }
+    }
+
+    /**
+     * releases the resources associated with the file.
+     * @throws IOException on close error
+     */
+    @Override
+    public void close() throws IOException {
+        this.stream.close();
+    }
+
+    /**
+     * reads a frame from the file. the final frame is zero-padded.
+     * @param context the current speech context
+     * @param frame   the frame buffer to fill
+     * @throws IOException if audio cannot be read
+     * @throws EOFException at the end of the stream
+     */
+    public void read(SpeechContext context, ByteBuffer frame)
+            throws IOException {
+        if (this.ended)
+            throw new EOFException();
+
+        int length = frame.capacity();
+        if (this.samples == null || this.samples.length != length)
+            this.samples = new byte[length];
+
+        // fill the frame, stopping at the end of the stream
+        int read = 0;
+        while (read < length && this.remaining > 0) {
+            int count = this.stream.read(
+                this.samples,
+                read,
+                (int) Math.min(length - read, this.remaining));
+            if (count < 0)
+                break;
+            read += count;
+            this.remaining -= count;
+        }
+        if (read < length)
+            this.ended = true;
+        if (read == 0)
+            throw new EOFException();
+
+        // convert the samples to the frame's byte order,
+        // zero-padding the final frame
+        read &= ~1;
+        frame.clear();
+        frame.asShortBuffer().put(
+            ByteBuffer.wrap(this.samples, 0, read)
+                .order(ByteOrder.LITTLE_ENDIAN)
+                .asShortBuffer());
+        for (int i = read; i < length; i++)
+            frame.put(i, (byte) 0);
+    }
+
+    private void parseWave(int sampleRate) throws IOException {
+        readInt();
+        if (readInt() != WAVE)
+            throw new IllegalArgumentException("wave");
+
+        // walk the chunks to the start of the sample data
+        boolean format = false;
+        while (true) {
+            int chunk = readInt();
+            long size = readInt() & 0xFFFFFFFFL;
+            if (chunk == FMT) {
+                if (size < 16)
+                    throw new IllegalArgumentException("fmt");
+                if (readShort() != PCM_FORMAT)
+                    throw new IllegalArgumentException("format");
+                if (readShort() != 1)
+                    throw new IllegalArgumentException("channels");
+                if (readInt() != sampleRate)
+                    throw new IllegalArgumentException("sample-rate");
+                skip(6);
+                if (readShort() != 16)
+                    throw new IllegalArgumentException("bits");
+                skip(size - 16 + (size & 1));
+                format = true;
+            } else if (chunk == DATA) {
+                if (!format)
+                    throw new IllegalArgumentException("fmt");
+                // streamed wav files may not know their data size
+                if (size != 0 && size != 0xFFFFFFFFL)
+                    this.remaining = size;
+                return;
+            } else {
+                skip(size + (size & 1));
+            }
+        }
+    }
+
+    private int readShort() throws IOException {
+        int lo = this.stream.read();
+        int hi = this.stream.read();
+        if ((lo | hi) < 0)
+            throw new EOFException();
+        return lo | (hi << 8);
+    }
+
+    private int readInt() throws IOException {
+        return readShort() | (readShort() << 16);
+    }
+
+    private void skip(long count) throws IOException {
+        long pending = count;
+        while (pending > 0) {
+            long skipped = this.stream.skip(pending);
+            if (skipped <= 0) {
+                if (this.stream.read() < 0)
+                    throw new EOFException();
+                skipped = 1;
+            }
+            pending -= skipped;
+        }
+    }
+}
@@ -0,0 +1,213 @@
+package io.spokestack.spokestack;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.AbstractCollection;
+import java.util.Deque;
+import java.util.Iterator;
+import java.util.NoSuchElementException;
+
+/**
+ * a fixed circular store of audio frames.
+ *
+ * <p>
+ * The frame buffer holds the most recent frames read by the speech pipeline,
+ * ordered from oldest (first) to newest (last). All frames are preallocated,
+ * and the pipeline recycles the oldest frame for each new one via
+ * {@link #rotate()}, so that nothing is allocated on the audio thread.
+ * </p>
+ *
+ * <p>
+ * The buffer implements the read-only operations of {@link Deque}, so that
+ * components can iterate over the buffered frames in either direction, such
+ * as ASR components that send buffered audio when a recognition begins.
+ * Operations that would change the number of frames are not supported.
+ * </p>
+ */
+public final class FrameBuffer
+        extends AbstractCollection<ByteBuffer>
+        implements Deque<ByteBuffer> {
+    private final ByteBuffer[] frames;
+    private int head;                   // position of the oldest frame
+
+    /**
+     * constructs a new frame buffer instance.
+     * @param capacity  the number of frames to store
+     * @param frameSize the size of each frame, in bytes
+     */
+    public FrameBuffer(int capacity, int frameSize) {
+        if (capacity < 1)
+            throw new IllegalArgumentException("capacity");
+
+        this.frames = new ByteBuffer[capacity];
+        for (int i = 0; i < capacity; i++) {
+            this.frames[i] = ByteBuffer
+                .allocateDirect(frameSize)
+                .order(ByteOrder.nativeOrder());
+        }
+    }
+
+    /**
+     * recycles the oldest frame as the newest frame.
+     * @return the rewound frame to fill, which is now {@link #getLast()}
+     */
+    public ByteBuffer rotate() {
+        ByteBuffer frame = this.frames[this.head];
+        this.head = pos(this.head + 1);
+        frame.rewind();
+        return frame;
+    }
+
+    @Override
+    public int size() {
+        return this.frames.length;
+    }
+
+    @Override
+    public ByteBuffer getFirst() {
+        return this.frames[this.head];
+    }
+
+    @Override
+    public ByteBuffer getLast() {
+        return this.frames[pos(this.head + this.frames.length - 1)];
+    }
+
+    @Override
+    public ByteBuffer peekFirst() {
+        return getFirst();
+    }
+
+    @Override
+    public ByteBuffer peekLast() {
+        return getLast();
+    }
+
+    @Override
+    public ByteBuffer element() {
+        return getFirst();
+    }
+
+    @Override
+    public ByteBuffer peek() {
+        return getFirst();
+    }
+
+    @Override
+    public Iterator<ByteBuffer> iterator() {
+        return new FrameIterator(false);
+    }
+
+    @Override
+    public Iterator<ByteBuffer> descendingIterator() {
+        return new FrameIterator(true);
+    }
+
+    @Override
+    public void addFirst(ByteBuffer frame) {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public void addLast(ByteBuffer frame) {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public boolean offerFirst(ByteBuffer frame) {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public boolean offerLast(ByteBuffer frame) {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public ByteBuffer removeFirst() {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public ByteBuffer removeLast() {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public ByteBuffer pollFirst() {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public ByteBuffer pollLast() {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public boolean removeFirstOccurrence(Object o) {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public boolean removeLastOccurrence(Object o) {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public boolean offer(ByteBuffer frame) {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public ByteBuffer remove() {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public ByteBuffer poll() {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public void push(ByteBuffer frame) {
+        throw new UnsupportedOperationException();
+    }
+
+    @Override
+    public ByteBuffer pop() {
+        throw new UnsupportedOperationException();
+    }
+
+    private int pos(int x) {
+        return x % this.frames.length;
+    }
+
+    /**
+     * iterates the frames from oldest to newest, or newest to oldest.
+     */
+    private final class FrameIterator implements Iterator<ByteBuffer> {
+        private final boolean descending;
+        private int index;
+
+        FrameIterator(boolean reverse) {
+            this.descending = reverse;
+        }
+
+        @Override
+        public boolean hasNext() {
+            return this.index < frames.length;
+        }
+
+        @Override
+        public ByteBuffer next() {
+            if (!hasNext())
+                throw new NoSuchElementException();
+
+            int offset = this.descending
+                ? frames.length - 1 - this.index
+                : this.index;
+            this.index++;
+            return frames[pos(head + offset)];
+        }
+    }
+}
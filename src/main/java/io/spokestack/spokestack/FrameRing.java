@@ -0,0 +1,168 @@
+package io.spokestack.spokestack;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.locks.LockSupport;
+
+/**
+ * a lock-free single-producer/single-consumer ring of audio frames.
+ *
+ * <p>
+ * The ring preallocates all of its frame buffers, so that neither side
+ * allocates while audio is flowing. The producer claims the next free frame,
+ * fills it, and publishes it; the consumer waits for a published frame and
+ * copies it out. Frames that cannot be claimed because the ring is full are
+ * counted as overruns, and waits for a frame that time out are counted as
+ * underruns. Each frame is stamped with the number of overruns counted
+ * before it was claimed, so that the consumer can tell which drops
+ * preceded the frame it reads, rather than which have happened by the time
+ * it reads it.
+ * </p>
+ */
+public final class FrameRing {
+    private final ByteBuffer[] frames;      // frame buffers (n + 1) elements
+    private final long[] drops;             // overruns before each frame
+    private volatile int rpos;              // current read position
+    private volatile int wpos;              // current write position
+    private volatile Thread consumer;       // waiting consumer thread
+    private volatile long overruns;
+    private volatile long underruns;
+
+    /**
+     * constructs a new frame ring instance.
+     * @param capacity  the maximum number of frames to store
+     * @param frameSize the size of each frame, in bytes
+     */
+    public FrameRing(int capacity, int frameSize) {
+        this.frames = new ByteBuffer[capacity + 1];
+        for (int i = 0; i < this.frames.length; i++) {
+            this.frames[i] = ByteBuffer
+                .allocateDirect(frameSize)
+                .order(ByteOrder.nativeOrder());
+        }
+        this.drops = new long[this.frames.length];
+    }
+
+    /**
+     * @return the maximum number of frames that can be stored
+     */
+    public int capacity() {
+        return this.frames.length - 1;
+    }
+
+    /**
+     * @return true if no frames can be read, false otherwise
+     */
+    public boolean isEmpty() {
+        return this.rpos == this.wpos;
+    }
+
+    /**
+     * @return true if no frames can be written, false otherwise
+     */
+    public boolean isFull() {
+        return pos(this.wpos + 1) == this.rpos;
+    }
+
+    /**
+     * @return the number of frames dropped because the ring was full
+     */
+    public long getOverruns() {
+        return this.overruns;
+    }
+
+    /**
+     * @return the number of consumer waits that timed out
+     */
+    public long getUnderruns() {
+        return this.underruns;
+    }
+
+    /**
+     * claims the next frame to write. called by the producer.
+     * @return the rewound frame buffer to fill, or null if the ring is full,
+     * in which case an overrun is counted
+     */
+    public ByteBuffer claim() {
+        if (isFull()) {
+            this.overruns++;
+            return null;
+        }
+        ByteBuffer frame = this.frames[this.wpos];
+        frame.rewind();
+        this.drops[this.wpos] = this.overruns;
+        return frame;
+    }
+
+    /**
+     * publishes the most recently claimed frame to the consumer.
+     * called by the producer.
+     */
+    public void publish() {
+        this.wpos = pos(this.wpos + 1);
+        Thread waiter = this.consumer;
+        if (waiter != null)
+            LockSupport.unpark(waiter);
+    }
+
+    /**
+     * waits for a frame to become readable. called by the consumer.
+     * @param timeout maximum time to wait, in milliseconds
+     * @return true if a frame can be read, false if the wait timed out
+     * (counting an underrun) or the consumer was interrupted
+     */
+    public boolean await(long timeout) {
+        if (!isEmpty())
+            return true;
+
+        long deadline = System.nanoTime()
+            + TimeUnit.MILLISECONDS.toNanos(timeout);
+        this.consumer = Thread.currentThread();
+        try {
+            while (isEmpty()) {
+                long remaining = deadline - System.nanoTime();
+                if (remaining <= 0) {
+                    this.underruns++;
+                    return false;
+                }
+                LockSupport.parkNanos(this, remaining);
+                if (Thread.currentThread().isInterrupted())
+                    return false;
+            }
+            return true;
+        } finally {
+            this.consumer = null;
+        }
+    }
+
+    /**
+     * copies the next frame out of the ring. called by the consumer.
+     * @param frame the frame buffer to fill, which is rewound on return
+     * @return the number of overruns counted before the frame was claimed
+     */
+    public long read(ByteBuffer frame) {
+        if (isEmpty())
+            throw new IllegalStateException("empty");
+
+        ByteBuffer source = this.frames[this.rpos];
+        source.rewind();
+        frame.rewind();
+        frame.put(source);
+        frame.rewind();
+        long dropped = this.drops[this.rpos];
+        this.rpos = pos(this.rpos + 1);
+        return dropped;
+    }
+
+    /**
+     * discards all readable frames. called by the consumer.
+     */
+    public void clear() {
+        this.rpos = this.wpos;
+    }
+
+    private int pos(int x) {
+        return x % this.frames.length;
+    }
+}
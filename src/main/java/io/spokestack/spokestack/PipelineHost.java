@@ -0,0 +1,522 @@
+package io.spokestack.spokestack;
+
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.Set;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.ForkJoinPool;
+import java.util.concurrent.ForkJoinWorkerThread;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicBoolean;
+import java.util.concurrent.locks.LockSupport;
+
+/**
+ * multi-stream speech pipeline host.
+ *
+ * <p>
+ * Where a {@link SpeechPipeline} reads a single audio input on a dedicated
+ * thread, the pipeline host processes any number of concurrent audio
+ * streams, such as those received by a server, on a fixed pool of worker
+ * threads. Each stream has its own {@link SpeechContext}, frame buffer, and
+ * instances of the configured stage classes, so streams share no state.
+ * </p>
+ *
+ * <pre>
+ * {@code
+ *  PipelineHost host = new PipelineHost.Builder()
+ *      .addStageClass("io.spokestack.spokestack.webrtc.VoiceActivityTrigger")
+ *      .setProperty("sample-rate", 16000)
+ *      .setProperty("frame-width", 20)
+ *      .build();
+ *  PipelineHost.Stream stream = host.open(this);
+ *  ...
+ *  stream.write(frame);
+ *  ...
+ *  stream.close();
+ * }
+ * </pre>
+ *
+ * <p>
+ * Clients push frames of 16-bit PCM audio to a stream from a single producer
+ * thread, and frames are queued in a preallocated lock-free ring per stream.
+ * The first frame queued to an idle stream schedules the stream on the
+ * pool, and a scheduled stream is processed by exactly one worker at a
+ * time, so each stream's frames are processed in order. Workers process at
+ * most a few frames per scheduling before yielding to other streams, and
+ * idle workers steal scheduled streams from busy ones, so that latency
+ * remains stable as streams are added.
+ * </p>
+ *
+ * <p>
+ * Each stream's queue bounds the audio pending for it. When the queue is
+ * full, {@link Stream#offer(ByteBuffer)} drops the frame and counts an
+ * overrun, and {@link Stream#write(ByteBuffer)} blocks until the stream's
+ * worker has made room. Events are dispatched to stream listeners on the
+ * worker threads, so listeners should not block.
+ * </p>
+ *
+ * <p>
+ * The host supports the following configuration properties, in addition to
+ * those of the configured stages:
+ * </p>
+ * <ul>
+ *   <li>
+ *      <b>sample-rate</b> (integer): audio sample rate, in Hz
+ *   </li>
+ *   <li>
+ *      <b>frame-width</b> (integer): audio frame width, in ms
+ *   </li>
+ *   <li>
+ *      <b>buffer-width</b> (integer): width of each stream's frame buffer,
+ *      in ms
+ *   </li>
+ *   <li>
+ *      <b>host-workers</b> (integer): number of worker threads, which
+ *      defaults to the number of processors
+ *   </li>
+ *   <li>
+ *      <b>host-queue-width</b> (integer): width of each stream's queue of
+ *      pending audio, in ms
+ *   </li>
+ * </ul>
+ */
+public final class PipelineHost implements AutoCloseable {
+    /**
+     * stream queue width default, in ms.
+     */
+    public static final int DEFAULT_QUEUE_WIDTH = 200;
+
+    // maximum number of frames processed per stream scheduling
+    private static final int QUANTUM = 4;
+
+    private final List<String> stageClasses;
+    private final SpeechConfig config;
+    private final List<OnSpeechEventListener> listeners;
+    private final Set<Stream> streams = ConcurrentHashMap.newKeySet();
+    private final ForkJoinPool pool;
+    private final int frameSize;
+    private final int frameCount;
+    private final int queueCount;
+    private volatile boolean closed;
+
+    /**
+     * initializes a new pipeline host instance and starts its workers.
+     *
+     * @param builder host builder with configuration parameters
+     */
+    private PipelineHost(Builder builder) {
+        this.stageClasses = builder.stageClasses;
+        this.config = builder.config;
+        this.listeners = builder.listeners;
+
+        // compute the frame size and number of buffers
+        int sampleWidth = 2;
+        int sampleRate = this.config.getInteger("sample-rate");
+        int frameWidth = this.config.getInteger("frame-width");
+        int bufferWidth = this.config.getInteger("buffer-width");
+        int queueWidth = this.config.getInteger(
+            "host-queue-width",
+            DEFAULT_QUEUE_WIDTH);
+        this.frameSize = sampleRate * frameWidth / 1000 * sampleWidth;
+        this.frameCount = Math.max(bufferWidth / frameWidth, 1);
+        this.queueCount = Math.max(queueWidth / frameWidth, 1);
+
+        int workers = this.config.getInteger(
+            "host-workers",
+            Runtime.getRuntime().availableProcessors());
+        if (workers < 1)
+            throw new IllegalArgumentException("host-workers");
+
+        // streams are scheduled as independent event-style tasks,
+        // so the pool runs them in fifo order
+        this.pool = new ForkJoinPool(
+            workers,
+            owner -> {
+                ForkJoinWorkerThread thread = ForkJoinPool
+                    .defaultForkJoinWorkerThreadFactory
+                    .newThread(owner);
+                thread.setName(
+                    "Spokestack-pipeline-host-" + thread.getPoolIndex());
+                return thread;
+            },
+            null,
+            true);
+    }
+
+    /**
+     * @return current host configuration
+     */
+    public SpeechConfig getConfig() {
+        return this.config;
+    }
+
+    /**
+     * @return the number of open streams
+     */
+    public int getStreamCount() {
+        return this.streams.size();
+    }
+
+    /**
+     * opens a new stream, creating its stage components.
+     *
+     * @param streamListeners stream event listeners, which receive events
+     *                        in addition to the host's listeners
+     * @return the new stream
+     * @throws Exception on stage configuration/startup error
+     */
+    public Stream open(OnSpeechEventListener... streamListeners)
+            throws Exception {
+        if (this.closed)
+            throw new IllegalStateException("closed");
+
+        Stream stream = new Stream(createStages());
+        for (OnSpeechEventListener l : this.listeners)
+            stream.context.addOnSpeechEventListener(l);
+        for (OnSpeechEventListener l : streamListeners)
+            stream.context.addOnSpeechEventListener(l);
+        this.streams.add(stream);
+        return stream;
+    }
+
+    /**
+     * closes all open streams, waiting for their pending audio to be
+     * processed, and stops the workers.
+     */
+    public void close() {
+        this.closed = true;
+        for (Stream stream : this.streams)
+            stream.close();
+        this.pool.awaitQuiescence(Long.MAX_VALUE, TimeUnit.MILLISECONDS);
+        this.pool.shutdown();
+    }
+
+    private List<SpeechProcessor> createStages() throws Exception {
+        List<SpeechProcessor> stages = new ArrayList<>();
+        try {
+            for (String name : this.stageClasses) {
+                stages.add((SpeechProcessor) Class
+                      .forName(name)
+                      .getConstructor(SpeechConfig.class)
+                      .newInstance(new Object[]{this.config})
+                );
+            }
+        } catch (Exception e) {
+            for (SpeechProcessor stage : stages)
+                stage.close();
+            throw e;
+        }
+        return stages;
+    }
+
+    /**
+     * a single audio stream processed by the host.
+     */
+    public final class Stream implements AutoCloseable {
+        private final AtomicBoolean scheduled = new AtomicBoolean();
+        private final SpeechContext context;
+        private final List<SpeechProcessor> stages;
+        private final FrameBuffer buffer;
+        private final FrameRing queue;
+        private final StageGate gate;
+        private final AtomicBoolean closing = new AtomicBoolean();
+        private volatile boolean enqueuing;
+        private volatile boolean released;
+        private volatile Thread producer;
+        private long position;
+        private long overruns;
+        private boolean managed;
+
+        private Stream(List<SpeechProcessor> processors) {
+            this.stages = processors;
+            this.context = new SpeechContext(config);
+            this.buffer = new FrameBuffer(frameCount, frameSize);
+            this.queue = new FrameRing(queueCount, frameSize);
+            this.gate = new StageGate(processors.size());
+            this.context.attachBuffer(this.buffer);
+        }
+
+        /**
+         * @return the stream's speech context
+         */
+        public SpeechContext getContext() {
+            return this.context;
+        }
+
+        /**
+         * @return the number of frames dropped by
+         * {@link #offer(ByteBuffer)} because the stream's queue was full
+         */
+        public long getOverruns() {
+            return this.queue.getOverruns();
+        }
+
+        /**
+         * @return the number of frames for which each stage was not called,
+         * in stage order, because the stream was not in one of the states
+         * declared by {@link SpeechProcessor#getStates()}
+         */
+        public long[] getSkippedFrames() {
+            return this.gate.getSkipped();
+        }
+
+        /**
+         * queues a frame of audio for processing, if there is room.
+         * called by the stream's producer.
+         * @param frame the audio frame to copy, whose capacity must be the
+         *              configured frame size
+         * @return true if the frame was queued, false if the queue was
+         * full or the stream was closed, and the frame was dropped
+         */
+        public boolean offer(ByteBuffer frame) {
+            checkFrame(frame);
+            this.enqueuing = true;
+            try {
+                if (this.closing.get())
+                    return false;
+                ByteBuffer slot = this.queue.claim();
+                if (slot == null)
+                    return false;
+                enqueue(slot, frame);
+                return true;
+            } finally {
+                this.enqueuing = false;
+            }
+        }
+
+        /**
+         * queues a frame of audio for processing, waiting for room if the
+         * queue is full. called by the stream's producer.
+         * @param frame the audio frame to copy, whose capacity must be the
+         *              configured frame size
+         * @throws InterruptedException if interrupted while waiting
+         * @throws IllegalStateException if the stream is closed
+         */
+        public void write(ByteBuffer frame) throws InterruptedException {
+            checkFrame(frame);
+            while (this.queue.isFull()) {
+                this.producer = Thread.currentThread();
+                if (this.queue.isFull())
+                    LockSupport.park(this);
+                this.producer = null;
+                if (Thread.interrupted())
+                    throw new InterruptedException();
+                if (this.closing.get())
+                    throw new IllegalStateException("closed");
+            }
+            this.enqueuing = true;
+            try {
+                if (this.closing.get())
+                    throw new IllegalStateException("closed");
+                enqueue(this.queue.claim(), frame);
+            } finally {
+                this.enqueuing = false;
+            }
+        }
+
+        /**
+         * closes the stream. audio already queued is processed before the
+         * stream's stages are closed. may be called from any thread, and
+         * more than once.
+         */
+        public void close() {
+            if (this.closing.compareAndSet(false, true))
+                schedule();
+        }
+
+        private void checkFrame(ByteBuffer frame) {
+            if (frame.capacity() != frameSize)
+                throw new IllegalArgumentException("frame");
+        }
+
+        private void enqueue(ByteBuffer slot, ByteBuffer frame) {
+            ByteBuffer source = frame.duplicate();
+            source.clear();
+            slot.put(source);
+            this.queue.publish();
+            schedule();
+        }
+
+        private void schedule() {
+            if (this.scheduled.compareAndSet(false, true))
+                pool.execute(this::drain);
+        }
+
+        private void drain() {
+            if (this.released)
+                return;
+            for (int i = 0; i < QUANTUM && !this.queue.isEmpty(); i++)
+                dispatch();
+
+            // release the stream once its audio has been processed. a
+            // producer that passed the closed check before close may still
+            // be queuing a frame, so the queue is only checked once it
+            // has finished; any later producer sees the stream closed
+            if (this.closing.get()
+                    && !this.enqueuing && this.queue.isEmpty()) {
+                release();
+                return;
+            }
+
+            // yield to other streams, rescheduling if audio was queued
+            // after the last frame was processed
+            this.scheduled.set(false);
+            if (!this.queue.isEmpty() || this.closing.get())
+                schedule();
+        }
+
+        private void dispatch() {
+            try {
+                // cycle the frame store and fill the next frame
+                ByteBuffer frame = this.buffer.rotate();
+                long dropped = this.queue.read(frame);
+                Thread waiter = this.producer;
+                if (waiter != null)
+                    LockSupport.unpark(waiter);
+
+                // timestamp the frame, skipping any frames dropped
+                // between the previous frame and this one
+                if (dropped != this.overruns) {
+                    this.context.traceDebug(
+                        "host: %d frames dropped", dropped - this.overruns);
+                    this.position +=
+                        (dropped - this.overruns) * frame.capacity() / 2;
+                    this.overruns = dropped;
+                }
+                this.context.setSamplePosition(this.position);
+                this.position += frame.capacity() / 2;
+
+                // when leaving the managed state, reset all stages
+                boolean isManaged = this.context.isManaged();
+                if (this.managed && !isManaged) {
+                    for (SpeechProcessor stage : this.stages)
+                        stage.reset();
+                }
+                this.managed = isManaged;
+
+                // dispatch the frame to the stages in their states
+                for (int i = 0; i < this.stages.size(); i++) {
+                    SpeechProcessor stage = this.stages.get(i);
+                    if (!this.managed
+                            && this.gate.admit(i, stage, this.context)) {
+                        frame.rewind();
+                        stage.process(this.context, frame);
+                    }
+                }
+            } catch (Exception e) {
+                raiseError(e);
+            }
+        }
+
+        private void release() {
+            this.released = true;
+            for (SpeechProcessor stage : this.stages) {
+                try {
+                    stage.close();
+                } catch (Exception e) {
+                    raiseError(e);
+                }
+            }
+            this.context.reset();
+            this.context.detachBuffer();
+            streams.remove(this);
+
+            // fail any producer still waiting for room
+            Thread waiter = this.producer;
+            if (waiter != null)
+                LockSupport.unpark(waiter);
+            this.scheduled.set(false);
+        }
+
+        private void raiseError(Throwable e) {
+            this.context.setError(e);
+            this.context.dispatch(SpeechContext.Event.ERROR);
+        }
+    }
+
+    /**
+     * pipeline host builder.
+     */
+    public static final class Builder {
+        private List<String> stageClasses = new ArrayList<>();
+        private SpeechConfig config = new SpeechConfig();
+        private List<OnSpeechEventListener> listeners = new ArrayList<>();
+
+        /**
+         * initializes a new builder instance.
+         */
+        public Builder() {
+            this.config.put("sample-rate", SpeechPipeline.DEFAULT_SAMPLE_RATE);
+            this.config.put("frame-width", SpeechPipeline.DEFAULT_FRAME_WIDTH);
+            this.config.put(
+                "buffer-width",
+                SpeechPipeline.DEFAULT_BUFFER_WIDTH);
+        }
+
+        /**
+         * sets the class names of the stage components in bulk.
+         *
+         * @param value list of stage component names
+         * @return this
+         */
+        public Builder setStageClasses(List<String> value) {
+            this.stageClasses = value;
+            return this;
+        }
+
+        /**
+         * adds a single stage component class name.
+         *
+         * @param value stage component class name
+         * @return this
+         */
+        public Builder addStageClass(String value) {
+            this.stageClasses.add(value);
+            return this;
+        }
+
+        /**
+         * attaches a host configuration object.
+         *
+         * @param value configuration to attach
+         * @return this
+         */
+        public Builder setConfig(SpeechConfig value) {
+            this.config = value;
+            return this;
+        }
+
+        /**
+         * sets a host configuration value.
+         *
+         * @param key   configuration property name
+         * @param value property value
+         * @return this
+         */
+        public Builder setProperty(String key, Object value) {
+            this.config.put(key, value);
+            return this;
+        }
+
+        /**
+         * adds an event listener to every stream.
+         *
+         * @param listen listener callback
+         * @return this
+         */
+        public Builder addOnSpeechEventListener(OnSpeechEventListener listen) {
+            this.listeners.add(listen);
+            return this;
+        }
+
+        /**
+         * creates the pipeline host and starts its workers.
+         *
+         * @return configured host instance
+         */
+        public PipelineHost build() {
+            return new PipelineHost(this);
+        }
+    }
+}
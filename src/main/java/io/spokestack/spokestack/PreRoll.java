@@ -0,0 +1,166 @@
+package io.spokestack.spokestack;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.Iterator;
+import java.util.NoSuchElementException;
+
+/**
+ * a multi-second history of pipeline audio.
+ *
+ * <p>
+ * The pre-roll is a native ring of 16-bit samples that holds the most recent
+ * audio read by the speech pipeline, so that ASR components can send audio
+ * starting at speech onset rather than at activation, without keeping a
+ * long list of frame buffers. Samples are timestamped by their position, the
+ * number of samples written to the pre-roll before them, and can be replayed
+ * from any position that is still held. The ring may optionally store
+ * 8-bit G.711 mu-law samples, halving its memory at a small loss of
+ * fidelity.
+ * </p>
+ *
+ * <p>
+ * The pre-roll is not thread-safe. It is written and read on the pipeline
+ * thread.
+ * </p>
+ */
+public final class PreRoll implements AutoCloseable {
+    // native pre-roll structure handle
+    private final long handle;
+    private final int capacity;
+    private final ByteBuffer chunk;
+    private long position;
+    private long frameStart;
+
+    /**
+     * constructs a new pre-roll instance.
+     * @param samples   the number of samples to store
+     * @param frameSize the size of each pipeline frame, in bytes, which is
+     *                  also the size of each replayed buffer
+     * @param compress  true to store mu-law compressed samples,
+     *                  false to store linear samples
+     */
+    public PreRoll(int samples, int frameSize, boolean compress) {
+        if (samples < 1)
+            throw new IllegalArgumentException("samples");
+        if (frameSize < 2)
+            throw new IllegalArgumentException("frameSize");
+
+        this.capacity = samples;
+        this.chunk = ByteBuffer
+            .allocateDirect(frameSize)
+            .order(ByteOrder.nativeOrder());
+
+        this.handle = create(samples, compress);
+        if (this.handle == 0)
+            throw new OutOfMemoryError();
+    }
+
+    /**
+     * destroys the unmanaged pre-roll instance.
+     */
+    @Override
+    public void close() {
+        destroy(this.handle);
+    }
+
+    /**
+     * @return the maximum number of samples held
+     */
+    public int capacity() {
+        return this.capacity;
+    }
+
+    /**
+     * @return the position of the next sample to be written, which is the
+     * total number of samples written
+     */
+    public long getPosition() {
+        return this.position;
+    }
+
+    /**
+     * @return the position of the oldest sample held
+     */
+    public long getStart() {
+        return Math.max(this.position - this.capacity, 0);
+    }
+
+    /**
+     * @return the position of the first sample of the most recently written
+     * frame
+     */
+    public long getFrameStart() {
+        return this.frameStart;
+    }
+
+    /**
+     * appends a frame of audio, overwriting the oldest samples if the
+     * pre-roll is full.
+     * @param frame the direct audio frame buffer to append
+     */
+    public void write(ByteBuffer frame) {
+        int length = frame.capacity() & ~1;
+        write(this.handle, frame, length);
+        this.frameStart = this.position;
+        this.position += length / 2;
+    }
+
+    /**
+     * copies audio out of the pre-roll.
+     * @param from  the position of the first sample to read, which is
+     *              advanced to {@link #getStart()} if it is no longer held
+     * @param frame the direct buffer to fill, from the start of the buffer;
+     *              its limit is set to the number of bytes read
+     * @return the position of the next sample to read
+     */
+    public long read(long from, ByteBuffer frame) {
+        long start = Math.max(from, getStart());
+        int count = read(this.handle, start, frame, frame.capacity() & ~1);
+        frame.clear();
+        frame.limit(count * 2);
+        return start + count;
+    }
+
+    /**
+     * replays the audio held by the pre-roll, from a position through the
+     * most recently written sample. each buffer returned by the iterator is
+     * a shared, frame-sized chunk that is overwritten on the next iteration,
+     * and is positioned at its start and limited to its valid audio.
+     * @param from the position of the first sample to replay, which is
+     *             advanced to {@link #getStart()} if it is no longer held
+     * @return the replayed audio chunks
+     */
+    public Iterable<ByteBuffer> replay(long from) {
+        long start = Math.max(from, getStart());
+        long end = this.position;
+        return () -> new Iterator<ByteBuffer>() {
+            private long next = start;
+
+            @Override
+            public boolean hasNext() {
+                return this.next < end;
+            }
+
+            @Override
+            public ByteBuffer next() {
+                if (!hasNext())
+                    throw new NoSuchElementException();
+                this.next = read(this.next, chunk);
+                return chunk;
+            }
+        };
+    }
+
+    //-----------------------------------------------------------------------
+    // native interface
+    //-----------------------------------------------------------------------
+    static {
+        System.loadLibrary("spokestack-android");
+    }
+
+    native long create(int samples, boolean compress);
+    native void destroy(long preRoll);
+    native void write(long preRoll, ByteBuffer frame, int length);
+    native int read(long preRoll, long from, ByteBuffer frame, int length);
+}
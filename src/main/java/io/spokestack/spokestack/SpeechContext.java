@@ -6,7 +6,7 @@ import io.spokestack.spokestack.util.EventTracer;
 
 import java.util.Deque;
 import java.util.List;
-import java.util.ArrayList;
+import java.util.concurrent.CopyOnWriteArrayList;
 import java.nio.ByteBuffer;
 
 /**
@@ -17,6 +17,18 @@ import java.nio.ByteBuffer;
  * pipeline components to communicate information among themselves and
  * event handlers.
  * </p>
+ *
+ * <p>
+ * By default, events are dispatched to listeners synchronously, on the
+ * thread that raised them. If the {@code event-dispatch} property is set to
+ * {@code async}, events are instead queued (up to {@code event-queue-size}
+ * events, 64 by default) and delivered on a dedicated dispatcher thread,
+ * along with a snapshot of the context, so that slow listeners cannot stall
+ * audio processing. In this mode, queued TRACE and PARTIAL_RECOGNIZE events
+ * may be dropped or coalesced (see {@link #getDroppedEvents()}), trace
+ * messages are only available to listeners, and changes listeners make to
+ * the snapshot do not affect the context.
+ * </p>
  */
 public final class SpeechContext {
     /** speech event types. */
@@ -49,10 +61,18 @@ public final class SpeechContext {
         }
     }
 
-    private final List<OnSpeechEventListener> listeners = new ArrayList<>();
+    /** default asynchronous event queue size. */
+    public static final int DEFAULT_EVENT_QUEUE_SIZE = 64;
+
+    private final List<OnSpeechEventListener> listeners =
+        new CopyOnWriteArrayList<>();
     private final EventTracer tracer;
+    private final EventDispatcher dispatcher;
     private Context appContext;
     private Deque<ByteBuffer> buffer;
+    private PreRoll preRoll;
+    private long speechOnset = -1;
+    private long samplePosition;
     private boolean speech;
     private boolean active;
     private boolean managed;
@@ -71,6 +91,20 @@ public final class SpeechContext {
             EventTracer.Level.NONE.value());
 
         this.tracer = new EventTracer(traceLevel);
+
+        String dispatch = config.getString("event-dispatch", "sync");
+        if (dispatch.equals("sync")) {
+            this.dispatcher = null;
+        } else if (dispatch.equals("async")) {
+            this.dispatcher = new EventDispatcher(
+                this,
+                this.listeners,
+                config.getInteger(
+                    "event-queue-size",
+                    DEFAULT_EVENT_QUEUE_SIZE));
+        } else {
+            throw new IllegalArgumentException("event-dispatch");
+        }
     }
 
     /**
@@ -89,7 +123,11 @@ public final class SpeechContext {
         this.appContext = androidContext;
     }
 
-    /** @return speech frame buffer */
+    /**
+     * @return speech frame buffer, ordered from oldest to newest frame. the
+     * speech pipeline attaches a fixed-size {@link FrameBuffer}, which
+     * supports iteration but not modification
+     */
     public Deque<ByteBuffer> getBuffer() {
         return this.buffer;
     }
@@ -113,6 +151,79 @@ public final class SpeechContext {
         return this;
     }
 
+    /**
+     * @return the pre-roll audio history, or null if none is attached
+     */
+    @Nullable
+    public PreRoll getPreRoll() {
+        return this.preRoll;
+    }
+
+    /**
+     * attaches a pre-roll audio history to the context.
+     * @param value pre-roll to attach
+     * @return this
+     */
+    public SpeechContext attachPreRoll(PreRoll value) {
+        this.preRoll = value;
+        this.speechOnset = -1;
+        return this;
+    }
+
+    /**
+     * removes the attached pre-roll audio history.
+     * @return this
+     */
+    public SpeechContext detachPreRoll() {
+        this.preRoll = null;
+        this.speechOnset = -1;
+        return this;
+    }
+
+    /**
+     * @return the pre-roll position of the first sample of the frame in
+     * which speech was most recently detected, or -1 if speech has not been
+     * detected or no pre-roll is attached
+     */
+    public long getSpeechOnset() {
+        return this.speechOnset;
+    }
+
+    /**
+     * returns the audio that ASR components should send when recognition
+     * begins. if a pre-roll is attached and speech has been detected, this
+     * is the pre-roll audio from speech onset through the current frame;
+     * otherwise, it is the frame buffer. buffers returned by the replay
+     * may be shared and partially filled, so they should be consumed from
+     * position to limit before advancing the iterator.
+     * @return the audio to send, ordered from oldest to newest
+     */
+    public Iterable<ByteBuffer> getReplay() {
+        if (this.preRoll != null && this.speechOnset >= 0)
+            return this.preRoll.replay(this.speechOnset);
+        return this.buffer;
+    }
+
+    /**
+     * @return the stream position, in samples, of the first sample of the
+     * frame being processed, which timestamps events raised during its
+     * processing. this is the number of samples read by the pipeline
+     * before the frame
+     */
+    public long getSamplePosition() {
+        return this.samplePosition;
+    }
+
+    /**
+     * sets the stream position of the frame being processed.
+     * @param value the position of the frame's first sample
+     * @return this
+     */
+    public SpeechContext setSamplePosition(long value) {
+        this.samplePosition = value;
+        return this;
+    }
+
     /** @return speech detected indicator */
     public boolean isSpeech() {
         return this.speech;
@@ -124,6 +235,8 @@ public final class SpeechContext {
      * @return this
      */
     public SpeechContext setSpeech(boolean value) {
+        if (value && !this.speech && this.preRoll != null)
+            this.speechOnset = this.preRoll.getFrameStart();
         this.speech = value;
         return this;
     }
@@ -219,6 +332,22 @@ public final class SpeechContext {
         return this.message;
     }
 
+    /**
+     * sets the current trace message, for dispatcher snapshots.
+     * @param value the message to assign
+     */
+    void setMessage(String value) {
+        this.message = value;
+    }
+
+    /**
+     * @return the number of events dropped by asynchronous dispatch because
+     * the event queue was full, or 0 for synchronous dispatch
+     */
+    public long getDroppedEvents() {
+        return this.dispatcher != null ? this.dispatcher.getDropped() : 0;
+    }
+
     /**
      * resets the context to the default state.
      * @return this
@@ -230,6 +359,7 @@ public final class SpeechContext {
         setTranscript("");
         setConfidence(0);
         setError(null);
+        this.speechOnset = -1;
         this.message = null;
         return this;
     }
@@ -285,8 +415,13 @@ public final class SpeechContext {
             String format,
             Object... params) {
         if (this.tracer.canTrace(level)) {
-            this.message = String.format(format, params);
-            dispatch(Event.TRACE);
+            // asynchronous traces are formatted by the dispatcher
+            if (this.dispatcher != null) {
+                this.dispatcher.post(this, Event.TRACE, format, params);
+            } else {
+                this.message = String.format(format, params);
+                dispatch(Event.TRACE);
+            }
         }
         return this;
     }
@@ -297,6 +432,10 @@ public final class SpeechContext {
      * @return this
      */
     public SpeechContext dispatch(Event event) {
+        if (this.dispatcher != null) {
+            this.dispatcher.post(this, event, null, null);
+            return this;
+        }
         for (OnSpeechEventListener listener: this.listeners) {
             try {
                 listener.onEvent(event, this);
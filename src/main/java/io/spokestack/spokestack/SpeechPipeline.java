@@ -1,9 +1,14 @@
 package io.spokestack.spokestack;
 
 import android.content.Context;
+import io.spokestack.spokestack.util.EventTracer;
+import io.spokestack.spokestack.util.LatencyHistogram;
+import io.spokestack.spokestack.util.StartupTimeline;
+import io.spokestack.spokestack.util.TraceRing;
 
+import java.io.EOFException;
 import java.util.ArrayList;
-import java.util.LinkedList;
+import java.util.Collections;
 import java.util.List;
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
@@ -46,6 +51,76 @@ import java.nio.ByteOrder;
  * </p>
  *
  * <p>
+ * Restarting a stopped pipeline recreates all of its stages, reloading their
+ * models and native state. To stop listening briefly, such as during TTS
+ * playback or while the app is in the background, the pipeline can instead
+ * be paused via {@link #pause()}, which retains the microphone, or placed
+ * in warm standby via {@link #standby()}, which releases only the
+ * microphone. Setting the {@code pause-mode} property to {@code standby}
+ * (default {@code hold}) makes {@link #pause()} enter standby.
+ * </p>
+ *
+ * <p>
+ * By default, audio is read from the input on the pipeline's thread, between
+ * runs of the pipeline stages. If the {@code capture-buffer-width} property
+ * (in ms) is set, audio is instead read on a dedicated, high-priority capture
+ * thread into a lock-free frame ring of that width, so that a slow stage or
+ * event handler does not delay the next read and overrun the input device.
+ * Frames dropped because the ring was full are reported by
+ * {@link #getCaptureOverruns()}.
+ * </p>
+ *
+ * <p>
+ * The frame buffer attached to the speech context holds only
+ * {@code buffer-width} ms of audio. If the {@code preroll-width} property
+ * (in ms) is set, the pipeline also records that much audio in a native
+ * {@link PreRoll} history, so that ASR components can replay audio from
+ * speech onset via {@link SpeechContext#getReplay()}. Setting
+ * {@code preroll-compression} to {@code mulaw} stores the history as
+ * 8-bit mu-law samples, halving its memory.
+ * </p>
+ *
+ * <p>
+ * The pipeline is paced by its input. To process recorded audio faster than
+ * real time, such as when regression testing over audio files, configure a
+ * {@link FileInput} and call {@link #runBatch()}, which runs the pipeline to
+ * the end of the input on the calling thread. An input signals the end of
+ * its audio by throwing {@link EOFException}, which stops the pipeline
+ * without raising an error. During processing,
+ * {@link SpeechContext#getSamplePosition()} holds the stream position of
+ * the current frame, which timestamps events to the sample.
+ * </p>
+ *
+ * <p>
+ * The pipeline records the time taken by each stage to process a frame, and
+ * by all stages together, in latency histograms exposed by
+ * {@link #getStageLatencies()} and {@link #getFrameLatency()}. Frames whose
+ * processing took longer than the frame width are counted by
+ * {@link #getDeadlineOverruns()}. At the PERF trace level, the histograms
+ * are traced every {@code latency-trace-interval} ms of audio (10s by
+ * default). Stages are only called in the pipeline states they declare
+ * (see {@link SpeechProcessor#getStates()}), and the frames each stage
+ * skipped are counted by {@link #getSkippedFrames()}.
+ * </p>
+ *
+ * <p>
+ * Each start of the pipeline records a {@link StartupTimeline}, exposed by
+ * {@link #getStartupTimeline()}, containing the time taken to construct the
+ * input and each stage (along with the model loads, metadata parsing, and
+ * native instance creation within them), and the time to the first frame
+ * processed by the stages. The timeline is traced at the PERF level after
+ * the first frame, and can be exported as JSON in order to track cold-start
+ * regressions.
+ * </p>
+ *
+ * <p>
+ * Setting {@code trace-ring-size} (in records) enables the process-wide
+ * {@link TraceRing}, which records structured events, such as per-frame
+ * latencies and wakeword posteriors, without formatting them, for export
+ * to Perfetto.
+ * </p>
+ *
+ * <p>
  * When running, the pipeline communicates with the client via the event
  * interface on the speech context. All calls to event handlers are made in the
  * context of the pipeline's thread, so event handlers should not perform
@@ -66,18 +141,53 @@ public final class SpeechPipeline implements AutoCloseable {
      * audio frame buffer width, in ms.
      */
     public static final int DEFAULT_BUFFER_WIDTH = 20;
+    /**
+     * latency trace interval default, in ms of audio.
+     */
+    public static final int DEFAULT_LATENCY_TRACE_INTERVAL = 10000;
+
+    // per-frame latency trace ring event
+    private static final int TRACE_FRAME = TraceRing.register(
+        "frame",
+        "frame: %.3fms",
+        "latency");
 
     private final Object lock = new Object();
+    private final Object captureLock = new Object();
     private final String inputClass;
     private final List<String> stageClasses;
     private final SpeechConfig config;
     private final SpeechContext context;
     private volatile boolean running;
     private volatile boolean paused;
+    private volatile boolean standby;
+    private final boolean standbyOnPause;
     private SpeechInput input;
     private List<SpeechProcessor> stages;
     private Thread thread;
     private boolean managed;
+    private FrameBuffer buffer;
+    private PreRoll preRoll;
+    private FrameRing ring;
+    private ByteBuffer overflow;
+    private Thread captureThread;
+    private volatile boolean capturing;
+    private volatile Exception captureError;
+    private long captureTimeout;
+    private long overruns;
+    private long position;
+    private volatile List<LatencyHistogram> stageLatencies =
+        Collections.emptyList();
+    private volatile LatencyHistogram frameLatency = new LatencyHistogram();
+    private volatile StageGate gate = new StageGate(0);
+    private volatile long deadlineOverruns;
+    private long deadline;
+    private int traceInterval;
+    private int traceFrames;
+    private volatile long resumeStart;
+    private volatile long resumeLatency;
+    private volatile StartupTimeline startup = new StartupTimeline();
+    private boolean startupPending;
 
     /**
      * initializes a new speech pipeline instance.
@@ -89,6 +199,13 @@ public final class SpeechPipeline implements AutoCloseable {
         this.stageClasses = builder.stageClasses;
         this.config = builder.config;
         this.context = new SpeechContext(this.config);
+        String pauseMode = this.config.getString("pause-mode", "hold");
+        if (pauseMode.equals("hold"))
+            this.standbyOnPause = false;
+        else if (pauseMode.equals("standby"))
+            this.standbyOnPause = true;
+        else
+            throw new IllegalArgumentException("pause-mode");
         this.context.setAndroidContext(builder.appContext);
         this.stages = new ArrayList<>();
 
@@ -133,6 +250,83 @@ public final class SpeechPipeline implements AutoCloseable {
         return this.paused;
     }
 
+    /**
+     * @return the number of frames dropped by the capture thread because
+     * the pipeline stages fell behind, or 0 if no capture thread is used
+     */
+    public long getCaptureOverruns() {
+        FrameRing frames = this.ring;
+        return frames != null ? frames.getOverruns() : 0;
+    }
+
+    /**
+     * @return the number of times the pipeline waited longer than two frame
+     * widths for captured audio, or 0 if no capture thread is used
+     */
+    public long getCaptureUnderruns() {
+        FrameRing frames = this.ring;
+        return frames != null ? frames.getUnderruns() : 0;
+    }
+
+    /**
+     * @return the processing time histogram of each stage, in stage order,
+     * for the current or most recent run of the pipeline
+     */
+    public List<LatencyHistogram> getStageLatencies() {
+        return this.stageLatencies;
+    }
+
+    /**
+     * @return the histogram of the time taken by all stages to process each
+     * frame, for the current or most recent run of the pipeline
+     */
+    public LatencyHistogram getFrameLatency() {
+        return this.frameLatency;
+    }
+
+    /**
+     * @return the number of frames whose processing took longer than the
+     * frame width, for the current or most recent run of the pipeline
+     */
+    public long getDeadlineOverruns() {
+        return this.deadlineOverruns;
+    }
+
+    /**
+     * @return the number of frames for which each stage was not called,
+     * in stage order, because the pipeline was not in one of the states
+     * declared by {@link SpeechProcessor#getStates()}, for the current or
+     * most recent run of the pipeline
+     */
+    public long[] getSkippedFrames() {
+        return this.gate.getSkipped();
+    }
+
+    /**
+     * @return the time taken by the most recent {@link #resume()} to read
+     * the first frame of audio, in nanoseconds, or 0 if the pipeline has
+     * not been resumed
+     */
+    public long getResumeLatency() {
+        return this.resumeLatency;
+    }
+
+    /**
+     * @return the startup timeline for the current or most recent start of
+     * the pipeline. spans recorded by models loading in the background may
+     * be added after the pipeline has started.
+     */
+    public StartupTimeline getStartupTimeline() {
+        return this.startup;
+    }
+
+    /**
+     * @return true if the pipeline is in warm standby, false otherwise
+     */
+    public boolean isStandby() {
+        return this.standby;
+    }
+
     /** manually activate the speech pipeline. */
     public void activate() {
         this.context.setActive(true);
@@ -150,6 +344,45 @@ public final class SpeechPipeline implements AutoCloseable {
         }
     }
 
+    /**
+     * replaces the models of the running pipeline's stages, such as the
+     * wakeword or keyword models, without stopping the pipeline. each stage
+     * loads the models named in the configuration and swaps them in between
+     * frames.
+     *
+     * <p>
+     * If any stage rejects the swap (such as by failing to load its models
+     * on the calling thread), the swap is cancelled in every stage that
+     * accepted it, so that all stages keep their current models, and the
+     * stage's exception is rethrown. Models that load in the background
+     * are only checked once they have loaded; a stage whose new models fail
+     * then raises an error event and keeps its current models, while other
+     * stages may already have swapped theirs.
+     * </p>
+     *
+     * @param modelConfig the configuration containing the new model paths
+     * @return true if any stage accepted the new models, false otherwise
+     * @throws IllegalStateException if the pipeline is not running
+     */
+    public synchronized boolean swapModels(SpeechConfig modelConfig) {
+        // the stages are closed under this monitor once the pipeline stops,
+        // so they remain open for the rest of the swap
+        if (!this.running)
+            throw new IllegalStateException("not running");
+        List<SpeechProcessor> accepted = new ArrayList<>();
+        try {
+            for (SpeechProcessor stage : this.stages) {
+                if (stage.swapModels(modelConfig))
+                    accepted.add(stage);
+            }
+        } catch (RuntimeException e) {
+            for (SpeechProcessor stage : accepted)
+                stage.cancelSwap();
+            throw e;
+        }
+        return !accepted.isEmpty();
+    }
+
     /**
      * Add a new listener to receive events from the speech pipeline.
      * @param listener The listener to add.
@@ -180,7 +413,8 @@ public final class SpeechPipeline implements AutoCloseable {
 
         try {
             createComponents();
-            attachBuffer();
+            attachBuffer(true);
+            attachMetrics();
             startThread();
         } catch (Throwable e) {
             stop();
@@ -188,24 +422,97 @@ public final class SpeechPipeline implements AutoCloseable {
         }
     }
 
+    /**
+     * runs the speech pipeline to the end of its input on the calling
+     * thread, and releases all resources.
+     *
+     * <p>
+     * Frames are read and processed as fast as the input and stages allow,
+     * and events are dispatched on the calling thread. The capture thread is
+     * never used, so that no frames are dropped. Processing ends when the
+     * input throws {@link EOFException} (such as {@link FileInput} at the
+     * end of its file), when an input error occurs, or when the pipeline is
+     * stopped from another thread.
+     * </p>
+     *
+     * @throws Exception on configuration/startup error
+     */
+    public void runBatch() throws Exception {
+        if (this.running)
+            throw new IllegalStateException("running");
+
+        createComponents();
+        attachBuffer(false);
+        attachMetrics();
+        this.running = true;
+        run();
+    }
+
     private void createComponents() throws Exception {
-        // create the audio input component
-        this.input = (SpeechInput) Class
+        // attach a new startup timeline to this thread, so that the
+        // components can record the work done by their constructors
+        StartupTimeline timeline = new StartupTimeline();
+        this.startup = timeline;
+        this.startupPending = true;
+        timeline.attach();
+        try {
+            // create the audio input component
+            long start = System.nanoTime();
+            this.input = createInput();
+            timeline.add(simpleName(this.inputClass), start, System.nanoTime());
+
+            // create the pipeline stage components
+            for (String name : this.stageClasses) {
+                String stageName = simpleName(name);
+                timeline.setScope(stageName);
+                start = System.nanoTime();
+                this.stages.add((SpeechProcessor) Class
+                      .forName(name)
+                      .getConstructor(SpeechConfig.class)
+                      .newInstance(new Object[]{this.config})
+                );
+                timeline.setScope("");
+                timeline.add(stageName, start, System.nanoTime());
+            }
+        } finally {
+            timeline.setScope("");
+            StartupTimeline.detach();
+        }
+    }
+
+    private static String simpleName(String className) {
+        return className.substring(className.lastIndexOf('.') + 1);
+    }
+
+    private SpeechInput createInput() throws Exception {
+        return (SpeechInput) Class
               .forName(this.inputClass)
               .getConstructor(SpeechConfig.class)
               .newInstance(new Object[]{this.config});
+    }
+
+    private void releaseInput() {
+        stopCapture();
+        try {
+            this.input.close();
+        } catch (Exception e) {
+            raiseError(e);
+        }
+        this.input = null;
+        this.context.traceDebug("standby: input released");
+    }
 
-        // create the pipeline stage components
-        for (String name : this.stageClasses) {
-            this.stages.add((SpeechProcessor) Class
-                  .forName(name)
-                  .getConstructor(SpeechConfig.class)
-                  .newInstance(new Object[]{this.config})
-            );
+    private void acquireInput() {
+        try {
+            this.input = createInput();
+            startCapture();
+        } catch (Exception e) {
+            raiseError(e);
+            this.running = false;
         }
     }
 
-    private void attachBuffer() throws Exception {
+    private void attachBuffer(boolean capture) throws Exception {
         // compute the frame size and number of buffers
         int sampleWidth = 2;
         int sampleRate = this.config.getInteger("sample-rate");
@@ -214,22 +521,91 @@ public final class SpeechPipeline implements AutoCloseable {
         int frameSize = sampleRate * frameWidth / 1000 * sampleWidth;
         int frameCount = Math.max(bufferWidth / frameWidth, 1);
 
-        // allocate the deque of frame buffers
-        LinkedList<ByteBuffer> buffer = new LinkedList<>();
-        for (int i = 0; i < frameCount; i++) {
-            buffer.addLast(ByteBuffer
-                  .allocateDirect(frameSize)
-                  .order(ByteOrder.nativeOrder()));
-        }
+        // allocate the circular store of frame buffers
+        this.buffer = new FrameBuffer(frameCount, frameSize);
 
         // attach the buffers to the speech context
-        this.context.attachBuffer(buffer);
+        this.context.attachBuffer(this.buffer);
+        this.position = 0;
+        this.context.setSamplePosition(0);
+
+        // allocate the pre-roll audio history, if enabled
+        int preRollWidth = this.config.getInteger("preroll-width", 0);
+        if (preRollWidth > 0) {
+            String compression =
+                this.config.getString("preroll-compression", "none");
+            boolean compress;
+            if (compression.equals("none"))
+                compress = false;
+            else if (compression.equals("mulaw"))
+                compress = true;
+            else
+                throw new IllegalArgumentException("preroll-compression");
+
+            long start = System.nanoTime();
+            this.preRoll = new PreRoll(
+                (int) ((long) sampleRate * preRollWidth / 1000),
+                frameSize,
+                compress);
+            this.startup.add("PreRoll", start, System.nanoTime());
+            this.context.attachPreRoll(this.preRoll);
+        }
+
+        // allocate the capture ring, if enabled
+        int captureWidth = this.config.getInteger("capture-buffer-width", 0);
+        this.ring = null;
+        if (capture && captureWidth > 0) {
+            this.ring = new FrameRing(
+                Math.max(captureWidth / frameWidth, 1),
+                frameSize);
+            this.captureTimeout = frameWidth * 2;
+            this.overruns = 0;
+
+            // frames read while the ring is full are dropped into this
+            // buffer, in order to keep the input device drained
+            this.overflow = ByteBuffer
+                .allocateDirect(frameSize)
+                .order(ByteOrder.nativeOrder());
+        }
+    }
+
+    private void attachMetrics() {
+        List<LatencyHistogram> latencies = new ArrayList<>();
+        for (int i = 0; i < this.stages.size(); i++)
+            latencies.add(new LatencyHistogram());
+        this.stageLatencies = Collections.unmodifiableList(latencies);
+        this.frameLatency = new LatencyHistogram();
+        this.gate = new StageGate(this.stages.size());
+        this.deadlineOverruns = 0;
+
+        int frameWidth = this.config.getInteger("frame-width");
+        int interval = this.config.getInteger(
+            "latency-trace-interval",
+            DEFAULT_LATENCY_TRACE_INTERVAL);
+        this.deadline = frameWidth * 1000000L;
+        this.traceInterval = Math.max(interval / frameWidth, 0);
+        this.traceFrames = 0;
+
+        int traceRingSize = this.config.getInteger("trace-ring-size", 0);
+        if (traceRingSize > 0)
+            TraceRing.enable(traceRingSize);
     }
 
     private void startThread() throws Exception {
         this.thread = new Thread(this::run, "Spokestack-speech-pipeline");
         this.running = true;
         this.thread.start();
+        startCapture();
+    }
+
+    private void startCapture() {
+        if (this.ring != null) {
+            this.capturing = true;
+            this.captureThread =
+                new Thread(this::capture, "Spokestack-speech-capture");
+            this.captureThread.setPriority(Thread.MAX_PRIORITY);
+            this.captureThread.start();
+        }
     }
 
     /**
@@ -247,23 +623,58 @@ public final class SpeechPipeline implements AutoCloseable {
      * While paused, the pipeline will not respond to the wakeword, but
      * in order to support a quick {@link #resume()}, it will retain control
      * of the microphone. No audio is explicitly read or analyzed. To fully
-     * release the pipeline's resources, see {@link #stop()}.
+     * release the pipeline's resources, see {@link #stop()}. If the
+     * {@code pause-mode} property is set to {@code standby}, the pipeline
+     * enters warm standby instead (see {@link #standby()}).
      * </p>
      */
     public void pause() {
+        if (this.standbyOnPause) {
+            standby();
+            return;
+        }
+        deactivate();
+        this.paused = true;
+    }
+
+    /**
+     * Pauses the speech pipeline in warm standby, releasing the microphone.
+     *
+     * <p>
+     * In standby, the pipeline closes its input (and stops its capture
+     * thread), so that other components, such as a TTS player or another
+     * app, can use the microphone. The pipeline thread, its stages, their
+     * models and native state, and the frame buffers all remain allocated,
+     * so that {@link #resume()} only needs to reopen the input rather than
+     * recreate the pipeline, as {@link #start()} would after a
+     * {@link #stop()}. As with {@link #pause()}, the pipeline is deactivated
+     * before it enters standby.
+     * </p>
+     */
+    public void standby() {
         deactivate();
+        this.standby = true;
         this.paused = true;
+        synchronized (lock) {
+            lock.notify();
+        }
     }
 
     /**
      * Resumes a paused speech pipeline, returning the pipeline to a passive
-     * listening state.
+     * listening state. The time taken to read the first frame after resuming
+     * is reported by {@link #getResumeLatency()}.
      */
     public void resume() {
+        this.resumeStart = System.nanoTime();
+        this.standby = false;
         this.paused = false;
         synchronized (lock) {
             lock.notify();
         }
+        synchronized (captureLock) {
+            captureLock.notify();
+        }
     }
 
     /**
@@ -272,10 +683,22 @@ public final class SpeechPipeline implements AutoCloseable {
     public void stop() {
         if (this.running) {
             this.running = false;
-            try {
-                this.thread.join();
-            } catch (InterruptedException e) {
-                // ignore
+            synchronized (captureLock) {
+                captureLock.notify();
+            }
+            // wake the pipeline thread if it is paused
+            synchronized (lock) {
+                lock.notify();
+            }
+            // the pipeline thread stops itself on input errors,
+            // and cannot wait for itself to exit
+            if (this.thread != null
+                    && Thread.currentThread() != this.thread) {
+                try {
+                    this.thread.join();
+                } catch (InterruptedException e) {
+                    // ignore
+                }
             }
             this.thread = null;
         }
@@ -292,11 +715,20 @@ public final class SpeechPipeline implements AutoCloseable {
 
     private void step() {
         if (this.paused) {
+            // release the microphone in standby
+            if (this.standby && this.input != null)
+                releaseInput();
             try {
                 lock.wait();
             } catch (InterruptedException e) {
                 this.running = false;
             }
+            // reopen the microphone when resuming from standby
+            if (!this.paused && this.running && this.input == null)
+                acquireInput();
+            // discard audio captured before the pause
+            if (this.ring != null)
+                this.ring.clear();
         } else {
             dispatch();
         }
@@ -307,18 +739,51 @@ public final class SpeechPipeline implements AutoCloseable {
 
     private void dispatch() {
         try {
-            // cycle the deque and fetch the next frame to write
-            ByteBuffer frame = this.context.getBuffer().removeFirst();
-            this.context.getBuffer().addLast(frame);
+            // wait for captured audio, if it is read on the capture thread
+            try {
+                if (!awaitCapture())
+                    return;
+            } catch (EOFException e) {
+                stop();
+                return;
+            } catch (Exception e) {
+                raiseError(e);
+                stop();
+                return;
+            }
+
+            // cycle the frame store and fetch the next frame to write
+            ByteBuffer frame = this.buffer.rotate();
 
             // fill the frame from the input, stopping if audio cannot be read
             try {
-                this.input.read(this.context, frame);
+                readFrame(frame);
+            } catch (EOFException e) {
+                stop();
+                return;
             } catch (Exception e) {
                 raiseError(e);
                 stop();
             }
 
+            // report the time taken to resume listening
+            long resumed = this.resumeStart;
+            if (resumed != 0) {
+                this.resumeStart = 0;
+                this.resumeLatency = System.nanoTime() - resumed;
+                this.context.tracePerf(
+                    "resume: %.2fms",
+                    this.resumeLatency / 1e6);
+            }
+
+            // timestamp the frame
+            this.context.setSamplePosition(this.position);
+            this.position += frame.capacity() / 2;
+
+            // record the frame in the audio history
+            if (this.preRoll != null)
+                this.preRoll.write(frame);
+
             // when leaving the managed state, reset all stages internally
             boolean isManaged = this.context.isManaged();
             if (this.managed && !isManaged) {
@@ -328,11 +793,24 @@ public final class SpeechPipeline implements AutoCloseable {
             }
             this.managed = isManaged;
 
-            // dispatch the frame to the stages
-            for (SpeechProcessor stage : this.stages) {
-                if (!this.managed) {
+            // dispatch the frame to the stages, timing each stage
+            if (!this.managed) {
+                long frameStart = System.nanoTime();
+                long stageStart = frameStart;
+                for (int i = 0; i < this.stages.size(); i++) {
+                    SpeechProcessor stage = this.stages.get(i);
+                    if (!this.gate.admit(i, stage, this.context))
+                        continue;
                     frame.rewind();
                     stage.process(this.context, frame);
+                    long stageEnd = System.nanoTime();
+                    this.stageLatencies.get(i).record(stageEnd - stageStart);
+                    stageStart = stageEnd;
+                }
+                recordFrame(stageStart - frameStart);
+                if (this.startupPending) {
+                    this.startupPending = false;
+                    reportStartup(stageStart);
                 }
             }
         } catch (Exception e) {
@@ -340,25 +818,151 @@ public final class SpeechPipeline implements AutoCloseable {
         }
     }
 
-    private void cleanup() {
-        for (SpeechProcessor stage : this.stages) {
-            try {
-                stage.close();
-            } catch (Exception e) {
-                raiseError(e);
+    private void recordFrame(long elapsed) {
+        this.frameLatency.record(elapsed);
+        TraceRing.record(TRACE_FRAME, elapsed / 1e6);
+        if (elapsed > this.deadline)
+            this.deadlineOverruns++;
+
+        // periodically trace the latency histograms
+        if (this.traceInterval > 0
+                && ++this.traceFrames >= this.traceInterval) {
+            this.traceFrames = 0;
+            if (this.context.canTrace(EventTracer.Level.PERF)) {
+                for (int i = 0; i < this.stages.size(); i++) {
+                    this.context.tracePerf(
+                        "latency: %s %s skipped %d",
+                        this.stages.get(i).getClass().getSimpleName(),
+                        this.stageLatencies.get(i),
+                        this.gate.getSkipped(i));
+                }
+                this.context.tracePerf(
+                    "latency: frame %s overruns %d",
+                    this.frameLatency,
+                    this.deadlineOverruns);
+            }
+        }
+    }
+
+    private void reportStartup(long firstFrame) {
+        StartupTimeline timeline = this.startup;
+        timeline.add("first frame", timeline.getOrigin(), firstFrame);
+        if (this.context.canTrace(EventTracer.Level.PERF))
+            this.context.tracePerf("startup: %s", timeline);
+    }
+
+    private boolean awaitCapture() throws Exception {
+        if (this.ring == null)
+            return true;
+        while (!this.ring.await(this.captureTimeout)) {
+            // surface capture failures on the pipeline thread
+            Exception error = this.captureError;
+            if (error != null) {
+                this.captureError = null;
+                throw error;
             }
+            if (!this.running
+                    || this.paused
+                    || Thread.currentThread().isInterrupted())
+                return false;
         }
-        this.stages.clear();
+        return true;
+    }
 
+    private void readFrame(ByteBuffer frame) throws Exception {
+        if (this.ring == null) {
+            this.input.read(this.context, frame);
+            return;
+        }
+        // report frames dropped between the previous frame and this one,
+        // which was stamped when it was captured, so that frames captured
+        // before a drop keep their timestamps
+        long dropped = this.ring.read(frame);
+        if (dropped != this.overruns) {
+            this.context.traceDebug(
+                "capture: %d frames dropped", dropped - this.overruns);
+
+            // keep timestamps aligned with the input
+            this.position += (dropped - this.overruns) * frame.capacity() / 2;
+            this.overruns = dropped;
+        }
+    }
+
+    private void capture() {
         try {
-            this.input.close();
+            while (this.running && this.capturing) {
+                if (this.paused) {
+                    synchronized (captureLock) {
+                        while (this.paused && this.running && this.capturing)
+                            captureLock.wait();
+                    }
+                    continue;
+                }
+                ByteBuffer frame = this.ring.claim();
+                if (frame != null) {
+                    this.input.read(this.context, frame);
+                    this.ring.publish();
+                } else {
+                    this.overflow.rewind();
+                    this.input.read(this.context, this.overflow);
+                }
+            }
+        } catch (InterruptedException e) {
+            // exit
         } catch (Exception e) {
-            raiseError(e);
+            this.captureError = e;
+        }
+    }
+
+    private void stopCapture() {
+        if (this.captureThread != null) {
+            this.capturing = false;
+            synchronized (captureLock) {
+                captureLock.notify();
+            }
+            try {
+                this.captureThread.join();
+            } catch (InterruptedException e) {
+                // ignore
+            }
+            this.captureThread = null;
+        }
+    }
+
+    private void cleanup() {
+        stopCapture();
+
+        // close the stages under the monitor held by model swaps,
+        // so that a swap never reaches a closed stage
+        synchronized (this) {
+            for (SpeechProcessor stage : this.stages) {
+                try {
+                    stage.close();
+                } catch (Exception e) {
+                    raiseError(e);
+                }
+            }
+            this.stages.clear();
+        }
+
+        if (this.input != null) {
+            try {
+                this.input.close();
+            } catch (Exception e) {
+                raiseError(e);
+            }
+            this.input = null;
         }
-        this.input = null;
 
         this.context.reset();
         this.context.detachBuffer();
+        this.buffer = null;
+
+        if (this.preRoll != null) {
+            this.context.detachPreRoll();
+            this.preRoll.close();
+            this.preRoll = null;
+        }
     }
 
     private void raiseError(Throwable e) {
@@ -1,6 +1,9 @@
 package io.spokestack.spokestack;
 
 import java.nio.ByteBuffer;
+import java.util.Collections;
+import java.util.EnumSet;
+import java.util.Set;
 
 /**
  * speech pipeline processor interface.
@@ -15,8 +18,62 @@ import java.nio.ByteBuffer;
  * To be used in a speech pipeline, an implementing class must provide
  * a constructor that accepts a {@link SpeechConfig} instance.
  * </p>
+ *
+ * <p>
+ * A stage that only needs to see frames in some pipeline states, such as a
+ * speech recognizer that is idle until the pipeline is activated, can
+ * declare them via {@link #getStates()}. The pipeline skips the stage on
+ * frames outside those states, except for the first frame after the
+ * pipeline leaves them, so that the stage can observe the transition
+ * (for example, to commit a recognition on deactivation).
+ * </p>
  */
 public interface SpeechProcessor extends AutoCloseable {
+    /**
+     * pipeline states, used to gate calls to stages.
+     */
+    enum State {
+        /** the pipeline is inactive, and no speech is detected. */
+        IDLE,
+        /** the pipeline is inactive, and speech is detected. */
+        SPEECH,
+        /** the pipeline is active. */
+        ACTIVE;
+
+        /**
+         * determines the pipeline state of a speech context.
+         * @param context the speech context
+         * @return the context's current state
+         */
+        public static State of(SpeechContext context) {
+            if (context.isActive())
+                return ACTIVE;
+            return context.isSpeech() ? SPEECH : IDLE;
+        }
+    }
+
+    /** all pipeline states, the default for {@link #getStates()}. */
+    Set<State> ALL_STATES =
+        Collections.unmodifiableSet(EnumSet.allOf(State.class));
+
+    /** the active state only, for stages that run during activation. */
+    Set<State> ACTIVE_STATES =
+        Collections.unmodifiableSet(EnumSet.of(State.ACTIVE));
+
+    /** the inactive states, for stages that run until activation. */
+    Set<State> INACTIVE_STATES =
+        Collections.unmodifiableSet(EnumSet.of(State.IDLE, State.SPEECH));
+
+    /**
+     * returns the pipeline states in which the stage should be called. this
+     * method is called before every frame, so it should return a constant
+     * (or cached) set, although the set may change as the stage's needs do.
+     * @return the states in which to call the stage
+     */
+    default Set<State> getStates() {
+        return ALL_STATES;
+    }
+
     /**
      * processes the current speech frame.
      * @param context the current speech context
@@ -30,4 +87,24 @@ public interface SpeechProcessor extends AutoCloseable {
      * @throws Exception on error
      */
     void reset() throws Exception;
+
+    /**
+     * replaces the stage's models while the pipeline is running. stages
+     * that support this load the models named in the configuration without
+     * blocking the pipeline thread, and swap them in between frames.
+     * @param config the configuration containing the new model paths
+     * @return true if the stage accepted the new models, false if the
+     * configuration does not refer to them (the default)
+     */
+    default boolean swapModels(SpeechConfig config) {
+        return false;
+    }
+
+    /**
+     * discards any models accepted by {@link #swapModels(SpeechConfig)}
+     * that have not yet been swapped in, keeping the current models. called
+     * by the pipeline when another stage rejects the same swap.
+     */
+    default void cancelSwap() {
+    }
 }
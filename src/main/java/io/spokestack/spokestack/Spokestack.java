@@ -81,6 +81,7 @@ public final class Spokestack extends SpokestackAdapter
 
     private final List<SpokestackAdapter> listeners;
     private final boolean autoClassify;
+    private final boolean bargeIn;
     private final TranscriptEditor transcriptEditor;
     private SpeechPipeline speechPipeline;
     private NLUManager nlu;
@@ -97,6 +98,7 @@ public final class Spokestack extends SpokestackAdapter
         this.listeners = new ArrayList<>();
         this.listeners.addAll(builder.listeners);
         this.autoClassify = builder.autoClassify;
+        this.bargeIn = builder.bargeIn;
         this.transcriptEditor = builder.transcriptEditor;
         if (builder.useAsr) {
             this.speechPipeline = builder.getPipelineBuilder()
@@ -131,6 +133,7 @@ public final class Spokestack extends SpokestackAdapter
         this.listeners = new ArrayList<>();
         this.listeners.addAll(builder.listeners);
         this.autoClassify = builder.autoClassify;
+        this.bargeIn = builder.bargeIn;
         this.transcriptEditor = builder.transcriptEditor;
         if (builder.useAsr) {
             this.speechPipeline = builder.getPipelineBuilder()
@@ -487,6 +490,10 @@ public final class Spokestack extends SpokestackAdapter
 
     @Override
     public void eventReceived(@NotNull TTSEvent event) {
+        // with barge-in, the pipeline keeps listening through playback
+        if (this.bargeIn) {
+            return;
+        }
         switch (event.type) {
             case PLAYBACK_STARTED:
                 pause();
@@ -534,6 +541,7 @@ public final class Spokestack extends SpokestackAdapter
         private boolean useTTS = true;
         private boolean useTTSPlayback = true;
         private boolean useDialogue = true;
+        private boolean bargeIn = false;
 
         private SpeechConfig speechConfig;
         private TranscriptEditor transcriptEditor;
@@ -958,6 +966,26 @@ public final class Spokestack extends SpokestackAdapter
             return this;
         }
 
+        /**
+         * Signal that Spokestack should keep the speech pipeline active
+         * during TTS playback, allowing the user to interrupt the
+         * synthesized response.
+         *
+         * <p>
+         * By default, the pipeline is paused while TTS audio plays so that
+         * the playback itself is not detected as user speech. When barge-in
+         * is enabled, the speech pipeline should instead include an {@link
+         * io.spokestack.spokestack.webrtc.AcousticEchoCanceller} as its first
+         * stage, which removes the playback audio from the microphone signal.
+         * </p>
+         *
+         * @return the updated builder
+         */
+        public Builder withBargeIn() {
+            this.bargeIn = true;
+            return this;
+        }
+
         /**
          * Signal that Spokestack's dialogue management module should not be
          * used.
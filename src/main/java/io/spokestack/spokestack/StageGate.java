@@ -0,0 +1,72 @@
+package io.spokestack.spokestack;
+
+import java.util.Set;
+import java.util.concurrent.atomic.AtomicLongArray;
+
+/**
+ * state-aware stage gating.
+ *
+ * <p>
+ * The gate decides, for each stage and frame, whether the stage should be
+ * called, based on the pipeline states it declares via
+ * {@link SpeechProcessor#getStates()}. A stage is called on frames in
+ * which the pipeline is in one of its states, and on the first frame after
+ * the pipeline leaves them. The state is evaluated immediately before each
+ * stage would be called, so that stages observe changes made by earlier
+ * stages in the same frame. The gate is updated by the pipeline thread, and
+ * its skip counters can be read by any thread.
+ * </p>
+ */
+final class StageGate {
+    private final SpeechProcessor.State[] previous;
+    private final AtomicLongArray skipped;
+
+    /**
+     * constructs a new gate instance.
+     * @param stageCount the number of stages gated
+     */
+    StageGate(int stageCount) {
+        this.previous = new SpeechProcessor.State[stageCount];
+        this.skipped = new AtomicLongArray(stageCount);
+    }
+
+    /**
+     * determines whether to call a stage on the current frame, counting the
+     * frame as skipped if not.
+     * @param index   the index of the stage
+     * @param stage   the stage to gate
+     * @param context the current speech context
+     * @return true if the stage should be called, false otherwise
+     */
+    boolean admit(int index, SpeechProcessor stage, SpeechContext context) {
+        SpeechProcessor.State state = SpeechProcessor.State.of(context);
+        SpeechProcessor.State last = this.previous[index];
+        this.previous[index] = state;
+
+        Set<SpeechProcessor.State> states = stage.getStates();
+        if (states.contains(state) || last != null && states.contains(last))
+            return true;
+        this.skipped.lazySet(index, this.skipped.get(index) + 1);
+        return false;
+    }
+
+    /**
+     * returns the number of frames for which a stage was skipped.
+     * @param index the index of the stage
+     * @return the skipped frame count
+     */
+    long getSkipped(int index) {
+        return this.skipped.get(index);
+    }
+
+    /**
+     * @return the number of frames for which each stage was skipped, in
+     * stage order
+     */
+    long[] getSkipped() {
+        long[] counts = new long[this.skipped.length()];
+        for (int i = 0; i < counts.length; i++)
+            counts[i] = this.skipped.get(i);
+        return counts;
+    }
+}
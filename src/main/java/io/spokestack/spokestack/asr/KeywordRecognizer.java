@@ -6,12 +6,20 @@ import io.spokestack.spokestack.RingBuffer;
 import io.spokestack.spokestack.SpeechConfig;
 import io.spokestack.spokestack.SpeechContext;
 import io.spokestack.spokestack.SpeechProcessor;
+import io.spokestack.spokestack.tensorflow.ModelGroup;
+import io.spokestack.spokestack.tensorflow.ModelOptions;
+import io.spokestack.spokestack.tensorflow.TensorFormat;
 import io.spokestack.spokestack.tensorflow.TensorflowModel;
+import io.spokestack.spokestack.util.EventTracer;
+import io.spokestack.spokestack.util.StartupTimeline;
+import io.spokestack.spokestack.util.TraceRing;
 import org.jtransforms.fft.FloatFFT_1D;
 
 import java.io.FileReader;
 import java.io.IOException;
 import java.nio.ByteBuffer;
+import java.util.Set;
+import java.util.concurrent.atomic.AtomicReference;
 
 /**
  * keyword recognition pipeline component
@@ -77,8 +85,9 @@ import java.nio.ByteBuffer;
  *      <b>keyword-encode-path</b> (string, required): file system path to the
  *      "encode" Tensorflow-Lite model, which is used to perform each
  *      autoregressive step over the mel frames; its inputs should be shaped
- *      [mel-length, mel-width], and its outputs [encode-width], with an
- *      additional state input/output shaped [state-width]
+ *      [mel-length, mel-width], and its outputs [encode-width], with
+ *      additional state inputs/outputs (see {@code keyword-encode-states}), the
+ *      first shaped [state-width]
  *   </li>
  *   <li>
  *      <b>keyword-detect-path</b> (string, required): file system path to the
@@ -137,11 +146,44 @@ import java.nio.ByteBuffer;
  *      in vector units (defaults to keyword-encode-width)
  *   </li>
  *   <li>
+ *      <b>keyword-encode-states</b> (string): the positions of the encoder's
+ *      state tensors, as a comma-separated list of {@code input:output}
+ *      pairs (or single positions shared by the input and output), for
+ *      encoders with several recurrent layers or streaming caches; defaults
+ *      to {@code 1}
+ *   </li>
+ *   <li>
  *      <b>keyword-threshold</b> (double): the threshold of the classifier's
  *      posterior output, above which the recognizer raises a recognition
  *      event for the most likely kewyord class, in the range [0, 1]
  *   </li>
+ *   <li>
+ *      <b>model-loading</b> (string): {@code serial} (default) to load the
+ *      models in the constructor, or {@code parallel} to load them on
+ *      background threads, in which case frames are ignored until all of
+ *      the models have loaded
+ *   </li>
+ *   <li>
+ *      <b>keyword-threads</b>, <b>keyword-xnnpack</b>, <b>keyword-fp16</b>,
+ *      <b>keyword-cancellable</b>: TensorFlow Lite interpreter options for the
+ *      models, as described in {@link ModelOptions}
+ *   </li>
  * </ul>
+ *
+ * <p>
+ * The models can be replaced while the pipeline is running, by calling
+ * {@link #swapModels(SpeechConfig)} with a configuration containing the
+ * new model paths (and optionally their class names and interpreter
+ * options). The new models are loaded on the calling thread (or in the
+ * background, for parallel model loading), and are swapped in by the
+ * pipeline thread at the start of the next activation once they have all
+ * loaded, so that an utterance is never split across model sets. The new
+ * models must have the same input, output, and state sizes as the models
+ * they replace; otherwise, or if they fail to load, an error event is
+ * raised and the current models are kept. If the current models themselves
+ * failed to load, any new models that load replace them, re-enabling the
+ * recognizer.
+ * </p>
  */
 public final class KeywordRecognizer implements SpeechProcessor {
     /** the hann keyword-fft-window-type.  */
@@ -166,8 +208,15 @@ public final class KeywordRecognizer implements SpeechProcessor {
     /** default recognition threshold value. */
     public static final float DEFAULT_THRESHOLD = 0.5f;
 
+    // detection trace ring event
+    private static final int TRACE_CONFIDENCE = TraceRing.register(
+        "keyword",
+        "keyword: %.3f class %.0f",
+        "confidence",
+        "class");
+
     // keyword class names
-    private final String[] classes;
+    private String[] classes;
 
     // audio pre-emphasis
     private final float preEmphasis;
@@ -189,9 +238,16 @@ public final class KeywordRecognizer implements SpeechProcessor {
     private final RingBuffer encodeWindow;
 
     // tensorflow mel filtering and classifier models
-    private final TensorflowModel filterModel;
-    private final TensorflowModel encodeModel;
-    private final TensorflowModel detectModel;
+    private final TensorflowModel.Loader loader;
+    private final AtomicReference<PendingModels> pendingModels =
+        new AtomicReference<>();
+    private ModelGroup models;
+    private TensorflowModel filterModel;
+    private TensorflowModel encodeModel;
+    private TensorflowModel detectModel;
+    private boolean loadTraced;
+    private boolean loadFailed;
+    private volatile boolean closed;
 
     // detection posterior threshold
     private final float threshold;
@@ -270,19 +326,11 @@ public final class KeywordRecognizer implements SpeechProcessor {
         this.frameWindow.fill(0);
         this.encodeWindow.fill(-1);
 
-        // load the tensorflow-lite models
-        this.filterModel = loader
-            .setPath(config.getString("keyword-filter-path"))
-            .load();
-        loader.reset();
-        this.encodeModel = loader
-            .setPath(config.getString("keyword-encode-path"))
-            .setStatePosition(1)
-            .load();
-        loader.reset();
-        this.detectModel = loader
-            .setPath(config.getString("keyword-detect-path"))
-            .load();
+        // load the tensorflow-lite models, in the background if configured
+        this.loader = loader;
+        this.models = loadModels(config);
+        if (this.models.isReady())
+            attachModels(this.models);
 
         // configure the keyword probability threshold
         this.threshold = (float) config
@@ -293,7 +341,9 @@ public final class KeywordRecognizer implements SpeechProcessor {
         String[] classNames;
         if (config.containsKey("keyword-metadata-path")) {
             String path = config.getString("keyword-metadata-path");
+            long start = System.nanoTime();
             KeywordMetadata metadata = parseMetadata(path);
+            StartupTimeline.record("metadata", start);
             classNames = metadata.getClassNames();
         } else {
             classNames = config.getString("keyword-classes").split(",");
@@ -312,14 +362,110 @@ public final class KeywordRecognizer implements SpeechProcessor {
         }
     }
 
+    private ModelGroup loadModels(SpeechConfig config) {
+        ModelOptions options = new ModelOptions(config, "keyword");
+        ModelGroup group = new ModelGroup(config);
+        try {
+            group.add(
+                "filter",
+                this.loader
+                    .setOptions(options)
+                    .setPath(config.getString("keyword-filter-path")));
+            group.add(
+                "encode",
+                this.loader
+                    .setOptions(options)
+                    .setPath(config.getString("keyword-encode-path"))
+                    .addStatePairs(
+                        config.getString("keyword-encode-states", "1")));
+            group.add(
+                "detect",
+                this.loader
+                    .setOptions(options)
+                    .setPath(config.getString("keyword-detect-path")));
+        } catch (RuntimeException e) {
+            // release any models loaded before the failure
+            this.loader.reset();
+            group.close();
+            throw e;
+        }
+        return group;
+    }
+
     /**
      * releases resources associated with the keyword recognizer.
      * @throws Exception on error
      */
-    public void close() throws Exception {
-        this.filterModel.close();
-        this.encodeModel.close();
-        this.detectModel.close();
+    public synchronized void close() throws Exception {
+        // synchronized with swaps, so that none can land after the pending
+        // models are released
+        this.closed = true;
+        PendingModels pending = this.pendingModels.getAndSet(null);
+        if (pending != null)
+            pending.group.close();
+        this.models.close();
+    }
+
+    /**
+     * loads a new set of keyword models, to be swapped in by the pipeline
+     * thread at the start of the next activation after they have loaded.
+     * the class names are replaced if the configuration contains them. a
+     * pending swap that has not yet been applied is discarded.
+     * @param config the configuration containing the new model paths
+     * @return true if the configuration contains keyword model paths,
+     * false otherwise
+     * @throws IllegalStateException if the recognizer has been closed
+     */
+    @Override
+    public boolean swapModels(SpeechConfig config) {
+        if (!config.containsKey("keyword-filter-path")
+                && !config.containsKey("keyword-encode-path")
+                && !config.containsKey("keyword-detect-path"))
+            return false;
+        if (this.closed)
+            throw new IllegalStateException("closed");
+        String[] classNames = null;
+        if (config.containsKey("keyword-metadata-path")
+                || config.containsKey("keyword-classes"))
+            classNames = getClassNames(config);
+
+        // load outside the monitor, so that the pipeline thread is never
+        // blocked by a load while it attaches a previous swap
+        ModelGroup loaded;
+        synchronized (this.loader) {
+            loaded = loadModels(config);
+        }
+        PendingModels replaced;
+        synchronized (this) {
+            if (this.closed) {
+                loaded.close();
+                throw new IllegalStateException("closed");
+            }
+            if (classNames == null)
+                classNames = this.classes;
+            replaced = this.pendingModels.getAndSet(
+                new PendingModels(loaded, classNames));
+        }
+        if (replaced != null)
+            replaced.group.close();
+        return true;
+    }
+
+    @Override
+    public void cancelSwap() {
+        PendingModels pending = this.pendingModels.getAndSet(null);
+        if (pending != null)
+            pending.group.close();
+    }
+
+    /**
+     * the recognizer samples audio and detects keywords while the pipeline
+     * is active, and only needs to see the frame that deactivates it.
+     * @return the active state
+     */
+    @Override
+    public Set<State> getStates() {
+        return ACTIVE_STATES;
     }
 
     @Override
@@ -334,9 +480,9 @@ public final class KeywordRecognizer implements SpeechProcessor {
         this.frameWindow.reset().fill(0);
         this.encodeWindow.reset().fill(-1);
 
-        // reset the encoder states
-        while (this.encodeModel.states().hasRemaining())
-            this.encodeModel.states().putFloat(0);
+        // reset the encoder states, once the encoder has loaded
+        if (this.encodeModel != null)
+            this.encodeModel.resetStates();
     }
 
     /**
@@ -347,6 +493,39 @@ public final class KeywordRecognizer implements SpeechProcessor {
      */
     public void process(SpeechContext context, ByteBuffer buffer)
             throws Exception {
+        // wait for the models to load, reporting a failure to load only
+        // once, after which the stage remains disabled until a swap
+        if (this.detectModel == null && !this.loadFailed) {
+            if (!this.models.isReady())
+                return;
+            try {
+                attachModels(this.models);
+            } catch (IllegalStateException e) {
+                this.loadFailed = true;
+                context.setError(e);
+                context.dispatch(SpeechContext.Event.ERROR);
+                return;
+            }
+        }
+
+        // swap in newly loaded models between utterances, which also
+        // recovers a stage whose models failed to load
+        PendingModels pending = this.pendingModels.get();
+        if (!this.isActive && pending != null && pending.group.isReady())
+            attachPending(context, pending);
+        if (this.detectModel == null)
+            return;
+
+        if (!this.loadTraced) {
+            for (int i = 0; i < this.models.size(); i++) {
+                context.tracePerf(
+                    "keyword: loaded %s model in %.1fms",
+                    this.models.getName(i),
+                    this.models.getLoadTime(i) / 1e6);
+            }
+            this.loadTraced = true;
+        }
+
         // run the current frame through the detector pipeline
         sample(context, buffer);
 
@@ -357,6 +536,50 @@ public final class KeywordRecognizer implements SpeechProcessor {
         this.isActive = context.isActive();
     }
 
+    private void attachModels(ModelGroup group) {
+        // fetch every model before attaching any, so that a model that
+        // failed to load leaves the stage detached rather than half-attached
+        TensorflowModel filter = group.get(0);
+        TensorflowModel encode = group.get(1);
+        TensorflowModel detect = group.get(2);
+        this.filterModel = filter;
+        this.encodeModel = encode;
+        this.detectModel = detect;
+    }
+
+    private synchronized void attachPending(SpeechContext context,
+                                            PendingModels pending) {
+        // claim the pending models, unless they were replaced, cancelled,
+        // or released by close since they were checked
+        if (this.closed || !this.pendingModels.compareAndSet(pending, null))
+            return;
+        try {
+            pending.group.checkCompatible(this.models);
+            TensorflowModel detect = pending.group.get(2);
+            int classCount = detect.outputs(0).capacity()
+                / detect.outputFormat(0).getSize();
+            if (pending.classes.length != classCount)
+                throw new IllegalStateException("keyword-classes");
+        } catch (IllegalStateException e) {
+            pending.group.close();
+            context.setError(e);
+            context.dispatch(SpeechContext.Event.ERROR);
+            return;
+        }
+
+        ModelGroup previous = this.models;
+        this.models = pending.group;
+        this.classes = pending.classes;
+        attachModels(pending.group);
+        previous.close();
+        this.loadTraced = false;
+        this.loadFailed = false;
+
+        // the buffered features came from the previous models,
+        // so start the new ones from a clean slate
+        reset();
+    }
+
     private void sample(SpeechContext context, ByteBuffer buffer) {
         // process all samples in the frame
         buffer.rewind();
@@ -401,41 +624,51 @@ public final class KeywordRecognizer implements SpeechProcessor {
         // . the first and last stft components contain only real parts
         //   and are stored in the first two positions of the stft output
         // . the remaining components contain real/imaginary parts
-        this.filterModel.inputs(0).rewind();
-        this.filterModel.inputs(0).putFloat(this.fftFrame[0]);
+        // . values are encoded in the model's input format, which may be
+        //   quantized
+        TensorFormat inputFormat = this.filterModel.inputFormat(0);
+        ByteBuffer input = this.filterModel.inputs(0);
+        input.rewind();
+        inputFormat.put(input, this.fftFrame[0]);
         for (int i = 1; i < this.fftFrame.length / 2; i++) {
             float re = this.fftFrame[i * 2 + 0];
             float im = this.fftFrame[i * 2 + 1];
             float ab = (float) Math.sqrt(re * re + im * im);
-            this.filterModel.inputs(0).putFloat(ab);
+            inputFormat.put(input, ab);
         }
-        this.filterModel.inputs(0).putFloat(this.fftFrame[1]);
+        inputFormat.put(input, this.fftFrame[1]);
 
         // execute the mel filterbank tensorflow model
         this.filterModel.run();
 
         // copy the current mel frame into the frame window
+        TensorFormat outputFormat = this.filterModel.outputFormat(0);
+        ByteBuffer output = this.filterModel.outputs(0);
         this.frameWindow.rewind().seek(this.melWidth);
-        while (this.filterModel.outputs(0).hasRemaining())
-            this.frameWindow.write(this.filterModel.outputs(0).getFloat());
+        while (output.hasRemaining())
+            this.frameWindow.write(outputFormat.get(output));
 
         encode(context);
     }
 
     private void encode(SpeechContext context) {
         // transfer the mel filterbank window to the encoder model's inputs
+        TensorFormat inputFormat = this.encodeModel.inputFormat(0);
+        ByteBuffer input = this.encodeModel.inputs(0);
         this.frameWindow.rewind();
-        this.encodeModel.inputs(0).rewind();
+        input.rewind();
         while (!this.frameWindow.isEmpty())
-            this.encodeModel.inputs(0).putFloat(this.frameWindow.read());
+            inputFormat.put(input, this.frameWindow.read());
 
         // run the encoder tensorflow model
         this.encodeModel.run();
 
         // copy the encoder output into the encode window
+        TensorFormat outputFormat = this.encodeModel.outputFormat(0);
+        ByteBuffer output = this.encodeModel.outputs(0);
         this.encodeWindow.rewind().seek(this.encodeWidth);
-        while (this.encodeModel.outputs(0).hasRemaining())
-            this.encodeWindow.write(this.encodeModel.outputs(0).getFloat());
+        while (output.hasRemaining())
+            this.encodeWindow.write(outputFormat.get(output));
     }
 
     private void detect(SpeechContext context) {
@@ -443,24 +676,32 @@ public final class KeywordRecognizer implements SpeechProcessor {
         float confidence = 0;
 
         // transfer the encoder window to the detector model's inputs
+        TensorFormat inputFormat = this.detectModel.inputFormat(0);
+        ByteBuffer input = this.detectModel.inputs(0);
         this.encodeWindow.rewind();
-        this.detectModel.inputs(0).rewind();
+        input.rewind();
         while (!this.encodeWindow.isEmpty())
-            this.detectModel.inputs(0).putFloat(this.encodeWindow.read());
+            inputFormat.put(input, this.encodeWindow.read());
 
         // run the classifier tensorflow model
         this.detectModel.run();
 
         // check the classifier's output and find the most likely class
+        TensorFormat outputFormat = this.detectModel.outputFormat(0);
+        ByteBuffer output = this.detectModel.outputs(0);
+        int classIndex = -1;
         for (int i = 0; i < this.classes.length; i++) {
-            float posterior = this.detectModel.outputs(0).getFloat();
+            float posterior = outputFormat.get(output);
             if (posterior > confidence) {
                 transcript = this.classes[i];
                 confidence = posterior;
+                classIndex = i;
             }
         }
 
-        context.traceInfo("keyword: %.3f %s", confidence, transcript);
+        TraceRing.record(TRACE_CONFIDENCE, confidence, classIndex);
+        if (context.canTrace(EventTracer.Level.INFO))
+            context.traceInfo("keyword: %.3f %s", confidence, transcript);
 
         if (confidence >= this.threshold) {
             // raise the speech recognition event with the class transcript
@@ -482,4 +723,17 @@ public final class KeywordRecognizer implements SpeechProcessor {
             window[i] = (float) Math.pow(Math.sin(Math.PI * i / (len - 1)), 2);
         return window;
     }
+
+    /**
+     * a model group awaiting its swap, with its keyword class names.
+     */
+    private static final class PendingModels {
+        private final ModelGroup group;
+        private final String[] classes;
+
+        PendingModels(ModelGroup modelGroup, String[] classNames) {
+            this.group = modelGroup;
+            this.classes = classNames;
+        }
+    }
 }
@@ -5,6 +5,7 @@ import io.spokestack.spokestack.SpeechContext;
 import io.spokestack.spokestack.SpeechProcessor;
 
 import java.nio.ByteBuffer;
+import java.util.Set;
 
 /**
  * Spokestack cloud speech recognizer
@@ -78,6 +79,18 @@ public final class SpokestackCloudRecognizer implements SpeechProcessor {
               .build();
     }
 
+    /**
+     * the recognizer streams audio while the pipeline is active, and counts
+     * idle frames afterward until it disconnects from the service.
+     * @return the active state once disconnected, otherwise all states
+     */
+    @Override
+    public Set<State> getStates() {
+        return this.idleCount > this.maxIdleCount
+            ? ACTIVE_STATES
+            : ALL_STATES;
+    }
+
     @Override
     public void reset() {
         if (this.client.isConnected()) {
@@ -122,7 +135,7 @@ public final class SpokestackCloudRecognizer implements SpeechProcessor {
         this.active = true;
         this.idleCount = 0;
 
-        for (ByteBuffer frame : context.getBuffer()) {
+        for (ByteBuffer frame : context.getReplay()) {
             send(frame);
         }
     }
@@ -2,6 +2,7 @@ package io.spokestack.spokestack.google;
 
 import java.io.ByteArrayInputStream;
 import java.nio.ByteBuffer;
+import java.util.Set;
 
 import com.google.protobuf.ByteString;
 import com.google.auth.oauth2.ServiceAccountCredentials;
@@ -103,6 +104,15 @@ public final class GoogleSpeechRecognizer implements SpeechProcessor {
             .build();
     }
 
+    /**
+     * the recognizer only streams audio while the pipeline is active.
+     * @return the active state
+     */
+    @Override
+    public Set<State> getStates() {
+        return ACTIVE_STATES;
+    }
+
     @Override
     public void reset() {
         if (this.request != null) {
@@ -156,7 +166,7 @@ public final class GoogleSpeechRecognizer implements SpeechProcessor {
         // based on integration testing,
         // these are transmitted asynchronously by the speech client
         // so they don't appear to block the frame loop
-        for (ByteBuffer frame: context.getBuffer())
+        for (ByteBuffer frame: context.getReplay())
             send(frame);
     }
 
@@ -16,6 +16,7 @@ import io.spokestack.spokestack.SpeechProcessor;
 
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
+import java.util.Set;
 
 /**
  * microsoft azure speech service recognizer
@@ -106,6 +107,15 @@ public class AzureSpeechRecognizer implements SpeechProcessor {
         return config;
     }
 
+    /**
+     * the recognizer only buffers audio while the pipeline is active.
+     * @return the active state
+     */
+    @Override
+    public Set<State> getStates() {
+        return ACTIVE_STATES;
+    }
+
     @Override
     public void reset() {
         close();
@@ -153,7 +163,7 @@ public class AzureSpeechRecognizer implements SpeechProcessor {
         this.active = true;
 
         // send any existing frames into the stream
-        for (ByteBuffer frame : speechContext.getBuffer()) {
+        for (ByteBuffer frame : speechContext.getReplay()) {
             bufferFrame(frame);
         }
     }
@@ -3,6 +3,7 @@ package io.spokestack.spokestack.nlu.tensorflow;
 import androidx.annotation.NonNull;
 import io.spokestack.spokestack.nlu.NLUContext;
 import io.spokestack.spokestack.nlu.Slot;
+import io.spokestack.spokestack.tensorflow.TensorFormat;
 import io.spokestack.spokestack.util.Tuple;
 
 import java.nio.ByteBuffer;
@@ -18,6 +19,8 @@ final class TFNLUOutput {
 
     private final Metadata metadata;
     private Map<String, SlotParser> slotParsers;
+    private TensorFormat intentFormat = TensorFormat.FLOAT;
+    private TensorFormat tagFormat = TensorFormat.FLOAT;
 
     TFNLUOutput(Metadata nluMetadata) {
         this.metadata = nluMetadata;
@@ -33,6 +36,18 @@ final class TFNLUOutput {
         this.slotParsers = parsers;
     }
 
+    /**
+     * Set the element formats of the model's output tensors, which default
+     * to 32-bit floats.
+     *
+     * @param intents The format of the intent output tensor.
+     * @param tags    The format of the slot tag output tensor.
+     */
+    public void setOutputFormats(TensorFormat intents, TensorFormat tags) {
+        this.intentFormat = intents;
+        this.tagFormat = tags;
+    }
+
     /**
      * Extract the intent from the model's output tensor.
      *
@@ -43,7 +58,8 @@ final class TFNLUOutput {
      */
     public Tuple<Metadata.Intent, Float> getIntent(ByteBuffer output) {
         Metadata.Intent[] intents = this.metadata.getIntents();
-        Tuple<Integer, Float> prediction = bufferArgMax(output, intents.length);
+        Tuple<Integer, Float> prediction =
+              bufferArgMax(output, intents.length, this.intentFormat);
         return new Tuple<>(intents[prediction.first()], prediction.second());
     }
 
@@ -110,16 +126,19 @@ final class TFNLUOutput {
         int numTags = this.metadata.getTags().length;
         String[] labels = new String[numTokens];
         for (int i = 0; i < labels.length; i++) {
-            Tuple<Integer, Float> labelled = bufferArgMax(output, numTags);
+            Tuple<Integer, Float> labelled =
+                  bufferArgMax(output, numTags, this.tagFormat);
             labels[i] = this.metadata.getTags()[labelled.first()];
         }
         return labels;
     }
 
-    private Tuple<Integer, Float> bufferArgMax(ByteBuffer buffer, int n) {
+    private Tuple<Integer, Float> bufferArgMax(ByteBuffer buffer,
+                                               int n,
+                                               TensorFormat format) {
         float[] posteriors = new float[n];
         for (int i = 0; i < n; i++) {
-            posteriors[i] = buffer.getFloat();
+            posteriors[i] = format.get(buffer);
         }
         return argMax(posteriors);
     }
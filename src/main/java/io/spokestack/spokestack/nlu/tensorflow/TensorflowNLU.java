@@ -12,6 +12,8 @@ import io.spokestack.spokestack.nlu.tensorflow.parsers.DigitsParser;
 import io.spokestack.spokestack.nlu.tensorflow.parsers.IdentityParser;
 import io.spokestack.spokestack.nlu.tensorflow.parsers.IntegerParser;
 import io.spokestack.spokestack.nlu.tensorflow.parsers.SelsetParser;
+import io.spokestack.spokestack.tensorflow.ModelOptions;
+import io.spokestack.spokestack.tensorflow.TensorFormat;
 import io.spokestack.spokestack.tensorflow.TensorflowModel;
 import io.spokestack.spokestack.util.AsyncResult;
 import io.spokestack.spokestack.util.EventTracer;
@@ -20,13 +22,17 @@ import io.spokestack.spokestack.util.Tuple;
 
 import java.io.FileReader;
 import java.io.IOException;
+import java.nio.ByteBuffer;
 import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
 import java.util.HashMap;
 import java.util.List;
 import java.util.Map;
 import java.util.concurrent.ExecutorService;
 import java.util.concurrent.Executors;
 import java.util.concurrent.ThreadFactory;
+import java.util.concurrent.TimeUnit;
 
 /**
  * On-device natural language understanding powered by DistilBERT and TensorFlow
@@ -40,6 +46,29 @@ import java.util.concurrent.ThreadFactory;
  * </p>
  *
  * <p>
+ * For offline work such as transcript reprocessing or evaluation, many
+ * utterances can be classified together via {@link #classifyBatch(List)},
+ * which packs up to {@code nlu-batch-size} utterances into the model's
+ * batch dimension for each inference. Every inference in a job runs the
+ * same number of rows, padding the last batch, so the model's input tensor
+ * is resized at most once per job, and back to a single utterance when the
+ * job completes, so that {@link #classify(String)} never pays for a
+ * resize. Jobs should therefore be reasonably large to amortize the
+ * resize. Batch throughput is traced at the PERF level.
+ * </p>
+ *
+ * <p>
+ * By default, every utterance is padded to the model's maximum input
+ * length, so short commands pay for full-length inference. For models that
+ * accept a variable input length, {@code nlu-length-buckets} lists shorter
+ * lengths to load the model at, alongside its maximum length. Each
+ * utterance is then padded only to the shortest bucket that fits it, and
+ * run on that bucket's interpreter, which is resized and allocated once,
+ * when it is loaded. The buckets share the model's bytes, but each adds an
+ * interpreter (and its warmup) to the cost of loading the NLU.
+ * </p>
+ *
+ * <p>
  * This component supports the following configuration properties:
  * </p>
  * <ul>
@@ -61,9 +90,29 @@ import java.util.concurrent.ThreadFactory;
  *      example, a custom slot parser used to parse slots listed as {@code user}
  *      in the NLU metadata should be provided under the key {@code slot-user}.
  *   </li>
+ *   <li>
+ *      <b>nlu-batch-size</b> (integer, optional): the maximum number of
+ *      utterances classified by each inference in
+ *      {@link #classifyBatch(List)}; defaults to 8.
+ *   </li>
+ *   <li>
+ *      <b>nlu-length-buckets</b> (string, optional): a comma-separated list
+ *      of input lengths, in tokens, at which to load additional copies of
+ *      the model, for example {@code 8,16,32}. Lengths at or above the
+ *      model's maximum input length are ignored. Defaults to none.
+ *   </li>
+ *   <li>
+ *      <b>nlu-threads</b>, <b>nlu-xnnpack</b>, <b>nlu-fp16</b>,
+ *      <b>nlu-cancellable</b>: TensorFlow Lite interpreter options for the
+ *      model, as described in {@link ModelOptions}. A cancellable model's
+ *      in-flight classification is cancelled when the NLU is closed.
+ *   </li>
  * </ul>
  */
 public final class TensorflowNLU implements NLUService {
+    /** default nlu-batch-size configuration value. */
+    public static final int DEFAULT_BATCH_SIZE = 8;
+
     private final ExecutorService executor =
           Executors.newSingleThreadExecutor();
     private final NLUContext context;
@@ -72,9 +121,12 @@ public final class TensorflowNLU implements NLUService {
     private int sepTokenId;
     private int padTokenId;
     private Thread loadThread;
-    private TensorflowModel nluModel;
+    private TensorflowModel[] nluModels;
+    private int[] inputLengths;
     private TFNLUOutput outputParser;
     private int maxTokens;
+    private int batchSize;
+    private int[] lengthBuckets;
 
     private volatile boolean ready = false;
 
@@ -132,11 +184,22 @@ public final class TensorflowNLU implements NLUService {
                       ThreadFactory threadFactory) {
         String modelPath = config.getString("nlu-model-path");
         String metadataPath = config.getString("nlu-metadata-path");
+        ModelOptions options = new ModelOptions(config, "nlu");
+        this.batchSize = config.getInteger("nlu-batch-size",
+              DEFAULT_BATCH_SIZE);
+        if (this.batchSize < 1) {
+            throw new IllegalArgumentException("nlu-batch-size");
+        }
+        this.lengthBuckets = parseBuckets(
+              config.getString("nlu-length-buckets", ""));
         Map<String, String> slotParsers = getSlotParsers(config);
         this.textEncoder = encoder;
         this.loadThread = threadFactory.newThread(
               () -> {
-                  loadModel(loader, metadataPath, modelPath);
+                  loadModel(loader,
+                        options,
+                        metadataPath,
+                        modelPath);
                   initParsers(slotParsers);
               });
         this.loadThread.start();
@@ -145,6 +208,26 @@ public final class TensorflowNLU implements NLUService {
         this.sepTokenId = encoder.encodeSingle("[SEP]");
     }
 
+    private static int[] parseBuckets(String spec) {
+        if (spec.trim().isEmpty()) {
+            return new int[0];
+        }
+        String[] lengths = spec.split(",");
+        int[] buckets = new int[lengths.length];
+        try {
+            for (int i = 0; i < lengths.length; i++) {
+                buckets[i] = Integer.parseInt(lengths[i].trim());
+                if (buckets[i] < 1) {
+                    throw new IllegalArgumentException("nlu-length-buckets");
+                }
+            }
+        } catch (NumberFormatException e) {
+            throw new IllegalArgumentException("nlu-length-buckets", e);
+        }
+        Arrays.sort(buckets);
+        return buckets;
+    }
+
     private Map<String, String> getSlotParsers(SpeechConfig config) {
         HashMap<String, String> slotParsers = new HashMap<>();
 
@@ -176,6 +259,7 @@ public final class TensorflowNLU implements NLUService {
     }
 
     private void loadModel(TensorflowModel.Loader loader,
+                           ModelOptions options,
                            String metadataPath,
                            String modelPath) {
         try (FileReader fileReader = new FileReader(metadataPath);
@@ -183,25 +267,55 @@ public final class TensorflowNLU implements NLUService {
             Gson gson = new Gson();
             Metadata metadata = gson.fromJson(reader, Metadata.class);
 
-            this.nluModel = loader
+            TensorflowModel model = loader
+                  .setOptions(options)
                   .setPath(modelPath)
                   .load();
-            this.maxTokens = this.nluModel.inputs(0).capacity()
-                  / this.nluModel.getInputSize();
+            this.maxTokens = model.inputs(0).capacity()
+                  / model.getInputSize();
             this.outputParser = new TFNLUOutput(metadata);
-            warmup();
+            this.outputParser.setOutputFormats(
+                  model.outputFormat(0),
+                  model.outputFormat(1));
+
+            // load a copy of the model resized to each shorter bucket,
+            // with the full-length model as the last bucket
+            int buckets = 0;
+            while (buckets < this.lengthBuckets.length
+                  && this.lengthBuckets[buckets] < this.maxTokens) {
+                buckets++;
+            }
+            TensorflowModel[] models = new TensorflowModel[buckets + 1];
+            int[] lengths = new int[buckets + 1];
+            for (int i = 0; i < buckets; i++) {
+                models[i] = loader
+                      .setOptions(options)
+                      .setPath(modelPath)
+                      .load();
+                models[i].setInputLength(this.lengthBuckets[i]);
+                lengths[i] = this.lengthBuckets[i];
+            }
+            models[buckets] = model;
+            lengths[buckets] = this.maxTokens;
+            for (TensorflowModel bucket : models) {
+                warmup(bucket);
+            }
+            this.inputLengths = lengths;
+            this.nluModels = models;
         } catch (IOException e) {
             this.context.traceError("Error loading NLU model: %s",
                   e.getLocalizedMessage());
         }
     }
 
-    private void warmup() {
-        this.nluModel.inputs(0).rewind();
-        for (int i = 0; i < maxTokens; i++) {
-            this.nluModel.inputs(0).putInt(0);
+    private void warmup(TensorflowModel model) {
+        TensorFormat format = model.inputFormat(0);
+        ByteBuffer input = model.inputs(0);
+        input.rewind();
+        while (input.hasRemaining()) {
+            format.put(input, 0);
         }
-        this.nluModel.run();
+        model.run();
     }
 
     /**
@@ -214,9 +328,26 @@ public final class TensorflowNLU implements NLUService {
 
     @Override
     public void close() throws Exception {
+        // models still loading would otherwise be leaked, and models that
+        // failed to load are never set
+        this.loadThread.join();
+        TensorflowModel[] models = this.nluModels;
+        if (models != null) {
+            for (TensorflowModel model : models) {
+                model.setCancelled(true);
+            }
+        }
+
+        // classification in progress must stop before the interpreters it
+        // is running are freed
         this.executor.shutdownNow();
-        this.nluModel.close();
-        this.nluModel = null;
+        this.executor.awaitTermination(Long.MAX_VALUE, TimeUnit.MILLISECONDS);
+        if (models != null) {
+            for (TensorflowModel model : models) {
+                model.close();
+            }
+        }
+        this.nluModels = null;
         this.textEncoder = null;
         this.outputParser = null;
     }
@@ -260,6 +391,68 @@ public final class TensorflowNLU implements NLUService {
         return asyncResult;
     }
 
+    /**
+     * Classify a list of utterances, packing them into batches for
+     * inference. The results are returned in the order of the utterances.
+     * An utterance that cannot be classified (for example, because it is
+     * too long) is returned as a result with an error, without affecting
+     * the rest of its batch.
+     *
+     * @param utterances The utterances to classify.
+     * @return An object representing the result of the asynchronous
+     * classification.
+     */
+    public AsyncResult<List<NLUResult>> classifyBatch(List<String> utterances) {
+        return classifyBatch(utterances, this.context);
+    }
+
+    /**
+     * Classify a list of utterances, packing them into batches for
+     * inference.
+     *
+     * @param utterances The utterances to classify.
+     * @param nluContext The context used to deliver trace events.
+     * @return An object representing the result of the asynchronous
+     * classification.
+     * @see #classifyBatch(List)
+     */
+    public AsyncResult<List<NLUResult>> classifyBatch(List<String> utterances,
+                                                      NLUContext nluContext) {
+        ensureReady();
+        List<String> batch = new ArrayList<>(utterances);
+        AsyncResult<List<NLUResult>> asyncResult = new AsyncResult<>(
+              () -> {
+                  try {
+                      long start = System.nanoTime();
+                      List<NLUResult> results =
+                            tfClassifyBatch(batch, nluContext);
+                      if (nluContext.canTrace(EventTracer.Level.PERF)) {
+                          double elapsed = (System.nanoTime() - start) / 1e9;
+                          nluContext.tracePerf(
+                                "Batch: %d utterances (batch size %d) "
+                                      + "in %.1fms, %.1f utterances/s",
+                                batch.size(),
+                                this.batchSize,
+                                elapsed * 1e3,
+                                batch.size() / elapsed);
+                      }
+                      return results;
+                  } catch (Exception e) {
+                      List<NLUResult> errors = new ArrayList<>();
+                      for (String utterance : batch) {
+                          errors.add(new NLUResult.Builder(utterance)
+                                .withError(e)
+                                .build());
+                      }
+                      return errors;
+                  } finally {
+                      nluContext.reset();
+                  }
+              });
+        this.executor.submit(asyncResult);
+        return asyncResult;
+    }
+
     private void ensureReady() {
         if (!this.ready) {
             try {
@@ -274,29 +467,133 @@ public final class TensorflowNLU implements NLUService {
         EncodedTokens encoded = this.textEncoder.encode(utterance);
         nluContext.traceDebug("Token IDs: %s", encoded.getIds());
 
-        int[] tokenIds = pad(encoded.getIds());
-        this.nluModel.inputs(0).rewind();
+        // token ids are padded to the shortest bucket that fits them, and
+        // encoded in the model's input format, which may be quantized
+        int bucket = selectBucket(encoded.getIds().size());
+        TensorflowModel model = this.nluModels[bucket];
+        int[] tokenIds = pad(encoded.getIds(), this.inputLengths[bucket]);
+        TensorFormat format = model.inputFormat(0);
+        ByteBuffer input = model.inputs(0);
+        input.rewind();
         for (int tokenId : tokenIds) {
-            this.nluModel.inputs(0).putInt(tokenId);
+            format.put(input, tokenId);
         }
 
         long start = SystemClock.elapsedRealtime();
-        this.nluModel.run();
+        model.run();
         if (nluContext.canTrace(EventTracer.Level.PERF)) {
-            nluContext.tracePerf("Inference: %5dms",
-                  (SystemClock.elapsedRealtime() - start));
+            nluContext.tracePerf("Inference: %5dms (%d tokens)",
+                  (SystemClock.elapsedRealtime() - start),
+                  tokenIds.length);
         }
 
-        // interpret model outputs
-        Tuple<Metadata.Intent, Float> prediction = outputParser.getIntent(
-              this.nluModel.outputs(0));
+        return interpret(utterance,
+              encoded,
+              model.outputs(0),
+              model.outputs(1),
+              nluContext);
+    }
+
+    private List<NLUResult> tfClassifyBatch(List<String> utterances,
+                                            NLUContext nluContext) {
+        // every batch runs at the same number of rows, so that each
+        // bucket's interpreter is resized at most once for the job
+        int rows = Math.min(this.batchSize, utterances.size());
+        List<NLUResult> results = new ArrayList<>(utterances.size());
+        try {
+            for (int offset = 0; offset < utterances.size();
+                 offset += this.batchSize) {
+                int end = Math.min(offset + this.batchSize, utterances.size());
+                classifyRows(utterances.subList(offset, end),
+                      rows,
+                      nluContext,
+                      results);
+            }
+        } finally {
+            // restore the single-utterance batch used by classify
+            for (TensorflowModel model : this.nluModels) {
+                model.setBatchSize(1);
+            }
+        }
+        return results;
+    }
+
+    private void classifyRows(List<String> utterances,
+                              int rows,
+                              NLUContext nluContext,
+                              List<NLUResult> results) {
+        // pack each utterance's token ids into a row of the batch, padded
+        // to the shortest bucket that fits the longest utterance; an
+        // utterance that fails to encode, and any rows past the last
+        // utterance, are run as empty rows
+        int count = utterances.size();
+        EncodedTokens[] encoded = new EncodedTokens[count];
+        Exception[] errors = new Exception[count];
+        int bucket = 0;
+        for (int r = 0; r < count; r++) {
+            try {
+                encoded[r] = this.textEncoder.encode(utterances.get(r));
+                bucket = Math.max(bucket,
+                      selectBucket(encoded[r].getIds().size()));
+            } catch (Exception e) {
+                errors[r] = e;
+            }
+        }
+        TensorflowModel model = this.nluModels[bucket];
+        int length = this.inputLengths[bucket];
+        model.setBatchSize(rows);
+        TensorFormat format = model.inputFormat(0);
+        ByteBuffer input = model.inputs(0);
+        input.rewind();
+        for (int r = 0; r < rows; r++) {
+            List<Integer> ids = r < count && errors[r] == null
+                  ? encoded[r].getIds()
+                  : Collections.emptyList();
+            for (int tokenId : pad(ids, length)) {
+                format.put(input, tokenId);
+            }
+        }
+
+        model.run();
+
+        // interpret each row of the outputs in place
+        ByteBuffer intents = model.outputs(0);
+        ByteBuffer tags = model.outputs(1);
+        int intentStride = intents.capacity() / rows;
+        int tagStride = tags.capacity() / rows;
+        for (int r = 0; r < count; r++) {
+            String utterance = utterances.get(r);
+            if (errors[r] == null) {
+                try {
+                    intents.position(r * intentStride);
+                    tags.position(r * tagStride);
+                    results.add(interpret(
+                          utterance, encoded[r], intents, tags, nluContext));
+                    continue;
+                } catch (Exception e) {
+                    errors[r] = e;
+                }
+            }
+            results.add(new NLUResult.Builder(utterance)
+                  .withError(errors[r])
+                  .build());
+        }
+    }
+
+    private NLUResult interpret(String utterance,
+                                EncodedTokens encoded,
+                                ByteBuffer intents,
+                                ByteBuffer tags,
+                                NLUContext nluContext) {
+        Tuple<Metadata.Intent, Float> prediction =
+              outputParser.getIntent(intents);
         Metadata.Intent intent = prediction.first();
         nluContext.traceDebug("Intent: %s", intent.getName());
 
         Map<String, String> slots = outputParser.getSlots(
               nluContext,
               encoded,
-              this.nluModel.outputs(1));
+              tags);
         Map<String, Slot> parsedSlots = outputParser.parseSlots(intent, slots);
         nluContext.traceDebug("Slots: %s", parsedSlots.toString());
 
@@ -307,17 +604,27 @@ public final class TensorflowNLU implements NLUService {
               .build();
     }
 
-    private int[] pad(List<Integer> ids) {
-        if (ids.size() > this.maxTokens) {
+    private int selectBucket(int tokens) {
+        if (tokens > this.maxTokens) {
             throw new IllegalArgumentException(
-                  "input: " + ids.size() + " tokens; max input length is: "
+                  "input: " + tokens + " tokens; max input length is: "
                         + this.maxTokens);
         }
-        int[] padded = new int[this.maxTokens];
+        // shorter buckets must also fit the separator token
+        int bucket = 0;
+        while (bucket < this.inputLengths.length - 1
+              && this.inputLengths[bucket] <= tokens) {
+            bucket++;
+        }
+        return bucket;
+    }
+
+    private int[] pad(List<Integer> ids, int length) {
+        int[] padded = new int[length];
         for (int i = 0; i < ids.size(); i++) {
             padded[i] = ids.get(i);
         }
-        if (ids.size() < this.maxTokens) {
+        if (ids.size() < length) {
             padded[ids.size()] = sepTokenId;
             // if padTokenId is 0, we can rely on the fact that that's the
             // default value for primitive ints and not bother re-filling the
@@ -0,0 +1,179 @@
+package io.spokestack.spokestack.tensorflow;
+
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.IOException;
+import java.lang.ref.SoftReference;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
+import java.util.HashMap;
+import java.util.Map;
+
+/**
+ * a process-wide, reference-counted cache of memory-mapped model files.
+ *
+ * <p>
+ * Each {@link TensorflowModel} needs its own interpreter, since interpreters
+ * are not thread-safe, but the model bytes an interpreter runs are
+ * read-only and can be shared. The cache maps each model file once, keyed
+ * by its canonical path, length and modification time, and hands the same
+ * buffer to every interpreter that loads it, such as the wakeword models of
+ * two pipelines. The mapped bytes are independent of any interpreter
+ * options, so interpreters configured differently still share them.
+ * </p>
+ *
+ * <p>
+ * A model file replaced at the same path (such as by a model rollout) is
+ * mapped again the next time it is acquired. Models still using the
+ * previous file keep their own buffer until they release it.
+ * </p>
+ *
+ * <p>
+ * Once the last model using a file is closed, the cache holds its buffer
+ * softly, so that a restarted pipeline can reuse it without remapping the
+ * file, unless the memory is needed elsewhere first.
+ * </p>
+ */
+public final class ModelCache {
+    private static final Map<String, Entry> ENTRIES = new HashMap<>();
+    private static long reuses;
+
+    private ModelCache() {
+    }
+
+    /**
+     * acquires a reference to a model file's bytes, mapping the file if it
+     * is not already cached.
+     * @param path the file system path to the model file
+     * @return the mapped model bytes, which must not be modified
+     * @throws IOException if the file cannot be mapped
+     */
+    public static synchronized MappedByteBuffer acquire(String path)
+            throws IOException {
+        File file = new File(path).getCanonicalFile();
+        String canonical = file.getPath();
+        String key = canonical + ":" + file.length()
+            + ":" + file.lastModified();
+        Entry entry = ENTRIES.get(key);
+        MappedByteBuffer buffer = entry != null ? entry.get() : null;
+        if (buffer == null) {
+            // discard unreferenced mappings of a replaced file
+            ENTRIES.values().removeIf(
+                stale -> stale.path.equals(canonical) && stale.refs == 0);
+            buffer = map(canonical);
+            entry = new Entry(canonical, buffer);
+            ENTRIES.put(key, entry);
+        } else {
+            reuses++;
+        }
+        entry.retain(buffer);
+        return buffer;
+    }
+
+    /**
+     * releases a reference acquired by {@link #acquire(String)}. the
+     * reference is identified by its buffer rather than its path, since the
+     * file at the path may have been replaced since it was acquired.
+     * @param buffer the model bytes returned by {@link #acquire(String)}
+     */
+    public static synchronized void release(MappedByteBuffer buffer) {
+        for (Entry entry : ENTRIES.values()) {
+            if (entry.get() == buffer) {
+                entry.release();
+                return;
+            }
+        }
+    }
+
+    /**
+     * @return the number of model files currently referenced
+     */
+    public static synchronized int getReferencedCount() {
+        int count = 0;
+        for (Entry entry : ENTRIES.values()) {
+            if (entry.refs > 0)
+                count++;
+        }
+        return count;
+    }
+
+    /**
+     * @return the size of all referenced model files, in bytes
+     */
+    public static synchronized long getResidentBytes() {
+        long bytes = 0;
+        for (Entry entry : ENTRIES.values()) {
+            if (entry.refs > 0)
+                bytes += entry.size;
+        }
+        return bytes;
+    }
+
+    /**
+     * @return the number of bytes saved by sharing referenced model files,
+     * compared to loading a separate copy for every model
+     */
+    public static synchronized long getSavedBytes() {
+        long bytes = 0;
+        for (Entry entry : ENTRIES.values()) {
+            if (entry.refs > 1)
+                bytes += (entry.refs - 1) * entry.size;
+        }
+        return bytes;
+    }
+
+    /**
+     * @return the number of times a cached model file was reused rather
+     * than mapped
+     */
+    public static synchronized long getReuses() {
+        return reuses;
+    }
+
+    /**
+     * discards all cached model files that are no longer referenced.
+     */
+    public static synchronized void trim() {
+        ENTRIES.values().removeIf(entry -> entry.refs == 0);
+    }
+
+    private static MappedByteBuffer map(String path) throws IOException {
+        try (FileInputStream stream = new FileInputStream(path);
+             FileChannel channel = stream.getChannel()) {
+            return channel.map(FileChannel.MapMode.READ_ONLY, 0,
+                channel.size());
+        }
+    }
+
+    /**
+     * a cached model file, held strongly while referenced, and softly
+     * otherwise.
+     */
+    private static final class Entry {
+        private final String path;
+        private final SoftReference<MappedByteBuffer> soft;
+        private final long size;
+        private MappedByteBuffer strong;
+        private int refs;
+
+        Entry(String filePath, MappedByteBuffer buffer) {
+            this.path = filePath;
+            this.soft = new SoftReference<>(buffer);
+            this.size = buffer.capacity();
+        }
+
+        MappedByteBuffer get() {
+            return this.strong != null ? this.strong : this.soft.get();
+        }
+
+        void retain(MappedByteBuffer buffer) {
+            this.strong = buffer;
+            this.refs++;
+        }
+
+        void release() {
+            if (this.refs > 0 && --this.refs == 0)
+                this.strong = null;
+        }
+    }
+}
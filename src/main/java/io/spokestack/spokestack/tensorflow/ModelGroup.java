@@ -0,0 +1,252 @@
+package io.spokestack.spokestack.tensorflow;
+
+import io.spokestack.spokestack.SpeechConfig;
+import io.spokestack.spokestack.util.StartupTimeline;
+
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * a group of tensorflow models loaded together behind a readiness barrier.
+ *
+ * <p>
+ * Serial groups load each model on the calling thread as it is added, as
+ * speech pipeline stages have traditionally loaded their models in their
+ * constructors. Parallel groups instead load each model on its own
+ * background thread, so that a stage can be constructed (and the pipeline
+ * started) immediately, and the stage can poll {@link #isReady()} until
+ * all of its models have loaded. In either case, the time taken to load
+ * each model is recorded, for tracing, and added to the
+ * {@link StartupTimeline} attached to the constructing thread, if any.
+ * </p>
+ *
+ * <p>
+ * Models are added on the constructing thread. The readiness methods and
+ * {@link #get(int)} are called by a single consumer thread, such as the
+ * speech pipeline thread.
+ * </p>
+ */
+public final class ModelGroup implements AutoCloseable {
+    private final boolean parallel;
+    private final StartupTimeline startup = StartupTimeline.current();
+    private final List<Slot> slots = new ArrayList<>();
+    private boolean ready;
+
+    /**
+     * constructs a new model group, configured by the {@code model-loading}
+     * property: {@code serial} (the default) to load models on the calling
+     * thread, or {@code parallel} to load them on background threads.
+     * @param config the speech pipeline configuration
+     */
+    public ModelGroup(SpeechConfig config) {
+        this(parseLoading(config.getString("model-loading", "serial")));
+    }
+
+    /**
+     * constructs a new model group.
+     * @param loadParallel true to load models on background threads,
+     *                     false to load them on the calling thread
+     */
+    public ModelGroup(boolean loadParallel) {
+        this.parallel = loadParallel;
+    }
+
+    /**
+     * adds a model to the group, loading it with the loader's current
+     * configuration. the loader is reset, so that it can be configured for
+     * the next model.
+     * @param name   the model's name, for tracing
+     * @param loader the loader configured for the model
+     * @return the model's index in the group
+     */
+    public int add(String name, TensorflowModel.Loader loader) {
+        Slot slot = new Slot(name);
+        if (this.startup != null) {
+            slot.startup = this.startup;
+            slot.startupName = this.startup.qualify("model " + name);
+        }
+        if (this.parallel) {
+            TensorflowModel.Loader snapshot = loader.copy();
+            loader.reset();
+            slot.thread = new Thread(
+                () -> slot.loadInBackground(snapshot),
+                "Spokestack-model-loader");
+            slot.thread.setDaemon(true);
+            slot.thread.start();
+        } else {
+            slot.load(loader);
+            loader.reset();
+        }
+        this.slots.add(slot);
+        return this.slots.size() - 1;
+    }
+
+    private static boolean parseLoading(String loading) {
+        if (loading.equals("serial"))
+            return false;
+        if (loading.equals("parallel"))
+            return true;
+        throw new IllegalArgumentException("model-loading");
+    }
+
+    /**
+     * @return the number of models in the group
+     */
+    public int size() {
+        return this.slots.size();
+    }
+
+    /**
+     * checks whether all models have finished loading, without blocking.
+     * @return true if all models have finished loading (successfully or
+     * not), false otherwise
+     */
+    public boolean isReady() {
+        if (!this.ready) {
+            for (Slot slot : this.slots) {
+                if (slot.thread != null && slot.thread.isAlive())
+                    return false;
+            }
+            this.ready = true;
+        }
+        return true;
+    }
+
+    /**
+     * waits for all models to finish loading.
+     * @throws InterruptedException if interrupted while waiting
+     */
+    public void await() throws InterruptedException {
+        if (!this.ready) {
+            for (Slot slot : this.slots) {
+                if (slot.thread != null)
+                    slot.thread.join();
+            }
+            this.ready = true;
+        }
+    }
+
+    /**
+     * returns a loaded model. the group must be ready.
+     * @param index the model's index
+     * @return the loaded model
+     * @throws IllegalStateException if the model failed to load
+     */
+    public TensorflowModel get(int index) {
+        if (!this.ready)
+            throw new IllegalStateException("not ready");
+        Slot slot = this.slots.get(index);
+        if (slot.error != null)
+            throw new IllegalStateException(
+                "failed to load " + slot.name,
+                slot.error);
+        return slot.model;
+    }
+
+    /**
+     * @param index the model's index
+     * @return the model's name
+     */
+    public String getName(int index) {
+        return this.slots.get(index).name;
+    }
+
+    /**
+     * returns the time taken to load a model. the group must be ready.
+     * @param index the model's index
+     * @return the load time, in nanoseconds
+     */
+    public long getLoadTime(int index) {
+        if (!this.ready)
+            throw new IllegalStateException("not ready");
+        return this.slots.get(index).loadTime;
+    }
+
+    /**
+     * verifies that this group's models can replace another group's, by
+     * comparing the element counts of their primary input and output
+     * tensors and their number of state tensors. a model that failed to
+     * load in the previous group can be replaced by any model, so that a
+     * swap can recover from a failed load. both groups must be ready.
+     * @param previous the group being replaced
+     * @throws IllegalStateException if a model in this group failed to load,
+     *                               or does not match the model it replaces
+     */
+    public void checkCompatible(ModelGroup previous) {
+        if (size() != previous.size())
+            throw new IllegalStateException("model count");
+        for (int i = 0; i < size(); i++) {
+            TensorflowModel next = get(i);
+            if (previous.slots.get(i).error != null)
+                continue;
+            TensorflowModel current = previous.get(i);
+            if (inputElements(next) != inputElements(current)
+                    || outputElements(next) != outputElements(current)
+                    || next.getStateCount() != current.getStateCount())
+                throw new IllegalStateException(
+                    "incompatible " + getName(i) + " model");
+        }
+    }
+
+    private static int inputElements(TensorflowModel model) {
+        return model.inputs(0).capacity() / model.inputFormat(0).getSize();
+    }
+
+    private static int outputElements(TensorflowModel model) {
+        return model.outputs(0).capacity() / model.outputFormat(0).getSize();
+    }
+
+    /**
+     * closes all loaded models, waiting for any that are still loading.
+     */
+    @Override
+    public void close() {
+        for (Slot slot : this.slots) {
+            if (slot.thread != null) {
+                try {
+                    slot.thread.join();
+                } catch (InterruptedException e) {
+                    Thread.currentThread().interrupt();
+                }
+            }
+            if (slot.model != null)
+                slot.model.close();
+        }
+    }
+
+    /**
+     * a model loaded by the group. fields written by the loader thread are
+     * published to the consumer by joining (or observing the death of)
+     * the thread.
+     */
+    private static final class Slot {
+        private final String name;
+        private StartupTimeline startup;
+        private String startupName;
+        private Thread thread;
+        private TensorflowModel model;
+        private Throwable error;
+        private long loadTime;
+
+        Slot(String modelName) {
+            this.name = modelName;
+        }
+
+        void load(TensorflowModel.Loader loader) {
+            long start = System.nanoTime();
+            this.model = loader.load();
+            long end = System.nanoTime();
+            this.loadTime = end - start;
+            if (this.startup != null)
+                this.startup.add(this.startupName, start, end);
+        }
+
+        void loadInBackground(TensorflowModel.Loader loader) {
+            try {
+                load(loader);
+            } catch (Exception | Error e) {
+                this.error = e;
+            }
+        }
+    }
+}
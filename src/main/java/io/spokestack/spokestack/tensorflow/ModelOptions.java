@@ -0,0 +1,163 @@
+package io.spokestack.spokestack.tensorflow;
+
+import io.spokestack.spokestack.SpeechConfig;
+import org.tensorflow.lite.Interpreter;
+
+/**
+ * TensorFlow Lite interpreter options for a model.
+ *
+ * <p>
+ * Options are read from the speech configuration under a component prefix
+ * ({@code wake}, {@code keyword} or {@code nlu}), so that each component's
+ * models can be tuned separately. All options default to the interpreter's
+ * own defaults.
+ * </p>
+ * <ul>
+ *   <li>
+ *      <b>&lt;prefix&gt;-threads</b> (integer): the number of threads the
+ *      interpreter may use for inference
+ *   </li>
+ *   <li>
+ *      <b>&lt;prefix&gt;-xnnpack</b> (string): {@code true} to run
+ *      floating-point operations on the XNNPACK delegate, {@code false}
+ *      (the default) to use the built-in kernels
+ *   </li>
+ *   <li>
+ *      <b>&lt;prefix&gt;-fp16</b> (string): {@code true} to allow 32-bit
+ *      floating-point operations to be computed at 16-bit precision, where
+ *      supported, {@code false} (the default) otherwise
+ *   </li>
+ *   <li>
+ *      <b>&lt;prefix&gt;-cancellable</b> (string): {@code true} to allow
+ *      inference to be cancelled from another thread via
+ *      {@link TensorflowModel#setCancelled(boolean)}, {@code false} (the
+ *      default) otherwise
+ *   </li>
+ * </ul>
+ */
+public final class ModelOptions {
+    private static final int DEFAULT_THREADS = -1;
+
+    private int threads;
+    private boolean xnnpack;
+    private boolean fp16;
+    private boolean cancellable;
+
+    /**
+     * constructs a new options instance with the interpreter's defaults.
+     */
+    public ModelOptions() {
+        this.threads = DEFAULT_THREADS;
+    }
+
+    /**
+     * constructs a new options instance from the speech configuration.
+     * @param config the speech configuration
+     * @param prefix the component prefix for the option keys
+     */
+    public ModelOptions(SpeechConfig config, String prefix) {
+        this.threads = config.getInteger(prefix + "-threads", DEFAULT_THREADS);
+        this.xnnpack = parseFlag(config, prefix + "-xnnpack");
+        this.fp16 = parseFlag(config, prefix + "-fp16");
+        this.cancellable = parseFlag(config, prefix + "-cancellable");
+        if (this.threads == 0 || this.threads < DEFAULT_THREADS)
+            throw new IllegalArgumentException(prefix + "-threads");
+    }
+
+    private static boolean parseFlag(SpeechConfig config, String key) {
+        String value = config.getString(key, "false");
+        if (value.equals("true"))
+            return true;
+        if (value.equals("false"))
+            return false;
+        throw new IllegalArgumentException(key);
+    }
+
+    /**
+     * @return the number of inference threads, or -1 for the interpreter's
+     * default
+     */
+    public int getThreads() {
+        return this.threads;
+    }
+
+    /**
+     * @return true if the XNNPACK delegate is enabled
+     */
+    public boolean isXnnpack() {
+        return this.xnnpack;
+    }
+
+    /**
+     * @return true if 16-bit floating-point precision is allowed
+     */
+    public boolean isFp16() {
+        return this.fp16;
+    }
+
+    /**
+     * @return true if inference may be cancelled
+     */
+    public boolean isCancellable() {
+        return this.cancellable;
+    }
+
+    /**
+     * sets the number of inference threads.
+     * @param value the thread count, or -1 for the interpreter's default
+     * @return this
+     */
+    public ModelOptions setThreads(int value) {
+        this.threads = value;
+        return this;
+    }
+
+    /**
+     * enables or disables the XNNPACK delegate.
+     * @param value true to enable the delegate
+     * @return this
+     */
+    public ModelOptions setXnnpack(boolean value) {
+        this.xnnpack = value;
+        return this;
+    }
+
+    /**
+     * allows or disallows 16-bit floating-point precision.
+     * @param value true to allow reduced precision
+     * @return this
+     */
+    public ModelOptions setFp16(boolean value) {
+        this.fp16 = value;
+        return this;
+    }
+
+    /**
+     * allows or disallows cancellation.
+     * @param value true to allow cancellation
+     * @return this
+     */
+    public ModelOptions setCancellable(boolean value) {
+        this.cancellable = value;
+        return this;
+    }
+
+    /**
+     * @return the equivalent interpreter options
+     */
+    Interpreter.Options toInterpreterOptions() {
+        return new Interpreter.Options()
+            .setNumThreads(this.threads)
+            .setUseXNNPACK(this.xnnpack)
+            .setAllowFp16PrecisionForFp32(this.fp16)
+            .setCancellable(this.cancellable);
+    }
+
+    @Override
+    public String toString() {
+        return "threads=" + this.threads
+            + ",xnnpack=" + this.xnnpack
+            + ",fp16=" + this.fp16
+            + ",cancellable=" + this.cancellable;
+    }
+}
@@ -0,0 +1,169 @@
+package io.spokestack.spokestack.tensorflow;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.HashMap;
+import java.util.Map;
+
+/**
+ * the input and output tensor buffers of a model, bound once to the
+ * argument structures passed to the interpreter.
+ *
+ * <p>
+ * A model with state tensors (such as stacked recurrent layers or
+ * streaming convolution caches) feeds each state output back as the
+ * corresponding state input of the next run. Rather than swapping the
+ * buffers in place on every run, the bindings keep two complete sets of
+ * arguments, identical except that every input/output state pair is
+ * exchanged, and flip between them. A run therefore rewinds the buffers
+ * and flips an index, without allocating, however many states there are.
+ * </p>
+ */
+final class TensorBindings {
+    private final ByteBuffer[][] inputs = new ByteBuffer[2][];
+    private final ByteBuffer[][] outputs = new ByteBuffer[2][];
+    private final Object[][] inputArrays = new Object[2][];
+    private final Map<Integer, Object>[] outputMaps;
+    private final int[] stateInputs;
+    private int phase;
+
+    /**
+     * allocates and binds the tensor buffers.
+     * @param inputSizes  the byte size of each input tensor
+     * @param outputSizes the byte size of each output tensor
+     * @param statePairs  the input index and output index of each state
+     *                    tensor, as {@code {input, output}} pairs
+     */
+    @SuppressWarnings("unchecked")
+    TensorBindings(int[] inputSizes, int[] outputSizes, int[][] statePairs) {
+        this.stateInputs = new int[statePairs.length];
+        this.outputMaps = (Map<Integer, Object>[]) new Map[2];
+
+        this.inputs[0] = allocate(inputSizes);
+        this.outputs[0] = allocate(outputSizes);
+        this.inputs[1] = this.inputs[0].clone();
+        this.outputs[1] = this.outputs[0].clone();
+        for (int k = 0; k < statePairs.length; k++) {
+            int in = statePairs[k][0];
+            int out = statePairs[k][1];
+            if (this.inputs[1][in] != this.inputs[0][in]
+                    || this.outputs[1][out] != this.outputs[0][out])
+                throw new IllegalArgumentException("duplicate state tensor");
+            if (inputSizes[in] != outputSizes[out])
+                throw new IllegalArgumentException("state sizes differ");
+            this.inputs[1][in] = this.outputs[0][out];
+            this.outputs[1][out] = this.inputs[0][in];
+            this.stateInputs[k] = in;
+        }
+
+        for (int p = 0; p < 2; p++) {
+            this.inputArrays[p] = this.inputs[p].clone();
+            this.outputMaps[p] = new HashMap<>();
+            for (int i = 0; i < this.outputs[p].length; i++)
+                this.outputMaps[p].put(i, this.outputs[p][i]);
+        }
+    }
+
+    private static ByteBuffer[] allocate(int[] sizes) {
+        ByteBuffer[] buffers = new ByteBuffer[sizes.length];
+        for (int i = 0; i < sizes.length; i++) {
+            buffers[i] = ByteBuffer
+                .allocateDirect(sizes[i])
+                .order(ByteOrder.nativeOrder());
+        }
+        return buffers;
+    }
+
+    /**
+     * @return the number of input tensors
+     */
+    int getInputCount() {
+        return this.inputs[0].length;
+    }
+
+    /**
+     * @return the number of output tensors
+     */
+    int getOutputCount() {
+        return this.outputs[0].length;
+    }
+
+    /**
+     * @param index the input index
+     * @return the current buffer for the input
+     */
+    ByteBuffer input(int index) {
+        return this.inputs[this.phase][index];
+    }
+
+    /**
+     * @param index the output index
+     * @return the current buffer for the output
+     */
+    ByteBuffer output(int index) {
+        return this.outputs[this.phase][index];
+    }
+
+    /**
+     * @return the number of state tensors
+     */
+    int getStateCount() {
+        return this.stateInputs.length;
+    }
+
+    /**
+     * @param index the state index
+     * @return the input index of the state tensor
+     */
+    int getStateInput(int index) {
+        return this.stateInputs[index];
+    }
+
+    /**
+     * @param index the state index
+     * @return the current input buffer for the state
+     */
+    ByteBuffer state(int index) {
+        return this.inputs[this.phase][this.stateInputs[index]];
+    }
+
+    /**
+     * @return the current input arguments for the interpreter
+     */
+    Object[] inputArray() {
+        return this.inputArrays[this.phase];
+    }
+
+    /**
+     * @return the current output arguments for the interpreter
+     */
+    Map<Integer, Object> outputMap() {
+        return this.outputMaps[this.phase];
+    }
+
+    /**
+     * prepares the current buffers for a run, rewinding the inputs (which
+     * the caller has filled) and the outputs (which the interpreter fills).
+     */
+    void prepare() {
+        ByteBuffer[] in = this.inputs[this.phase];
+        for (int i = 0; i < in.length; i++)
+            in[i].rewind();
+        ByteBuffer[] out = this.outputs[this.phase];
+        for (int i = 0; i < out.length; i++)
+            out[i].rewind();
+    }
+
+    /**
+     * completes a run, rewinding the outputs for the caller and feeding the
+     * state outputs back as the next state inputs. the interpreter does not
+     * move the inputs, which were rewound by {@link #prepare()}.
+     */
+    void complete() {
+        ByteBuffer[] out = this.outputs[this.phase];
+        for (int i = 0; i < out.length; i++)
+            out[i].rewind();
+        if (this.stateInputs.length > 0)
+            this.phase ^= 1;
+    }
+}
@@ -0,0 +1,154 @@
+package io.spokestack.spokestack.tensorflow;
+
+import io.spokestack.spokestack.tensorflow.TensorflowModel.Loader.DType;
+
+import java.nio.ByteBuffer;
+
+/**
+ * the element encoding of a model's input or output tensor.
+ *
+ * <p>
+ * Feature producers work in real (floating-point) values. A format encodes
+ * those values into a tensor buffer, and decodes them back out, according
+ * to the tensor's data type. Quantized types map a real value {@code r} to
+ * the integer {@code q = round(r / scale) + zeroPoint}, clamped to the
+ * type's range, and back via {@code r = (q - zeroPoint) * scale}.
+ * </p>
+ *
+ * <p>
+ * All methods use the buffer's current position, and advance it by one
+ * element, like {@link ByteBuffer#putFloat(float)} and
+ * {@link ByteBuffer#getFloat()}.
+ * </p>
+ */
+public final class TensorFormat {
+    /** 32-bit floating point elements. */
+    public static final TensorFormat FLOAT = new TensorFormat(DType.FLOAT);
+
+    /** 32-bit integer elements. */
+    public static final TensorFormat INT32 = new TensorFormat(DType.INT32);
+
+    private final DType type;
+    private final float scale;
+    private final int zeroPoint;
+
+    /**
+     * constructs a new unquantized format.
+     * @param dataType the element data type
+     */
+    public TensorFormat(DType dataType) {
+        this(dataType, 1, 0);
+    }
+
+    /**
+     * constructs a new quantized format.
+     * @param dataType the element data type
+     * @param quantScale the quantization scale
+     * @param quantZero the quantization zero point
+     */
+    public TensorFormat(DType dataType, float quantScale, int quantZero) {
+        if (quantScale <= 0)
+            throw new IllegalArgumentException("scale");
+        this.type = dataType;
+        this.scale = quantScale;
+        this.zeroPoint = quantZero;
+    }
+
+    /**
+     * @return the element data type
+     */
+    public DType getType() {
+        return this.type;
+    }
+
+    /**
+     * @return the quantization scale, or 1 for unquantized types
+     */
+    public float getScale() {
+        return this.scale;
+    }
+
+    /**
+     * @return the quantization zero point, or 0 for unquantized types
+     */
+    public int getZeroPoint() {
+        return this.zeroPoint;
+    }
+
+    /**
+     * @return the size of each element, in bytes
+     */
+    public int getSize() {
+        return this.type.getSize();
+    }
+
+    /**
+     * encodes a value into a buffer.
+     * @param buffer the tensor buffer
+     * @param value  the real value to encode
+     */
+    public void put(ByteBuffer buffer, float value) {
+        switch (this.type) {
+            case INT8:
+                buffer.put((byte) quantize(value, Byte.MIN_VALUE,
+                    Byte.MAX_VALUE));
+                break;
+            case UINT8:
+                buffer.put((byte) quantize(value, 0, 0xFF));
+                break;
+            case INT32:
+                buffer.putInt(Math.round(value));
+                break;
+            default:
+                buffer.putFloat(value);
+                break;
+        }
+    }
+
+    /**
+     * decodes a value from a buffer.
+     * @param buffer the tensor buffer
+     * @return the decoded real value
+     */
+    public float get(ByteBuffer buffer) {
+        switch (this.type) {
+            case INT8:
+                return (buffer.get() - this.zeroPoint) * this.scale;
+            case UINT8:
+                return ((buffer.get() & 0xFF) - this.zeroPoint) * this.scale;
+            case INT32:
+                return buffer.getInt();
+            default:
+                return buffer.getFloat();
+        }
+    }
+
+    private int quantize(float value, int min, int max) {
+        int q = Math.round(value / this.scale) + this.zeroPoint;
+        return Math.max(min, Math.min(max, q));
+    }
+
+    @Override
+    public boolean equals(Object other) {
+        if (!(other instanceof TensorFormat))
+            return false;
+        TensorFormat format = (TensorFormat) other;
+        return this.type == format.type
+            && this.scale == format.scale
+            && this.zeroPoint == format.zeroPoint;
+    }
+
+    @Override
+    public int hashCode() {
+        int hash = this.type.hashCode();
+        hash = 31 * hash + Float.floatToIntBits(this.scale);
+        return 31 * hash + this.zeroPoint;
+    }
+
+    @Override
+    public String toString() {
+        if (this.type == DType.INT8 || this.type == DType.UINT8)
+            return this.type + "(" + this.scale + "," + this.zeroPoint + ")";
+        return this.type.toString();
+    }
+}
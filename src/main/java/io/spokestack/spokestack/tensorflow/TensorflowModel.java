@@ -1,14 +1,15 @@
 package io.spokestack.spokestack.tensorflow;
 
+import org.tensorflow.lite.DataType;
 import org.tensorflow.lite.Interpreter;
+import org.tensorflow.lite.Tensor;
 
-import java.io.File;
+import java.io.IOException;
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
+import java.nio.MappedByteBuffer;
 import java.util.ArrayList;
-import java.util.HashMap;
 import java.util.List;
-import java.util.Map;
 
 /**
  * Tensorflow-Lite model wrapper and loader
@@ -17,46 +18,167 @@ import java.util.Map;
  * This class wraps the TensorFlow Lite interpreter so that it can be mocked
  * for unit testing on non-android platforms. It also encapsulates the
  * input/output byte buffers used for passing input tensors into a model
- * and retrieving outputs.
+ * and retrieving outputs. The buffers are bound to the interpreter's
+ * arguments once, when the model is loaded, so that running the model does
+ * not allocate.
+ * </p>
+ *
+ * <p>
+ * Each tensor's {@link TensorFormat} is taken from the model, so quantized
+ * (8-bit integer) inputs and outputs are supported alongside 32-bit ones.
+ * Callers encode and decode the buffers with the format returned by
+ * {@link #inputFormat(int)} and {@link #outputFormat(int)}, rather than
+ * assuming 32-bit floats. Models with 16-bit floating-point weights
+ * dequantize them internally and keep 32-bit floating-point inputs and
+ * outputs, so they need no special handling.
+ * </p>
+ *
+ * <p>
+ * A stateless model whose inputs have a batch (first) dimension can be
+ * resized via {@link #setBatchSize(int)} to run several inputs at once.
+ * Each input and output buffer then holds one row per batch entry,
+ * consecutively. Similarly, a model whose inputs have a sequence (second)
+ * dimension, such as the token dimension of a text model, can be resized
+ * via {@link #setInputLength(int)} to run shorter sequences.
  * </p>
  */
 public class TensorflowModel implements AutoCloseable {
+    private final String path;
+    private final MappedByteBuffer modelBytes;
     private final Interpreter interpreter;
-    private final List<ByteBuffer> inputBuffers = new ArrayList<>();
-    private final List<ByteBuffer> outputBuffers = new ArrayList<>();
-    private final int inputSize;
-
-    private final Object[] inputArray;
-    private final Map<Integer, Object> outputMap;
-
-    private Integer statePosition;
+    private TensorBindings bindings;
+    private int batchSize;
+    private int inputLength;
+    private final TensorFormat[] inputFormats;
+    private final TensorFormat[] outputFormats;
+    private final byte[][] stateResets;
+    private final boolean cancellable;
+    private boolean closed;
 
     /**
-     * constructs a new tensorflow model.
+     * constructs a new tensorflow model. the model's bytes are shared with
+     * any other models loaded from the same file, via the {@link ModelCache},
+     * and the interpreter is configured with the loader's
+     * {@link ModelOptions}.
      *
      * @param loader the loader (builder) for the model
      */
     public TensorflowModel(Loader loader) {
-        this.interpreter = new Interpreter(new File(loader.path));
-        for (int i = 0; i < this.interpreter.getInputTensorCount(); i++) {
-            int[] shape = this.interpreter.getInputTensor(i).shape();
-            int combinedShape = combineShape(shape);
-            this.inputBuffers.add(
-                  ByteBuffer.allocateDirect(combinedShape * loader.inputSize)
-                        .order(ByteOrder.nativeOrder()));
+        this.path = loader.path;
+        try {
+            this.modelBytes = ModelCache.acquire(this.path);
+        } catch (IOException e) {
+            throw new IllegalArgumentException(
+                  "invalid model: " + this.path, e);
         }
-        for (int i = 0; i < this.interpreter.getOutputTensorCount(); i++) {
-            int[] shape = this.interpreter.getOutputTensor(i).shape();
-            int combinedShape = combineShape(shape);
-            this.outputBuffers.add(
-                  ByteBuffer.allocateDirect(combinedShape * loader.outputSize)
-                        .order(ByteOrder.nativeOrder()));
+
+        // any failure once the model bytes are acquired must release them,
+        // along with the interpreter, if it was created
+        Interpreter created = null;
+        try {
+            created = new Interpreter(
+                  this.modelBytes,
+                  loader.options.toInterpreterOptions());
+            this.interpreter = created;
+            int inputCount = this.interpreter.getInputTensorCount();
+            this.inputFormats = new TensorFormat[inputCount];
+            for (int i = 0; i < inputCount; i++) {
+                this.inputFormats[i] =
+                      formatOf(this.interpreter.getInputTensor(i));
+            }
+            int outputCount = this.interpreter.getOutputTensorCount();
+            this.outputFormats = new TensorFormat[outputCount];
+            for (int i = 0; i < outputCount; i++) {
+                this.outputFormats[i] =
+                      formatOf(this.interpreter.getOutputTensor(i));
+            }
+            int[] inputSizes = inputSizes();
+            int[] outputSizes = outputSizes();
+            int[] firstShape = this.interpreter.getInputTensor(0).shape();
+            this.batchSize = firstShape.length > 0 ? firstShape[0] : 1;
+            this.inputLength = firstShape.length > 1 ? firstShape[1] : 1;
+
+            int[][] statePairs = loader.statePairs.toArray(new int[0][]);
+            this.bindings = bindStates(inputSizes, outputSizes, statePairs);
+
+            // precompute the encoded initial value of each state, so that
+            // states can be reset with a single bulk copy
+            this.stateResets = new byte[statePairs.length][];
+            for (int k = 0; k < statePairs.length; k++) {
+                TensorFormat format = this.inputFormats[statePairs[k][0]];
+                ByteBuffer reset = ByteBuffer
+                      .wrap(new byte[inputSizes[statePairs[k][0]]])
+                      .order(ByteOrder.nativeOrder());
+                while (reset.hasRemaining()) {
+                    format.put(reset, 0);
+                }
+                this.stateResets[k] = reset.array();
+            }
+            this.cancellable = loader.options.isCancellable();
+        } catch (RuntimeException | Error e) {
+            if (created != null) {
+                created.close();
+            }
+            ModelCache.release(this.modelBytes);
+            throw e;
+        }
+    }
+
+    private TensorBindings bindStates(int[] inputSizes,
+                                      int[] outputSizes,
+                                      int[][] statePairs) {
+        // each state output is fed back as its state input unchanged,
+        // so both must be encoded identically
+        try {
+            for (int[] pair : statePairs) {
+                if (!this.inputFormats[pair[0]]
+                      .equals(this.outputFormats[pair[1]]))
+                    throw new IllegalArgumentException("state formats differ");
+            }
+            return new TensorBindings(inputSizes, outputSizes, statePairs);
+        } catch (RuntimeException e) {
+            throw new IllegalArgumentException(
+                  "invalid state tensors: " + this.path, e);
+        }
+    }
+
+    private static TensorFormat formatOf(Tensor tensor) {
+        DataType type = tensor.dataType();
+        if (type == DataType.FLOAT32)
+            return TensorFormat.FLOAT;
+        if (type == DataType.INT32)
+            return TensorFormat.INT32;
+        if (type != DataType.INT8 && type != DataType.UINT8)
+            throw new IllegalArgumentException("unsupported tensor: " + type);
+
+        Loader.DType dtype = type == DataType.INT8
+              ? Loader.DType.INT8
+              : Loader.DType.UINT8;
+        Tensor.QuantizationParams params = tensor.quantizationParams();
+        if (params.getScale() <= 0)
+            return new TensorFormat(dtype);
+        return new TensorFormat(
+              dtype,
+              params.getScale(),
+              params.getZeroPoint());
+    }
+
+    private int[] inputSizes() {
+        int[] sizes = new int[this.inputFormats.length];
+        for (int i = 0; i < sizes.length; i++) {
+            sizes[i] = combineShape(this.interpreter.getInputTensor(i).shape())
+                  * this.inputFormats[i].getSize();
         }
+        return sizes;
+    }
 
-        this.inputSize = loader.inputSize;
-        this.statePosition = loader.statePosition;
-        this.inputArray = new Object[this.inputBuffers.size()];
-        this.outputMap = new HashMap<>();
+    private int[] outputSizes() {
+        int[] sizes = new int[this.outputFormats.length];
+        for (int i = 0; i < sizes.length; i++) {
+            sizes[i] = combineShape(this.interpreter.getOutputTensor(i).shape())
+                  * this.outputFormats[i].getSize();
+        }
+        return sizes;
     }
 
     private int combineShape(int[] dims) {
@@ -68,17 +190,163 @@ public class TensorflowModel implements AutoCloseable {
     }
 
     /**
-     * @return the byte size of the model's inputs.
+     * @return the byte size of each element of the model's first input.
      */
     public int getInputSize() {
-        return inputSize;
+        return this.inputFormats[0].getSize();
+    }
+
+    /**
+     * @param index the input index
+     * @return the element format of the input tensor
+     */
+    public TensorFormat inputFormat(int index) {
+        return this.inputFormats[index];
+    }
+
+    /**
+     * @param index the output index
+     * @return the element format of the output tensor
+     */
+    public TensorFormat outputFormat(int index) {
+        return this.outputFormats[index];
+    }
+
+    /**
+     * @return the number of state tensors
+     */
+    public int getStateCount() {
+        return this.bindings.getStateCount();
+    }
+
+    /**
+     * @return the element format of the first state tensor, or null if the
+     * model is stateless
+     */
+    public TensorFormat stateFormat() {
+        if (getStateCount() == 0) {
+            return null;
+        }
+        return stateFormat(0);
+    }
+
+    /**
+     * @param index the state index
+     * @return the element format of the state tensor
+     */
+    public TensorFormat stateFormat(int index) {
+        return this.inputFormats[this.bindings.getStateInput(index)];
+    }
+
+    /**
+     * resets all state tensors to zero (encoded in each state's format),
+     * with a bulk copy per state.
+     */
+    public void resetStates() {
+        for (int k = 0; k < this.stateResets.length; k++) {
+            ByteBuffer state = this.bindings.state(k);
+            state.rewind();
+            state.put(this.stateResets[k]);
+            state.rewind();
+        }
+    }
+
+    /**
+     * @return the size of the model's batch (first input) dimension
+     */
+    public int getBatchSize() {
+        return this.batchSize;
+    }
+
+    /**
+     * resizes the batch (first) dimension of every input tensor, and binds
+     * new buffers to the resized input and output tensors. the contents of
+     * the previous buffers are discarded, so callers must fetch the buffers
+     * again after resizing. resizing to the current batch size does nothing.
+     *
+     * @param size the number of inputs to run at once
+     * @throws IllegalStateException if the model has state tensors, which
+     *                               are not batched
+     */
+    public void setBatchSize(int size) {
+        if (size < 1) {
+            throw new IllegalArgumentException("batch size");
+        }
+        if (size == this.batchSize) {
+            return;
+        }
+        resizeInputs(0, size);
+        this.batchSize = size;
+    }
+
+    /**
+     * @return the size of the model's sequence (second input) dimension
+     */
+    public int getInputLength() {
+        return this.inputLength;
+    }
+
+    /**
+     * resizes the sequence (second) dimension of every input tensor that
+     * has one, and binds new buffers as for {@link #setBatchSize(int)}.
+     * resizing to the current length does nothing.
+     *
+     * @param length the number of elements in each input sequence
+     * @throws IllegalStateException if the model has state tensors
+     */
+    public void setInputLength(int length) {
+        if (length < 1) {
+            throw new IllegalArgumentException("input length");
+        }
+        if (length == this.inputLength) {
+            return;
+        }
+        resizeInputs(1, length);
+        this.inputLength = length;
+    }
+
+    private void resizeInputs(int dimension, int size) {
+        if (getStateCount() > 0) {
+            throw new IllegalStateException("stateful model");
+        }
+        for (int i = 0; i < this.inputFormats.length; i++) {
+            int[] shape = this.interpreter.getInputTensor(i).shape();
+            if (shape.length > dimension) {
+                shape[dimension] = size;
+                this.interpreter.resizeInput(i, shape);
+            }
+        }
+        this.interpreter.allocateTensors();
+        this.bindings = new TensorBindings(
+              inputSizes(),
+              outputSizes(),
+              new int[0][]);
     }
 
     /**
-     * releases the tensorflow interpreter.
+     * releases the tensorflow interpreter and its reference to the cached
+     * model bytes.
      */
     public void close() {
-        this.interpreter.close();
+        if (!this.closed) {
+            this.closed = true;
+            this.interpreter.close();
+            ModelCache.release(this.modelBytes);
+        }
+    }
+
+    /**
+     * cancels (or stops cancelling) inference. while cancelled, any run in
+     * progress on another thread is aborted, as is any later run, with an
+     * {@link IllegalStateException}. the model must have been loaded with
+     * the cancellable option, otherwise this method has no effect.
+     *
+     * @param cancelled true to cancel inference, false to resume it
+     */
+    public void setCancelled(boolean cancelled) {
+        if (this.cancellable) {
+            this.interpreter.setCancelled(cancelled);
+        }
     }
 
     /**
@@ -88,17 +356,28 @@ public class TensorflowModel implements AutoCloseable {
      * @return the input tensor buffer at the specified index.
      */
     public ByteBuffer inputs(int index) {
-        return this.inputBuffers.get(index);
+        return this.bindings.input(index);
     }
 
     /**
-     * @return the state tensor buffer
+     * @return the first state tensor buffer, or null if the model is
+     * stateless
      */
     public ByteBuffer states() {
-        if (this.statePosition == null) {
+        if (getStateCount() == 0) {
             return null;
         }
-        return this.inputBuffers.get(this.statePosition);
+        return states(0);
+    }
+
+    /**
+     * Get the state input buffer at the specified index.
+     *
+     * @param index The index of the desired state.
+     * @return the state tensor buffer at the specified index.
+     */
+    public ByteBuffer states(int index) {
+        return this.bindings.state(index);
     }
 
     /**
@@ -108,45 +387,19 @@ public class TensorflowModel implements AutoCloseable {
      * @return the output tensor buffer at the specified index.
      */
     public ByteBuffer outputs(int index) {
-        return this.outputBuffers.get(index);
+        return this.bindings.output(index);
     }
 
     /**
-     * executes the model using the attached buffers.
+     * executes the model using the attached buffers. each state output
+     * becomes the corresponding state input for the next run.
      */
     public void run() {
-        for (ByteBuffer buffer : this.inputBuffers) {
-            buffer.rewind();
-        }
-        for (ByteBuffer buffer : this.outputBuffers) {
-            buffer.rewind();
-        }
-
-        for (int i = 0; i < this.inputBuffers.size(); i++) {
-            this.inputArray[i] = this.inputBuffers.get(i);
-        }
-        for (int i = 0; i < this.outputBuffers.size(); i++) {
-            this.outputMap.put(i, this.outputBuffers.get(i));
-        }
-
+        this.bindings.prepare();
         this.interpreter.runForMultipleInputsOutputs(
-              this.inputArray,
-              this.outputMap);
-
-        if (this.statePosition != null) {
-            ByteBuffer temp =
-                  this.inputBuffers.remove((int) this.statePosition);
-            ByteBuffer tempOutput =
-                  this.outputBuffers.remove((int) this.statePosition);
-            this.inputBuffers.add(this.statePosition, tempOutput);
-            this.outputBuffers.add(this.statePosition, temp);
-        }
-        for (ByteBuffer buffer : this.inputBuffers) {
-            buffer.rewind();
-        }
-        for (ByteBuffer buffer : this.outputBuffers) {
-            buffer.rewind();
-        }
+              this.bindings.inputArray(),
+              this.bindings.outputMap());
+        this.bindings.complete();
     }
 
     /**
@@ -160,13 +413,37 @@ public class TensorflowModel implements AutoCloseable {
             /**
              * 32-bit floating tensor.
              */
-            FLOAT
+            FLOAT(4),
+            /**
+             * 32-bit integer tensor.
+             */
+            INT32(4),
+            /**
+             * 8-bit signed quantized tensor.
+             */
+            INT8(1),
+            /**
+             * 8-bit unsigned quantized tensor.
+             */
+            UINT8(1);
+
+            private final int size;
+
+            DType(int bytes) {
+                this.size = bytes;
+            }
+
+            /**
+             * @return the size of each tensor element, in bytes
+             */
+            public int getSize() {
+                return this.size;
+            }
         }
 
         private String path;
-        private int inputSize;
-        private int outputSize;
-        private Integer statePosition = null;
+        private List<int[]> statePairs;
+        private ModelOptions options;
 
         /**
          * initializes a new loader instance.
@@ -182,9 +459,8 @@ public class TensorflowModel implements AutoCloseable {
          */
         public Loader reset() {
             this.path = null;
-            this.inputSize = 4;
-            this.outputSize = 4;
-            this.statePosition = null;
+            this.statePairs = new ArrayList<>();
+            this.options = new ModelOptions();
             return this;
         }
 
@@ -200,16 +476,84 @@ public class TensorflowModel implements AutoCloseable {
         }
 
         /**
-         * sets the position of the model's state tensor in its input array.
+         * sets the position of the model's only state tensor, which must be
+         * the same in its input and output arrays.
          *
          * @param position the position of the model's state tensor.
          * @return this
          */
         public Loader setStatePosition(int position) {
-            this.statePosition = position;
+            this.statePairs.clear();
+            return addStatePair(position, position);
+        }
+
+        /**
+         * adds a state tensor to the model. after each run, the state output
+         * is fed back as the state input for the next run.
+         *
+         * @param input  the position of the state in the input array
+         * @param output the position of the state in the output array
+         * @return this
+         */
+        public Loader addStatePair(int input, int output) {
+            this.statePairs.add(new int[] {input, output});
+            return this;
+        }
+
+        /**
+         * adds the model's state tensors from a specification string, a
+         * comma-separated list of {@code input:output} position pairs,
+         * where a single position is used for both the input and output
+         * (for example, {@code 1} or {@code 1:1,2:3}).
+         *
+         * @param spec the state tensor specification
+         * @return this
+         */
+        public Loader addStatePairs(String spec) {
+            try {
+                for (String pair : spec.split(",")) {
+                    String[] positions = pair.split(":", -1);
+                    int input = Integer.parseInt(positions[0].trim());
+                    int output = positions.length > 1
+                          ? Integer.parseInt(positions[1].trim())
+                          : input;
+                    if (positions.length > 2 || input < 0 || output < 0) {
+                        throw new IllegalArgumentException(spec);
+                    }
+                    addStatePair(input, output);
+                }
+            } catch (NumberFormatException e) {
+                throw new IllegalArgumentException(spec, e);
+            }
             return this;
         }
 
+        /**
+         * sets the interpreter options for the model.
+         *
+         * @param value value to assign
+         * @return this
+         */
+        public Loader setOptions(ModelOptions value) {
+            this.options = value;
+            return this;
+        }
+
+        /**
+         * creates a new loader with this loader's configuration, so that
+         * the model can be loaded on another thread while this loader is
+         * reused.
+         *
+         * @return the new loader
+         */
+        public Loader copy() {
+            Loader loader = new Loader();
+            loader.path = this.path;
+            loader.statePairs = new ArrayList<>(this.statePairs);
+            loader.options = this.options;
+            return loader;
+        }
+
         /**
          * loads the tensorflow model using the attached configuration.
          *
@@ -10,11 +10,14 @@ import androidx.media.AudioAttributesCompat;
 import androidx.media.AudioFocusRequestCompat;
 import androidx.media.AudioManagerCompat;
 import com.google.android.exoplayer2.C;
+import com.google.android.exoplayer2.DefaultRenderersFactory;
 import com.google.android.exoplayer2.ExoPlaybackException;
 import com.google.android.exoplayer2.ExoPlayer;
 import com.google.android.exoplayer2.Player;
 import com.google.android.exoplayer2.SimpleExoPlayer;
 import com.google.android.exoplayer2.audio.AudioAttributes;
+import com.google.android.exoplayer2.audio.AudioProcessor;
+import com.google.android.exoplayer2.audio.TeeAudioProcessor;
 import com.google.android.exoplayer2.source.ConcatenatingMediaSource;
 import com.google.android.exoplayer2.source.MediaSource;
 import com.google.android.exoplayer2.source.ProgressiveMediaSource;
@@ -24,8 +27,11 @@ import com.google.android.exoplayer2.util.Util;
 import io.spokestack.spokestack.SpeechConfig;
 import io.spokestack.spokestack.SpeechOutput;
 import io.spokestack.spokestack.util.TaskHandler;
+import io.spokestack.spokestack.webrtc.EchoReference;
 import org.jetbrains.annotations.NotNull;
 
+import java.nio.ByteBuffer;
+
 /**
  * Audio player component for the TTS subsystem.
  *
@@ -354,6 +360,15 @@ public class SpokestackTTSOutput extends SpeechOutput
     /**
      * Simple class for producing media players configured with Spokestack's
      * preferred audio attributes and current context.
+     *
+     * <p>
+     * Players tee their decoded PCM output into an {@link EchoReference}
+     * broadcast, so that each
+     * {@link io.spokestack.spokestack.webrtc.AcousticEchoCanceller} in a
+     * speech pipeline can remove synthesized speech from the microphone
+     * signal. The broadcast discards this audio unless a canceller is
+     * active.
+     * </p>
      */
     static class PlayerFactory {
         ExoPlayer createPlayer(int usage, int contentType,
@@ -364,9 +379,49 @@ public class SpokestackTTSOutput extends SpeechOutput
                   .build();
 
             SimpleExoPlayer player =
-                  new SimpleExoPlayer.Builder(context).build();
+                  new SimpleExoPlayer.Builder(context,
+                        new EchoRenderersFactory(context)).build();
             player.setAudioAttributes(attributes, false);
             return player;
         }
     }
+
+    /**
+     * Renderers factory that inserts an echo reference tee at the end of
+     * the audio processing chain.
+     */
+    static class EchoRenderersFactory extends DefaultRenderersFactory {
+        EchoRenderersFactory(Context context) {
+            super(context);
+        }
+
+        @Override
+        protected AudioProcessor[] buildAudioProcessors() {
+            return new AudioProcessor[] {
+                  new TeeAudioProcessor(new EchoSink())
+            };
+        }
+    }
+
+    /**
+     * Audio sink that broadcasts 16-bit playback audio to the echo
+     * reference of every active echo canceller.
+     */
+    static class EchoSink implements TeeAudioProcessor.AudioBufferSink {
+        @Override
+        public void flush(int sampleRateHz, int channelCount, int encoding) {
+            // only 16-bit PCM can be used as a reference;
+            // other encodings are discarded by the reference
+            if (encoding == C.ENCODING_PCM_16BIT) {
+                EchoReference.broadcastFormat(sampleRateHz, channelCount);
+            } else {
+                EchoReference.broadcastFormat(sampleRateHz, 0);
+            }
+        }
+
+        @Override
+        public void handleBuffer(ByteBuffer buffer) {
+            EchoReference.broadcast(buffer);
+        }
+    }
 }
@@ -0,0 +1,34 @@
+package io.spokestack.spokestack.util;
+
+import java.io.IOException;
+import java.io.Writer;
+
+/**
+ * minimal JSON output helpers shared by the trace exporters.
+ */
+final class Json {
+    private Json() {
+    }
+
+    /**
+     * writes a string as a quoted, escaped JSON string.
+     * @param out   the writer to write to
+     * @param value the string to write
+     * @throws IOException on write failure
+     */
+    static void writeString(Writer out, String value) throws IOException {
+        out.write('"');
+        for (int i = 0; i < value.length(); i++) {
+            char c = value.charAt(i);
+            if (c == '"' || c == '\\') {
+                out.write('\\');
+                out.write(c);
+            } else if (c < ' ') {
+                out.write(String.format("\\u%04x", (int) c));
+            } else {
+                out.write(c);
+            }
+        }
+        out.write('"');
+    }
+}
@@ -0,0 +1,125 @@
+package io.spokestack.spokestack.util;
+
+import java.util.concurrent.atomic.AtomicLongArray;
+
+/**
+ * a lock-free histogram of latencies.
+ *
+ * <p>
+ * Latencies are recorded in microseconds into log-linear buckets, with
+ * 8 buckets per power of two, so that each recorded value is accurate to
+ * within 12.5% (values under 16us are exact). The histogram is written by a
+ * single thread, such as the speech pipeline thread, and can be read by
+ * any thread without blocking the writer. Percentiles are reported as the
+ * upper bound of the bucket containing them (or the maximum, for the last
+ * bucket, which is unbounded), and the maximum is exact.
+ * </p>
+ */
+public final class LatencyHistogram {
+    private static final int LINEAR = 16;
+    private static final int SUB_BITS = 3;
+    private static final int SUB_COUNT = 1 << SUB_BITS;
+    private static final int MAX_EXPONENT = 40;
+    private static final int BUCKETS =
+        LINEAR + (MAX_EXPONENT - 4 + 1) * SUB_COUNT;
+
+    private final AtomicLongArray counts = new AtomicLongArray(BUCKETS);
+    private volatile long count;
+    private volatile long max;
+
+    /**
+     * records a latency. called by the writer.
+     * @param nanos the latency, in nanoseconds
+     */
+    public void record(long nanos) {
+        int index = bucket(Math.max(nanos / 1000, 0));
+        this.counts.lazySet(index, this.counts.get(index) + 1);
+        if (nanos > this.max)
+            this.max = nanos;
+        this.count++;
+    }
+
+    /**
+     * @return the number of latencies recorded
+     */
+    public long getCount() {
+        return this.count;
+    }
+
+    /**
+     * @return the maximum latency recorded, in nanoseconds
+     */
+    public long getMax() {
+        return this.max;
+    }
+
+    /**
+     * returns a latency percentile.
+     * @param percentile the percentile to return, in the range [0, 100]
+     * @return the latency at the percentile, in nanoseconds, or 0 if no
+     * latencies have been recorded
+     */
+    public long getPercentile(double percentile) {
+        if (percentile < 0 || percentile > 100)
+            throw new IllegalArgumentException("percentile");
+
+        // sum the buckets, since the count may lag them
+        long total = 0;
+        for (int i = 0; i < BUCKETS; i++)
+            total += this.counts.get(i);
+        if (total == 0)
+            return 0;
+
+        long rank = Math.max((long) Math.ceil(total * percentile / 100), 1);
+        long seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += this.counts.get(i);
+            if (seen >= rank && i < BUCKETS - 1)
+                return Math.min(upper(i) * 1000, this.max);
+        }
+        return this.max;
+    }
+
+    /**
+     * clears all recorded latencies. called by the writer.
+     */
+    public void reset() {
+        for (int i = 0; i < BUCKETS; i++)
+            this.counts.lazySet(i, 0);
+        this.max = 0;
+        this.count = 0;
+    }
+
+    /**
+     * formats the histogram summary for tracing.
+     * @return the count, percentiles and maximum, in milliseconds
+     */
+    @Override
+    public String toString() {
+        return String.format(
+            "n %d p50 %.2fms p95 %.2fms p99 %.2fms max %.2fms",
+            getCount(),
+            getPercentile(50) / 1e6,
+            getPercentile(95) / 1e6,
+            getPercentile(99) / 1e6,
+            getMax() / 1e6);
+    }
+
+    private static int bucket(long micros) {
+        if (micros < LINEAR)
+            return (int) micros;
+        int exponent = Math.min(
+            63 - Long.numberOfLeadingZeros(micros),
+            MAX_EXPONENT);
+        int sub = (int) (micros >>> (exponent - SUB_BITS)) & (SUB_COUNT - 1);
+        return LINEAR + (exponent - 4) * SUB_COUNT + sub;
+    }
+
+    private static long upper(int bucket) {
+        if (bucket < LINEAR)
+            return bucket + 1;
+        int exponent = (bucket - LINEAR) / SUB_COUNT + 4;
+        int sub = (bucket - LINEAR) % SUB_COUNT;
+        return (long) (SUB_COUNT + sub + 1) << (exponent - SUB_BITS);
+    }
+}
@@ -0,0 +1,232 @@
+package io.spokestack.spokestack.util;
+
+import java.io.IOException;
+import java.io.StringWriter;
+import java.io.Writer;
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import java.util.Locale;
+
+/**
+ * a timeline of the work done to start a speech pipeline.
+ *
+ * <p>
+ * The pipeline creates a timeline each time it starts, and records spans
+ * for the construction of its input and stages, and for the time taken to
+ * process its first frame. While the components are constructed, the
+ * timeline is attached to the constructing thread, so that components can
+ * record the blocking work inside their constructors (such as loading
+ * models, parsing metadata, or creating native instances) via
+ * {@link #record(String, long)}, without depending on the pipeline. Spans
+ * recorded by a component are named within the scope of the component
+ * being constructed (for example, {@code WakewordTrigger/model filter}).
+ * Recording is a no-op when no timeline is attached, such as when a
+ * component is constructed outside of a pipeline.
+ * </p>
+ *
+ * <p>
+ * Spans may be recorded by any thread, including background model loading
+ * threads, which capture the attached timeline when they are started. Span
+ * times are offsets from the creation of the timeline, taken from the same
+ * clock as {@link System#nanoTime()}. The timeline can be exported as JSON
+ * for tracking cold-start regressions.
+ * </p>
+ */
+public final class StartupTimeline {
+    private static final ThreadLocal<StartupTimeline> CURRENT =
+        new ThreadLocal<>();
+
+    private final long origin;
+    private final List<Span> spans = new ArrayList<>();
+    private String scope = "";
+
+    /**
+     * constructs a new timeline, starting now.
+     */
+    public StartupTimeline() {
+        this.origin = System.nanoTime();
+    }
+
+    /**
+     * @return the timeline attached to the calling thread, or null if none
+     */
+    public static StartupTimeline current() {
+        return CURRENT.get();
+    }
+
+    /**
+     * attaches the timeline to the calling thread, in order to receive
+     * spans recorded via {@link #record(String, long)}.
+     */
+    public void attach() {
+        CURRENT.set(this);
+    }
+
+    /**
+     * detaches any timeline from the calling thread.
+     */
+    public static void detach() {
+        CURRENT.remove();
+    }
+
+    /**
+     * sets the scope of subsequently recorded span names, such as the name
+     * of the component being constructed. called by the attached thread.
+     * @param value the scope name, or the empty string for no scope
+     */
+    public void setScope(String value) {
+        this.scope = value;
+    }
+
+    /**
+     * qualifies a span name with the current scope. called by the attached
+     * thread.
+     * @param name the span name
+     * @return the scoped span name
+     */
+    public String qualify(String name) {
+        return this.scope.isEmpty() ? name : this.scope + "/" + name;
+    }
+
+    /**
+     * records a span ending now into the timeline attached to the calling
+     * thread, if any.
+     * @param name  the span name, which is qualified by the current scope
+     * @param start the start of the span, from {@link System#nanoTime()}
+     */
+    public static void record(String name, long start) {
+        StartupTimeline timeline = CURRENT.get();
+        if (timeline != null)
+            timeline.add(timeline.qualify(name), start, System.nanoTime());
+    }
+
+    /**
+     * adds a span to the timeline.
+     * @param name  the span name
+     * @param start the start of the span, from {@link System#nanoTime()}
+     * @param end   the end of the span, from {@link System#nanoTime()}
+     */
+    public void add(String name, long start, long end) {
+        Span span = new Span(name, start - this.origin, end - start);
+        synchronized (this.spans) {
+            this.spans.add(span);
+        }
+    }
+
+    /**
+     * @return the time at which the timeline started, from
+     * {@link System#nanoTime()}
+     */
+    public long getOrigin() {
+        return this.origin;
+    }
+
+    /**
+     * @return the spans recorded so far, in the order they ended
+     */
+    public List<Span> getSpans() {
+        synchronized (this.spans) {
+            return Collections.unmodifiableList(new ArrayList<>(this.spans));
+        }
+    }
+
+    /**
+     * finds a span by name.
+     * @param name the (scoped) span name
+     * @return the first span recorded with the name, or null if none
+     */
+    public Span find(String name) {
+        for (Span span : getSpans()) {
+            if (span.getName().equals(name))
+                return span;
+        }
+        return null;
+    }
+
+    /**
+     * exports the timeline as a JSON object, with a {@code spans} array of
+     * objects containing each span's {@code name}, and its {@code start}
+     * and {@code duration} in milliseconds.
+     * @param out the writer to receive the report
+     * @throws IOException on write error
+     */
+    public void export(Writer out) throws IOException {
+        List<Span> report = getSpans();
+        out.write("{\"spans\":[");
+        for (int i = 0; i < report.size(); i++) {
+            Span span = report.get(i);
+            if (i > 0)
+                out.write(",");
+            out.write("\n{\"name\":");
+            Json.writeString(out, span.getName());
+            out.write(String.format(
+                Locale.ROOT,
+                ",\"start\":%.3f,\"duration\":%.3f}",
+                span.getStart() / 1e6,
+                span.getDuration() / 1e6));
+        }
+        out.write("\n]}\n");
+    }
+
+    /**
+     * @return the timeline, exported as JSON
+     */
+    @Override
+    public String toString() {
+        StringWriter out = new StringWriter();
+        try {
+            export(out);
+        } catch (IOException e) {
+            throw new IllegalStateException(e);
+        }
+        return out.toString();
+    }
+
+    /**
+     * a named span of startup work.
+     */
+    public static final class Span {
+        private final String name;
+        private final long start;
+        private final long duration;
+
+        Span(String spanName, long spanStart, long spanDuration) {
+            this.name = spanName;
+            this.start = spanStart;
+            this.duration = spanDuration;
+        }
+
+        /**
+         * @return the span name
+         */
+        public String getName() {
+            return this.name;
+        }
+
+        /**
+         * @return the start of the span, relative to the start of the
+         * timeline, in nanoseconds
+         */
+        public long getStart() {
+            return this.start;
+        }
+
+        /**
+         * @return the duration of the span, in nanoseconds
+         */
+        public long getDuration() {
+            return this.duration;
+        }
+
+        @Override
+        public String toString() {
+            return String.format(
+                Locale.ROOT,
+                "%s at %.1fms took %.1fms",
+                this.name,
+                this.start / 1e6,
+                this.duration / 1e6);
+        }
+    }
+}
@@ -0,0 +1,389 @@
+package io.spokestack.spokestack.util;
+
+import java.io.IOException;
+import java.io.Writer;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.ArrayList;
+import java.util.HashMap;
+import java.util.IllegalFormatException;
+import java.util.List;
+import java.util.Locale;
+import java.util.Map;
+
+/**
+ * a process-wide binary trace ring.
+ *
+ * <p>
+ * Unlike trace messages raised through the speech context, which are
+ * formatted when they are raised, the trace ring records structured events
+ * (a monotonic timestamp, an event id, and up to four numeric arguments)
+ * into a preallocated native ring, so that tracing on hot paths neither
+ * allocates nor formats. Events are formatted only when the ring is drained,
+ * which is done off the hot path, and can be exported to the Chrome trace
+ * event format for viewing in Perfetto or {@code chrome://tracing}.
+ * </p>
+ *
+ * <p>
+ * Java and native code record into the same ring. Event types are
+ * registered by name, along with a message format applied to their
+ * arguments (as doubles), and optionally the names of their arguments,
+ * which causes them to be exported as counters. Java events are registered
+ * via {@link #register(String, String, String...)}, and native events via
+ * {@code Trace_Register()} (see trace.h). Recording is a no-op until the
+ * ring has been enabled, which also loads the native library, so
+ * components can register their events unconditionally.
+ * </p>
+ *
+ * <p>
+ * Any number of threads may record into the ring without blocking. When the
+ * ring overflows, the oldest records are overwritten and counted by
+ * {@link #getLost()}. Draining is synchronized. Timestamps are taken from the
+ * same clock as {@link System#nanoTime()}.
+ * </p>
+ */
+public final class TraceRing {
+    /**
+     * default ring capacity, in records.
+     */
+    public static final int DEFAULT_CAPACITY = 8192;
+
+    // first native event id (see TRACE_NATIVE_BASE in trace.h)
+    private static final int NATIVE_BASE = 0x10000;
+    // drained entry layout (see TraceEntry in trace.h)
+    private static final int ENTRY_SIZE = 48;
+    private static final int ENTRY_ID = 8;
+    private static final int ENTRY_ARGS = 16;
+    private static final int MAX_ARGS = 4;
+    private static final int DRAIN_BATCH = 256;
+
+    private static final List<Descriptor> EVENTS = new ArrayList<>();
+    private static final Map<Integer, Descriptor> NATIVE_EVENTS =
+        new HashMap<>();
+    private static volatile boolean enabled;
+    private static ByteBuffer drainBuffer;
+
+    private TraceRing() {
+    }
+
+    /**
+     * enables recording, allocating the ring on the first call. the ring is
+     * never released, and its capacity is fixed by the first call.
+     * @param capacity the minimum ring capacity, in records, which is
+     *                 rounded up to a power of two
+     * @return the ring capacity
+     */
+    public static synchronized int enable(int capacity) {
+        if (capacity < 1)
+            throw new IllegalArgumentException("capacity");
+        if (!enabled)
+            System.loadLibrary("spokestack-android");
+
+        int allocated = allocate(capacity);
+        if (allocated < 0)
+            throw new OutOfMemoryError();
+        if (drainBuffer == null)
+            drainBuffer = ByteBuffer
+                .allocateDirect(ENTRY_SIZE * DRAIN_BATCH)
+                .order(ByteOrder.nativeOrder());
+        enabled = true;
+        return allocated;
+    }
+
+    /**
+     * @return true if events are being recorded, false otherwise
+     */
+    public static boolean isEnabled() {
+        return enabled;
+    }
+
+    /**
+     * registers a java event type. registering a name that has already
+     * been registered returns its existing id.
+     * @param name     the unique event name
+     * @param format   the message format, applied to the event's arguments
+     *                 (as doubles) when it is drained
+     * @param argNames the names of the event's arguments, if the event
+     *                 should be exported as a counter
+     * @return the event id
+     */
+    public static synchronized int register(
+            String name,
+            String format,
+            String... argNames) {
+        for (int i = 0; i < EVENTS.size(); i++) {
+            if (EVENTS.get(i).name.equals(name))
+                return i;
+        }
+        if (EVENTS.size() >= NATIVE_BASE)
+            throw new IllegalStateException("too many trace events");
+        if (argNames.length > MAX_ARGS)
+            throw new IllegalArgumentException("argNames");
+        EVENTS.add(new Descriptor(name, format, argNames));
+        return EVENTS.size() - 1;
+    }
+
+    /**
+     * records an event with no arguments.
+     * @param id the registered event id
+     */
+    public static void record(int id) {
+        if (enabled)
+            append(id, 0, 0, 0, 0);
+    }
+
+    /**
+     * records an event with one argument.
+     * @param id the registered event id
+     * @param a0 the first argument
+     */
+    public static void record(int id, double a0) {
+        if (enabled)
+            append(id, a0, 0, 0, 0);
+    }
+
+    /**
+     * records an event with two arguments.
+     * @param id the registered event id
+     * @param a0 the first argument
+     * @param a1 the second argument
+     */
+    public static void record(int id, double a0, double a1) {
+        if (enabled)
+            append(id, a0, a1, 0, 0);
+    }
+
+    /**
+     * records an event with three arguments.
+     * @param id the registered event id
+     * @param a0 the first argument
+     * @param a1 the second argument
+     * @param a2 the third argument
+     */
+    public static void record(int id, double a0, double a1, double a2) {
+        if (enabled)
+            append(id, a0, a1, a2, 0);
+    }
+
+    /**
+     * records an event with four arguments.
+     * @param id the registered event id
+     * @param a0 the first argument
+     * @param a1 the second argument
+     * @param a2 the third argument
+     * @param a3 the fourth argument
+     */
+    public static void record(
+            int id,
+            double a0,
+            double a1,
+            double a2,
+            double a3) {
+        if (enabled)
+            append(id, a0, a1, a2, a3);
+    }
+
+    /**
+     * @return the number of records overwritten before they were drained
+     */
+    public static long getLost() {
+        return enabled ? lost() : 0;
+    }
+
+    /**
+     * removes all recorded events from the ring.
+     * @return the drained events, oldest first
+     */
+    public static synchronized List<Entry> drain() {
+        List<Entry> entries = new ArrayList<>();
+        if (!enabled)
+            return entries;
+
+        int count;
+        do {
+            count = drain(drainBuffer, DRAIN_BATCH);
+            for (int i = 0; i < count; i++) {
+                int offset = i * ENTRY_SIZE;
+                double[] args = new double[MAX_ARGS];
+                for (int j = 0; j < MAX_ARGS; j++)
+                    args[j] = drainBuffer.getDouble(
+                        offset + ENTRY_ARGS + j * Double.BYTES);
+                int id = drainBuffer.getInt(offset + ENTRY_ID);
+                entries.add(new Entry(
+                    drainBuffer.getLong(offset),
+                    id,
+                    describe(id),
+                    args));
+            }
+        } while (count == DRAIN_BATCH);
+        return entries;
+    }
+
+    /**
+     * exports drained events in the Chrome trace event (JSON) format, which
+     * can be loaded by Perfetto. events with named arguments are exported
+     * as counters, and other events as instants with their messages.
+     * @param entries the drained events to export
+     * @param out     the writer to receive the trace
+     * @throws IOException on write error
+     */
+    public static void export(List<Entry> entries, Writer out)
+            throws IOException {
+        out.write("{\"traceEvents\":[");
+        for (int i = 0; i < entries.size(); i++) {
+            Entry entry = entries.get(i);
+            String[] argNames = entry.descriptor.argNames;
+            if (i > 0)
+                out.write(",");
+            out.write("\n{\"name\":");
+            Json.writeString(out, entry.getName());
+            out.write(argNames.length > 0
+                ? ",\"ph\":\"C\""
+                : ",\"ph\":\"i\",\"s\":\"g\"");
+            out.write(String.format(
+                Locale.ROOT,
+                ",\"ts\":%.3f,\"pid\":1,\"tid\":1,\"args\":{",
+                entry.getTime() / 1e3));
+            if (argNames.length > 0) {
+                for (int j = 0; j < argNames.length; j++) {
+                    if (j > 0)
+                        out.write(",");
+                    Json.writeString(out, argNames[j]);
+                    out.write(":");
+                    double value = entry.getArg(j);
+                    out.write(Double.isNaN(value) || Double.isInfinite(value)
+                        ? "null"
+                        : Double.toString(value));
+                }
+            } else {
+                out.write("\"message\":");
+                Json.writeString(out, entry.getMessage());
+            }
+            out.write("}}");
+        }
+        out.write("\n]}\n");
+    }
+
+    private static Descriptor describe(int id) {
+        if (id >= 0 && id < NATIVE_BASE) {
+            synchronized (TraceRing.class) {
+                return id < EVENTS.size() ? EVENTS.get(id) : null;
+            }
+        }
+        Descriptor descriptor = NATIVE_EVENTS.get(id);
+        if (descriptor == null) {
+            String name = describe(id, 0);
+            if (name == null)
+                return null;
+            String args = describe(id, 2);
+            descriptor = new Descriptor(
+                name,
+                describe(id, 1),
+                args.isEmpty() ? new String[0] : args.split(","));
+            NATIVE_EVENTS.put(id, descriptor);
+        }
+        return descriptor;
+    }
+
+    /**
+     * a registered event type.
+     */
+    private static final class Descriptor {
+        private final String name;
+        private final String format;
+        private final String[] argNames;
+
+        Descriptor(String eventName, String messageFormat, String[] args) {
+            this.name = eventName;
+            this.format = messageFormat;
+            this.argNames = args;
+        }
+    }
+
+    /**
+     * a drained trace event.
+     */
+    public static final class Entry {
+        private static final Descriptor UNKNOWN =
+            new Descriptor("unknown", "unknown", new String[0]);
+
+        private final long time;
+        private final int id;
+        private final Descriptor descriptor;
+        private final double[] args;
+
+        Entry(long timestamp, int eventId, Descriptor type, double[] values) {
+            this.time = timestamp;
+            this.id = eventId;
+            this.descriptor = type != null ? type : UNKNOWN;
+            this.args = values;
+        }
+
+        /**
+         * @return the time the event was recorded, in nanoseconds, on the
+         * {@link System#nanoTime()} clock
+         */
+        public long getTime() {
+            return this.time;
+        }
+
+        /**
+         * @return the event id
+         */
+        public int getId() {
+            return this.id;
+        }
+
+        /**
+         * @return the event name
+         */
+        public String getName() {
+            return this.descriptor.name;
+        }
+
+        /**
+         * returns an event argument.
+         * @param index the argument index, in the range [0, 4)
+         * @return the argument value
+         */
+        public double getArg(int index) {
+            return this.args[index];
+        }
+
+        /**
+         * @return the event message, formatted from its arguments
+         */
+        public String getMessage() {
+            Object[] params = new Object[MAX_ARGS];
+            for (int i = 0; i < MAX_ARGS; i++)
+                params[i] = this.args[i];
+            try {
+                return String.format(this.descriptor.format, params);
+            } catch (IllegalFormatException e) {
+                return this.descriptor.format;
+            }
+        }
+
+        /**
+         * @return the event message
+         */
+        @Override
+        public String toString() {
+            return getMessage();
+        }
+    }
+
+    //-----------------------------------------------------------------------
+    // native interface
+    //-----------------------------------------------------------------------
+    static native int allocate(int capacity);
+    static native void append(
+        int id,
+        double a0,
+        double a1,
+        double a2,
+        double a3);
+    static native int drain(ByteBuffer buffer, int count);
+    static native long lost();
+    static native String describe(int id, int part);
+}
@@ -4,10 +4,16 @@ import io.spokestack.spokestack.RingBuffer;
 import io.spokestack.spokestack.SpeechConfig;
 import io.spokestack.spokestack.SpeechContext;
 import io.spokestack.spokestack.SpeechProcessor;
+import io.spokestack.spokestack.tensorflow.ModelGroup;
+import io.spokestack.spokestack.tensorflow.ModelOptions;
+import io.spokestack.spokestack.tensorflow.TensorFormat;
 import io.spokestack.spokestack.tensorflow.TensorflowModel;
+import io.spokestack.spokestack.util.TraceRing;
 import org.jtransforms.fft.FloatFFT_1D;
 
 import java.nio.ByteBuffer;
+import java.util.Set;
+import java.util.concurrent.atomic.AtomicReference;
 
 
 /**
@@ -83,8 +89,9 @@ import java.nio.ByteBuffer;
  *      <b>wake-encode-path</b> (string, required): file system path to the
  *      "encode" Tensorflow-Lite model, which is used to perform each
  *      autoregressive step over the mel frames; its inputs should be shaped
- *      [mel-length, mel-width], and its outputs [encode-width], with an
- *      additional state input/output shaped [state-width]
+ *      [mel-length, mel-width], and its outputs [encode-width], with
+ *      additional state inputs/outputs (see {@code wake-encode-states}), the
+ *      first shaped [state-width]
  *   </li>
  *   <li>
  *      <b>wake-detect-path</b> (string, required): file system path to the
@@ -141,11 +148,42 @@ import java.nio.ByteBuffer;
  *      in vector units (defaults to wake-encode-width)
  *   </li>
  *   <li>
+ *      <b>wake-encode-states</b> (string): the positions of the encoder's
+ *      state tensors, as a comma-separated list of {@code input:output}
+ *      pairs (or single positions shared by the input and output), for
+ *      encoders with several recurrent layers or streaming caches; defaults
+ *      to {@code 1}
+ *   </li>
+ *   <li>
  *      <b>wake-threshold</b> (double): the threshold of the classifier's
  *      posterior output, above which the trigger activates the pipeline,
  *      in the range [0, 1]
  *   </li>
+ *   <li>
+ *      <b>model-loading</b> (string): {@code serial} (default) to load the
+ *      models in the constructor, or {@code parallel} to load them on
+ *      background threads, in which case frames are ignored until all of
+ *      the models have loaded
+ *   </li>
+ *   <li>
+ *      <b>wake-threads</b>, <b>wake-xnnpack</b>, <b>wake-fp16</b>,
+ *      <b>wake-cancellable</b>: TensorFlow Lite interpreter options for the
+ *      models, as described in {@link ModelOptions}
+ *   </li>
  * </ul>
+ *
+ * <p>
+ * The models can be replaced while the pipeline is running, by calling
+ * {@link #swapModels(SpeechConfig)} with a configuration containing the
+ * new model paths (and interpreter options). The new models are loaded on
+ * the calling thread (or in the background, for parallel model loading),
+ * and are swapped in by the pipeline thread between frames, once they
+ * have all loaded. The new models must have the same input, output, and
+ * state sizes as the models they replace; otherwise, or if they fail to
+ * load, an error event is raised and the current models are kept. If the
+ * current models themselves failed to load, any new models that load
+ * replace them, re-enabling the trigger.
+ * </p>
  */
 public final class WakewordTrigger implements SpeechProcessor {
     /** the hann fft-window-type.  */
@@ -174,6 +212,10 @@ public final class WakewordTrigger implements SpeechProcessor {
     /** default wake-threshold value. */
     public static final float DEFAULT_WAKE_THRESHOLD = 0.5f;
 
+    // per-frame posterior trace ring event
+    private static final int TRACE_POSTERIOR =
+        TraceRing.register("wake", "wake: %.3f", "posterior");
+
     // voice activity detection
     private boolean isSpeech;
 
@@ -203,9 +245,16 @@ public final class WakewordTrigger implements SpeechProcessor {
     private final RingBuffer encodeWindow;
 
     // tensorflow mel filtering and classifier models
-    private final TensorflowModel filterModel;
-    private final TensorflowModel encodeModel;
-    private final TensorflowModel detectModel;
+    private final TensorflowModel.Loader loader;
+    private final AtomicReference<ModelGroup> pendingModels =
+        new AtomicReference<>();
+    private ModelGroup models;
+    private TensorflowModel filterModel;
+    private TensorflowModel encodeModel;
+    private TensorflowModel detectModel;
+    private boolean loadTraced;
+    private boolean loadFailed;
+    private volatile boolean closed;
 
     // wakeword activation management
     private final float posteriorThreshold;
@@ -282,33 +331,113 @@ public final class WakewordTrigger implements SpeechProcessor {
         this.frameWindow.fill(0);
         this.encodeWindow.fill(-1);
 
-        // load the tensorflow-lite models
-        this.filterModel = loader
-            .setPath(config.getString("wake-filter-path"))
-            .load();
-        loader.reset();
-        this.encodeModel = loader
-            .setPath(config.getString("wake-encode-path"))
-            .setStatePosition(1)
-            .load();
-        loader.reset();
-        this.detectModel = loader
-            .setPath(config.getString("wake-detect-path"))
-            .load();
+        // load the tensorflow-lite models, in the background if configured
+        this.loader = loader;
+        this.models = loadModels(config);
+        if (this.models.isReady())
+            attachModels(this.models);
 
         // configure the wakeword activation lengths
         this.posteriorThreshold = (float) config
             .getDouble("wake-threshold", (double) DEFAULT_WAKE_THRESHOLD);
     }
 
+    private ModelGroup loadModels(SpeechConfig config) {
+        ModelOptions options = new ModelOptions(config, "wake");
+        ModelGroup group = new ModelGroup(config);
+        try {
+            group.add(
+                "filter",
+                this.loader
+                    .setOptions(options)
+                    .setPath(config.getString("wake-filter-path")));
+            group.add(
+                "encode",
+                this.loader
+                    .setOptions(options)
+                    .setPath(config.getString("wake-encode-path"))
+                    .addStatePairs(
+                        config.getString("wake-encode-states", "1")));
+            group.add(
+                "detect",
+                this.loader
+                    .setOptions(options)
+                    .setPath(config.getString("wake-detect-path")));
+        } catch (RuntimeException e) {
+            // release any models loaded before the failure
+            this.loader.reset();
+            group.close();
+            throw e;
+        }
+        return group;
+    }
+
     /**
      * releases resources associated with the wakeword detector.
      * @throws Exception on error
      */
-    public void close() throws Exception {
-        this.filterModel.close();
-        this.encodeModel.close();
-        this.detectModel.close();
+    public synchronized void close() throws Exception {
+        // synchronized with swaps, so that none can land after the pending
+        // models are released
+        this.closed = true;
+        ModelGroup pending = this.pendingModels.getAndSet(null);
+        if (pending != null)
+            pending.close();
+        this.models.close();
+    }
+
+    /**
+     * loads a new set of wakeword models, to be swapped in by the pipeline
+     * thread at the next frame boundary after they have loaded. a pending
+     * swap that has not yet been applied is discarded.
+     * @param config the configuration containing the new model paths
+     * @return true if the configuration contains wakeword model paths,
+     * false otherwise
+     * @throws IllegalStateException if the trigger has been closed
+     */
+    @Override
+    public boolean swapModels(SpeechConfig config) {
+        if (!config.containsKey("wake-filter-path")
+                && !config.containsKey("wake-encode-path")
+                && !config.containsKey("wake-detect-path"))
+            return false;
+        if (this.closed)
+            throw new IllegalStateException("closed");
+
+        // load outside the monitor, so that the pipeline thread is never
+        // blocked by a load while it attaches a previous swap
+        ModelGroup loaded;
+        synchronized (this.loader) {
+            loaded = loadModels(config);
+        }
+        ModelGroup replaced;
+        synchronized (this) {
+            if (this.closed) {
+                loaded.close();
+                throw new IllegalStateException("closed");
+            }
+            replaced = this.pendingModels.getAndSet(loaded);
+        }
+        if (replaced != null)
+            replaced.close();
+        return true;
+    }
+
+    @Override
+    public void cancelSwap() {
+        ModelGroup pending = this.pendingModels.getAndSet(null);
+        if (pending != null)
+            pending.close();
+    }
+
+    /**
+     * the trigger only detects wakewords while the pipeline is inactive,
+     * and only needs to see the frame that activates it.
+     * @return the inactive states
+     */
+    @Override
+    public Set<State> getStates() {
+        return INACTIVE_STATES;
     }
 
     @Override
@@ -323,9 +452,9 @@ public final class WakewordTrigger implements SpeechProcessor {
         this.frameWindow.reset().fill(0);
         this.encodeWindow.reset().fill(-1);
 
-        // reset the encoder states
-        while (this.encodeModel.states().hasRemaining())
-            this.encodeModel.states().putFloat(0);
+        // reset the encoder states, once the encoder has loaded
+        if (this.encodeModel != null)
+            this.encodeModel.resetStates();
 
         // reset the maximum posterior
         this.posteriorMax = 0;
@@ -339,6 +468,39 @@ public final class WakewordTrigger implements SpeechProcessor {
      */
     public void process(SpeechContext context, ByteBuffer buffer)
             throws Exception {
+        // wait for the models to load, reporting a failure to load only
+        // once, after which the stage remains disabled until a swap
+        if (this.detectModel == null && !this.loadFailed) {
+            if (!this.models.isReady())
+                return;
+            try {
+                attachModels(this.models);
+            } catch (IllegalStateException e) {
+                this.loadFailed = true;
+                context.setError(e);
+                context.dispatch(SpeechContext.Event.ERROR);
+                return;
+            }
+        }
+
+        // swap in newly loaded models between frames, which also
+        // recovers a stage whose models failed to load
+        ModelGroup pending = this.pendingModels.get();
+        if (pending != null && pending.isReady())
+            attachPending(context, pending);
+        if (this.detectModel == null)
+            return;
+
+        if (!this.loadTraced) {
+            for (int i = 0; i < this.models.size(); i++) {
+                context.tracePerf(
+                    "wake: loaded %s model in %.1fms",
+                    this.models.getName(i),
+                    this.models.getLoadTime(i) / 1e6);
+            }
+            this.loadTraced = true;
+        }
+
         // detect speech deactivation edges for wakeword deactivation
         boolean vadFall = this.isSpeech && !context.isSpeech();
         boolean deactivate = this.isActive && !context.isActive();
@@ -359,6 +521,46 @@ public final class WakewordTrigger implements SpeechProcessor {
         }
     }
 
+    private void attachModels(ModelGroup group) {
+        // fetch every model before attaching any, so that a model that
+        // failed to load leaves the stage detached rather than half-attached
+        TensorflowModel filter = group.get(0);
+        TensorflowModel encode = group.get(1);
+        TensorflowModel detect = group.get(2);
+        this.filterModel = filter;
+        this.encodeModel = encode;
+        this.detectModel = detect;
+    }
+
+    private synchronized void attachPending(SpeechContext context,
+                                            ModelGroup pending) {
+        // claim the pending models, unless they were replaced, cancelled,
+        // or released by close since they were checked
+        if (this.closed || !this.pendingModels.compareAndSet(pending, null))
+            return;
+        try {
+            pending.checkCompatible(this.models);
+        } catch (IllegalStateException e) {
+            pending.close();
+            context.setError(e);
+            context.dispatch(SpeechContext.Event.ERROR);
+            return;
+        }
+
+        ModelGroup previous = this.models;
+        this.models = pending;
+        attachModels(pending);
+        previous.close();
+        this.loadTraced = false;
+        this.loadFailed = false;
+
+        // the buffered features came from the previous models,
+        // so start the new ones from a clean slate
+        this.frameWindow.reset().fill(0);
+        this.encodeWindow.reset().fill(-1);
+        this.encodeModel.resetStates();
+    }
+
     private void sample(SpeechContext context, ByteBuffer buffer) {
         // update the rms normalization factors
         // maintain an ewma of the rms signal energy for speech samples
@@ -411,24 +613,29 @@ public final class WakewordTrigger implements SpeechProcessor {
         // . the first and last stft components contain only real parts
         //   and are stored in the first two positions of the stft output
         // . the remaining components contain real/imaginary parts
-        this.filterModel.inputs(0).rewind();
-        this.filterModel.inputs(0).putFloat(this.fftFrame[0]);
+        // . values are encoded in the model's input format, which may be
+        //   quantized
+        TensorFormat inputFormat = this.filterModel.inputFormat(0);
+        ByteBuffer input = this.filterModel.inputs(0);
+        input.rewind();
+        inputFormat.put(input, this.fftFrame[0]);
         for (int i = 1; i < this.fftFrame.length / 2; i++) {
             float re = this.fftFrame[i * 2 + 0];
             float im = this.fftFrame[i * 2 + 1];
             float ab = (float) Math.sqrt(re * re + im * im);
-            this.filterModel.inputs(0).putFloat(ab);
+            inputFormat.put(input, ab);
         }
-        this.filterModel.inputs(0).putFloat(this.fftFrame[1]);
+        inputFormat.put(input, this.fftFrame[1]);
 
         // execute the mel filterbank tensorflow model
         this.filterModel.run();
 
         // copy the current mel frame into the mel window
+        TensorFormat outputFormat = this.filterModel.outputFormat(0);
+        ByteBuffer output = this.filterModel.outputs(0);
         this.frameWindow.rewind().seek(this.melWidth);
-        while (this.filterModel.outputs(0).hasRemaining()) {
-            this.frameWindow.write(
-                  this.filterModel.outputs(0).getFloat());
+        while (output.hasRemaining()) {
+            this.frameWindow.write(outputFormat.get(output));
         }
 
         encode(context);
@@ -436,20 +643,23 @@ public final class WakewordTrigger implements SpeechProcessor {
 
     private void encode(SpeechContext context) {
         // transfer the mel filterbank window to the encoder model's inputs
+        TensorFormat inputFormat = this.encodeModel.inputFormat(0);
+        ByteBuffer input = this.encodeModel.inputs(0);
         this.frameWindow.rewind();
-        this.encodeModel.inputs(0).rewind();
+        input.rewind();
         while (!this.frameWindow.isEmpty()) {
-            this.encodeModel.inputs(0).putFloat(this.frameWindow.read());
+            inputFormat.put(input, this.frameWindow.read());
         }
 
         // run the encoder tensorflow model
         this.encodeModel.run();
 
         // copy the encoder output into the encode window
+        TensorFormat outputFormat = this.encodeModel.outputFormat(0);
+        ByteBuffer output = this.encodeModel.outputs(0);
         this.encodeWindow.rewind().seek(this.encodeWidth);
-        while (this.encodeModel.outputs(0).hasRemaining()) {
-            this.encodeWindow.write(
-                  this.encodeModel.outputs(0).getFloat());
+        while (output.hasRemaining()) {
+            this.encodeWindow.write(outputFormat.get(output));
         }
 
         detect(context);
@@ -457,16 +667,20 @@ public final class WakewordTrigger implements SpeechProcessor {
 
     private void detect(SpeechContext context) {
         // transfer the encoder window to the detector model's inputs
+        TensorFormat inputFormat = this.detectModel.inputFormat(0);
+        ByteBuffer input = this.detectModel.inputs(0);
         this.encodeWindow.rewind();
-        this.detectModel.inputs(0).rewind();
+        input.rewind();
         while (!this.encodeWindow.isEmpty())
-            this.detectModel.inputs(0).putFloat(this.encodeWindow.read());
+            inputFormat.put(input, this.encodeWindow.read());
 
         // run the classifier tensorflow model
         this.detectModel.run();
 
         // check the classifier's output and activate
-        float posterior = this.detectModel.outputs(0).getFloat();
+        float posterior = this.detectModel.outputFormat(0)
+            .get(this.detectModel.outputs(0));
+        TraceRing.record(TRACE_POSTERIOR, posterior);
         if (posterior > this.posteriorMax)
             this.posteriorMax = posterior;
         if (posterior > this.posteriorThreshold)
@@ -479,7 +693,7 @@ public final class WakewordTrigger implements SpeechProcessor {
     }
 
     private void trace(SpeechContext context) {
-        context.traceInfo(String.format("wake: %f", this.posteriorMax));
+        context.traceInfo("wake: %f", this.posteriorMax);
     }
 
     private float[] hannWindow(int len) {
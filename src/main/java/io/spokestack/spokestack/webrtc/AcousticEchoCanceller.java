@@ -0,0 +1,190 @@
+package io.spokestack.spokestack.webrtc;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+import io.spokestack.spokestack.SpeechConfig;
+import io.spokestack.spokestack.SpeechProcessor;
+import io.spokestack.spokestack.SpeechContext;
+import io.spokestack.spokestack.util.StartupTimeline;
+
+/**
+ * Acoustic Echo Canceller (AEC) pipeline component
+ *
+ * <p>
+ * AcousticEchoCanceller is a speech pipeline component that removes the
+ * echo of audio played back by the device (such as TTS prompts) from the
+ * microphone signal, so that wakeword detection and speech recognition can
+ * remain active during playback. The cancelled frames are written back to
+ * the frame buffer in-place. The canceller implementation is based on the
+ * webrtc echo canceller in the Chromium browser. It supports 16-bit PCM
+ * samples with a frame rate multiple of 10ms.
+ * </p>
+ *
+ * <p>
+ * The far-end (playback) reference signal is read from the canceller's own
+ * {@link EchoReference} tap, which receives the process-wide playback
+ * broadcast fed by {@link io.spokestack.spokestack.tts.SpokestackTTSOutput}.
+ * Applications that play audio through other means may broadcast it
+ * directly. This stage should precede all other stages in the pipeline.
+ * </p>
+ *
+ * <p>
+ * This pipeline component supports the following configuration properties:
+ * </p>
+ * <ul>
+ *   <li>
+ *      <b>sample-rate</b> (int): audio sample rate, in Hz
+ *      (supports 8000/16000/32000/48000Hz)
+ *   </li>
+ *   <li>
+ *      <b>frame-width</b> (int): audio frame width, in ms
+ *      (supports 10/20/30ms)
+ *   </li>
+ *   <li>
+ *     <b>aec-policy</b> (string): residual echo suppression policy, one of
+ *     the following:
+ *     <ul>
+ *       <li><b>conservative</b>: least residual suppression</li>
+ *       <li><b>moderate</b>: moderate residual suppression</li>
+ *       <li><b>aggressive</b>: most residual suppression</li>
+ *     </ul>
+ *   </li>
+ *   <li>
+ *     <b>aec-delay</b> (int): estimated delay between the far-end reference
+ *     being written and its echo reaching the microphone, in ms
+ *   </li>
+ * </ul>
+ */
+public class AcousticEchoCanceller implements SpeechProcessor {
+    private static final int POLICY_CONSERVATIVE = 0;
+    private static final int POLICY_MODERATE = 1;
+    private static final int POLICY_AGGRESSIVE = 2;
+
+    /** default canceller policy. */
+    public static final String DEFAULT_POLICY = "moderate";
+    /** default far-end reference delay, in ms. */
+    public static final int DEFAULT_DELAY = 100;
+
+    // native aec structure handle
+    private final long aecHandle;
+    private final int frameWidth;
+    private final EchoReference reference;
+    private final ByteBuffer farFrame;
+
+    /**
+     * constructs a new canceller instance.
+     * @param config the pipeline configuration instance
+     */
+    public AcousticEchoCanceller(SpeechConfig config) {
+        this(config, EchoReference.tap());
+    }
+
+    /**
+     * constructs a new canceller instance, for testing.
+     * @param config    the pipeline configuration instance
+     * @param reference the far-end reference ring to consume
+     */
+    public AcousticEchoCanceller(
+            SpeechConfig config,
+            EchoReference reference) {
+        // decode and validate the sample rate
+        int rate = config.getInteger("sample-rate");
+        switch (rate) {
+            case 8000: break;
+            case 16000: break;
+            case 32000: break;
+            case 48000: break;
+            default: throw new IllegalArgumentException("sample-rate");
+        }
+
+        // decode and validate the frame width
+        // this must be a multiple 10ms of audio,
+        // which is the only frame size supported by the canceller
+        this.frameWidth = rate * 10 / 1000;
+        int frameMs = config.getInteger("frame-width");
+        if (frameMs % 10 != 0)
+            throw new IllegalArgumentException("frame-width");
+
+        // decode and validate the policy
+        String policyString = config.getString("aec-policy", DEFAULT_POLICY);
+        int policy;
+        if (policyString.equals("conservative"))
+            policy = POLICY_CONSERVATIVE;
+        else if (policyString.equals("moderate"))
+            policy = POLICY_MODERATE;
+        else if (policyString.equals("aggressive"))
+            policy = POLICY_AGGRESSIVE;
+        else
+            throw new IllegalArgumentException("policy");
+
+        int delay = config.getInteger("aec-delay", DEFAULT_DELAY);
+        if (delay < 0)
+            throw new IllegalArgumentException("aec-delay");
+
+        // allocate the far-end frame, matching the pipeline frame size
+        this.farFrame = ByteBuffer
+            .allocateDirect(rate * frameMs / 1000 * 2)
+            .order(ByteOrder.nativeOrder());
+
+        // create the native canceller context
+        long start = System.nanoTime();
+        this.aecHandle = create(rate, policy, delay);
+        if (this.aecHandle == 0)
+            throw new OutOfMemoryError();
+        StartupTimeline.record("native create", start);
+
+        // start consuming the reference signal
+        this.reference = reference;
+        this.reference.configure(rate);
+    }
+
+    @Override
+    public void reset() {
+    }
+
+    /**
+     * destroys the unmanaged aec instance.
+     */
+    @Override
+    public void close() {
+        this.reference.release();
+        destroy(this.aecHandle);
+    }
+
+    /**
+     * processes a frame of audio.
+     * @param context the current speech context
+     * @param frame   the audio frame to cancel
+     */
+    public void process(SpeechContext context, ByteBuffer frame) {
+        // compute the frame size, in bytes
+        int frameSize = this.frameWidth * 2;
+        if (frame.capacity() % frameSize != 0
+                || frame.capacity() != this.farFrame.capacity())
+            throw new IllegalStateException();
+
+        // fetch the far-end reference for the frame
+        this.farFrame.clear();
+        this.reference.read(this.farFrame);
+
+        // run the native canceller for each canceller frame,
+        // which will update the frame buffer
+        for (int offset = 0; offset < frame.capacity(); offset += frameSize) {
+            int result = process(this.aecHandle, frame, this.farFrame, offset);
+            if (result < 0)
+                throw new IllegalStateException();
+        }
+    }
+
+    //-----------------------------------------------------------------------
+    // native interface
+    //-----------------------------------------------------------------------
+    static {
+        System.loadLibrary("spokestack-android");
+    }
+
+    native long create(int rate, int policy, int delay);
+    native void destroy(long aec);
+    native int process(long aec, ByteBuffer near, ByteBuffer far, int offset);
+}
@@ -5,6 +5,7 @@ import java.nio.ByteBuffer;
 import io.spokestack.spokestack.SpeechConfig;
 import io.spokestack.spokestack.SpeechProcessor;
 import io.spokestack.spokestack.SpeechContext;
+import io.spokestack.spokestack.util.StartupTimeline;
 
 /**
  * Acoustic Noise Suppressor (ANS) pipeline component
@@ -18,6 +19,21 @@ import io.spokestack.spokestack.SpeechContext;
  * </p>
  *
  * <p>
+ * At 32kHz and 48kHz, each frame is split natively into 0-8kHz and 8-16kHz
+ * bands that are suppressed jointly and then merged back into the full-band
+ * frame. 48kHz frames are resampled to 32kHz for band splitting, so content
+ * above 16kHz is discarded.
+ * </p>
+ *
+ * <p>
+ * The adaptive policy tracks the noise floor and speech level of the input
+ * natively. As noise rises, suppression is engaged within about a second
+ * and stepped up one policy at a time; as it falls, suppression is relaxed
+ * more slowly, until the suppressor is bypassed. Transitions into and out
+ * of bypass are crossfaded. Policy changes are traced at the debug level.
+ * </p>
+ *
+ * <p>
  * This pipeline component supports the following configuration properties:
  * </p>
  * <ul>
@@ -37,6 +53,18 @@ import io.spokestack.spokestack.SpeechContext;
  *       <li><b>aggressive</b>: aggressive supression (15dB)</li>
  *       <li><b>very-aggressive</b>:
  *           very aggressive supression (undocumented)</li>
+ *       <li><b>adaptive</b>: the least aggressive of the above policies
+ *           suited to the current signal-to-noise ratio, bypassing
+ *           suppression entirely in quiet environments</li>
+ *     </ul>
+ *   </li>
+ *   <li>
+ *     <b>ans-backend</b> (string): suppressor implementation, one of the
+ *     following:
+ *     <ul>
+ *       <li><b>fixed</b>: fixed-point suppressor</li>
+ *       <li><b>float</b>: floating-point suppressor, which is usually
+ *           higher quality and may be faster on 64-bit devices</li>
  *     </ul>
  *   </li>
  * </ul>
@@ -46,13 +74,22 @@ public class AcousticNoiseSuppressor implements SpeechProcessor {
     private static final int POLICY_MEDIUM = 1;
     private static final int POLICY_AGGRESSIVE = 2;
     private static final int POLICY_VERY_AGGRESSIVE = 3;
+    private static final int POLICY_BYPASS = -1;
+    private static final int POLICY_ADAPTIVE = -2;
+
+    private static final int BACKEND_FIXED = 0;
+    private static final int BACKEND_FLOAT = 1;
 
     /** default suppressor policy. */
     public static final String DEFAULT_POLICY = "mild";
+    /** default suppressor implementation. */
+    public static final String DEFAULT_BACKEND = "fixed";
 
     // native ans structure handle
     private final long ansHandle;
     private final int frameWidth;
+    private final boolean adaptive;
+    private int activePolicy;
 
     /**
      * constructs a new suppressor instance.
@@ -65,6 +102,7 @@ public class AcousticNoiseSuppressor implements SpeechProcessor {
             case 8000: break;
             case 16000: break;
             case 32000: break;
+            case 48000: break;
             default: throw new IllegalArgumentException("sample-rate");
         }
 
@@ -86,13 +124,58 @@ public class AcousticNoiseSuppressor implements SpeechProcessor {
             policy = POLICY_AGGRESSIVE;
         else if (policyString.equals("very-aggressive"))
             policy = POLICY_VERY_AGGRESSIVE;
+        else if (policyString.equals("adaptive"))
+            policy = POLICY_ADAPTIVE;
         else
             throw new IllegalArgumentException("policy");
+        this.adaptive = policy == POLICY_ADAPTIVE;
+
+        // decode and validate the backend
+        String backendString = config.getString("ans-backend", DEFAULT_BACKEND);
+        int backend;
+        if (backendString.equals("fixed"))
+            backend = BACKEND_FIXED;
+        else if (backendString.equals("float"))
+            backend = BACKEND_FLOAT;
+        else
+            throw new IllegalArgumentException("backend");
 
         // create the native suppressor context
-        this.ansHandle = create(rate, policy);
+        long start = System.nanoTime();
+        this.ansHandle = create(rate, policy, backend);
         if (this.ansHandle == 0)
             throw new OutOfMemoryError();
+        StartupTimeline.record("native create", start);
+        this.activePolicy = policy(this.ansHandle);
+    }
+
+    /**
+     * @return the active suppressor policy (0..3, in order of
+     * aggressiveness), or -1 if suppression is bypassed
+     */
+    public int getPolicy() {
+        return policy(this.ansHandle);
+    }
+
+    /**
+     * @return true if the adaptive policy has bypassed suppression
+     */
+    public boolean isBypassed() {
+        return getPolicy() == POLICY_BYPASS;
+    }
+
+    /**
+     * @return the estimated signal-to-noise ratio of the input, in dB
+     */
+    public float getSnr() {
+        return snr(this.ansHandle);
+    }
+
+    /**
+     * @return the estimated noise floor of the input, in dBFS
+     */
+    public float getNoiseLevel() {
+        return noise(this.ansHandle);
     }
 
     @Override
@@ -125,6 +208,19 @@ public class AcousticNoiseSuppressor implements SpeechProcessor {
             if (result < 0)
                 throw new IllegalStateException();
         }
+
+        // report adaptive policy changes, since fixed policies never change
+        if (!this.adaptive)
+            return;
+        int current = policy(this.ansHandle);
+        if (current != this.activePolicy) {
+            this.activePolicy = current;
+            context.traceDebug(
+                "ans: policy %d snr %.1fdB noise %.1fdBFS",
+                current,
+                snr(this.ansHandle),
+                noise(this.ansHandle));
+        }
     }
 
     //-----------------------------------------------------------------------
@@ -134,7 +230,10 @@ public class AcousticNoiseSuppressor implements SpeechProcessor {
         System.loadLibrary("spokestack-android");
     }
 
-    native long create(int rate, int policy);
+    native long create(int rate, int policy, int backend);
     native void destroy(long ans);
     native int process(long ans, ByteBuffer buffer, int offset);
+    native int policy(long ans);
+    native float snr(long ans);
+    native float noise(long ans);
 }
@@ -6,6 +6,7 @@ import io.spokestack.spokestack.SpeechConfig;
 import io.spokestack.spokestack.SpeechProcessor;
 import io.spokestack.spokestack.SpeechContext;
 import io.spokestack.spokestack.util.EventTracer;
+import io.spokestack.spokestack.util.StartupTimeline;
 
 /**
  * Automatic Gain Control (AGC) pipeline component
@@ -37,21 +38,65 @@ import io.spokestack.spokestack.util.EventTracer;
  *     <b>agc-compression-gain-db</b> (int): dynamic range compression rate,
  *     in dB
  *   </li>
+ *   <li>
+ *     <b>agc-mode</b> (string): gain control mode, one of the following:
+ *     <ul>
+ *       <li><b>adaptive-digital</b>: adapts the gain to the input level
+ *           (default)</li>
+ *       <li><b>fixed-digital</b>: applies the fixed compression gain,
+ *           for input that is already level-controlled</li>
+ *     </ul>
+ *   </li>
+ *   <li>
+ *     <b>agc-limiter</b> (boolean): true to enable the controller's peak
+ *     limiter, which prevents clipping at the cost of some distortion
+ *     (default false)
+ *   </li>
+ *   <li>
+ *     <b>agc-telemetry</b> (boolean): true to measure the controller's
+ *     levels for every frame, for the component's accessors
+ *     (default false)
+ *   </li>
  * </ul>
  *
+ * <p>
+ * The native controller reports the gain it applied, the resulting RMS
+ * level in dBFS, and whether it detected saturation for each frame. These
+ * levels cost two scans of the frame, so they are only measured when
+ * {@code agc-telemetry} is enabled, for the component's accessors, or
+ * while the pipeline traces at the perf level. Otherwise, the accessors
+ * report 0. Note that the {@code agc:} perf trace reports the level in
+ * dBFS; earlier versions traced it in dB relative to 2e-5.
+ * </p>
+ *
  */
 public class AutomaticGainControl implements SpeechProcessor {
     /** default target peak amplitude, in dBFS. */
     public static final int DEFAULT_TARGET_LEVEL_DBFS = 3;
     /** default compression gain, in dB. */
     public static final int DEFAULT_COMPRESSION_GAIN_DB = 15;
+    /** default gain control mode. */
+    public static final String DEFAULT_MODE = "adaptive-digital";
+
+    private static final int MODE_ADAPTIVE_DIGITAL = 2;
+    private static final int MODE_FIXED_DIGITAL = 3;
+
+    private static final int LEVEL_GAIN = 0;
+    private static final int LEVEL_RMS = 1;
+    private static final int LEVEL_SATURATED = 2;
 
     // native agc structure handle
     private final long agcHandle;
 
+    // per-frame controller telemetry, filled by the native controller
+    private final float[] levels = new float[LEVEL_SATURATED + 1];
+    private final boolean telemetry;
+
     // controller output levels and counters, for tracing
     private final int maxCounter;
     private double level;
+    private double gain;
+    private int saturations;
     private int counter;
 
     /**
@@ -88,14 +133,46 @@ public class AutomaticGainControl implements SpeechProcessor {
             "agc-compression-gain-db",
             DEFAULT_COMPRESSION_GAIN_DB);
 
+        // decode and validate the mode
+        String modeString = config.getString("agc-mode", DEFAULT_MODE);
+        int mode;
+        if (modeString.equals("adaptive-digital"))
+            mode = MODE_ADAPTIVE_DIGITAL;
+        else if (modeString.equals("fixed-digital"))
+            mode = MODE_FIXED_DIGITAL;
+        else
+            throw new IllegalArgumentException("agc-mode");
+
+        // decode and validate the limiter flag
+        String limiterString = config.getString("agc-limiter", "false");
+        boolean limiterEnable;
+        if (limiterString.equals("true"))
+            limiterEnable = true;
+        else if (limiterString.equals("false"))
+            limiterEnable = false;
+        else
+            throw new IllegalArgumentException("agc-limiter");
+
+        // decode and validate the telemetry flag
+        String telemetryString = config.getString("agc-telemetry", "false");
+        if (telemetryString.equals("true"))
+            this.telemetry = true;
+        else if (telemetryString.equals("false"))
+            this.telemetry = false;
+        else
+            throw new IllegalArgumentException("agc-telemetry");
+
         // create the native agc context
+        long start = System.nanoTime();
         this.agcHandle = create(
             rate,
+            mode,
             targetLeveldBFS,
             compressionGaindB,
-            false);
+            limiterEnable);
         if (this.agcHandle == 0)
             throw new OutOfMemoryError();
+        StartupTimeline.record("native create", start);
     }
 
     /**
@@ -109,45 +186,66 @@ public class AutomaticGainControl implements SpeechProcessor {
     public void reset() {
     }
 
+    /**
+     * @return the gain applied to the most recent frame, in dB
+     */
+    public float getGain() {
+        return this.levels[LEVEL_GAIN];
+    }
+
+    /**
+     * @return the RMS level of the most recent frame after gain control,
+     * in dBFS
+     */
+    public float getLevel() {
+        return this.levels[LEVEL_RMS];
+    }
+
+    /**
+     * @return true if the controller detected saturation in the most
+     * recent frame
+     */
+    public boolean isSaturated() {
+        return this.levels[LEVEL_SATURATED] != 0;
+    }
+
     /**
      * processes a frame of audio.
      * @param context the current speech context
      * @param frame   the audio frame to detect
      */
     public void process(SpeechContext context, ByteBuffer frame) {
-        // run the native gain controller,
-        // which will update the frame buffer
-        int result = process(this.agcHandle, frame, frame.capacity());
+        // run the native gain controller, which will update the frame
+        // buffer, and the levels if they are needed
+        boolean tracing = context.canTrace(EventTracer.Level.PERF);
+        int result = process(
+            this.agcHandle,
+            frame,
+            frame.capacity(),
+            this.telemetry || tracing ? this.levels : null);
         if (result < 0)
             throw new IllegalStateException();
 
         // trace the amplification levels
-        if (context.canTrace(EventTracer.Level.PERF)) {
-            // measure the updated sample RMS dBFS
+        if (tracing) {
             // maintain a running mean of the levels
-            double frameLevel = rms(frame);
             this.counter++;
-            this.level += (frameLevel - this.level) / this.counter;
+            this.level += (getLevel() - this.level) / this.counter;
+            this.gain += (getGain() - this.gain) / this.counter;
+            if (isSaturated())
+                this.saturations++;
 
             // trace them once per tracing interval
             this.counter %= this.maxCounter;
-            if (this.counter == 0)
-                context.tracePerf("agc: %.4f", this.level);
-        }
-    }
-
-    private double rms(ByteBuffer signal) {
-        double sum = 0;
-        int count = 0;
-
-        signal.rewind();
-        while (signal.hasRemaining()) {
-            double sample = (double) signal.getShort() / Short.MAX_VALUE;
-            sum += sample * sample;
-            count++;
+            if (this.counter == 0) {
+                context.tracePerf(
+                    "agc: level %.2fdBFS gain %.2fdB saturated %d",
+                    this.level,
+                    this.gain,
+                    this.saturations);
+                this.saturations = 0;
+            }
         }
-
-        return 20 * Math.log10(Math.max(Math.sqrt(sum / count), 2e-5) / 2e-5);
     }
 
     //-----------------------------------------------------------------------
@@ -159,9 +257,14 @@ public class AutomaticGainControl implements SpeechProcessor {
 
     native long create(
         int rate,
+        int mode,
         int targetLeveldBFS,
         int compressionGaindB,
         boolean limiterEnable);
     native void destroy(long agc);
-    native int process(long agc, ByteBuffer buffer, int length);
+    native int process(
+        long agc,
+        ByteBuffer buffer,
+        int length,
+        float[] levels);
 }
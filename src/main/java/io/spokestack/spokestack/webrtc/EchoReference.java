@@ -0,0 +1,265 @@
+package io.spokestack.spokestack.webrtc;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.List;
+import java.util.concurrent.CopyOnWriteArrayList;
+
+/**
+ * far-end (playback) reference for acoustic echo cancellation
+ *
+ * <p>
+ * EchoReference is a lock-free single-producer/single-consumer ring of
+ * 16-bit mono samples that carries audio being played back to the
+ * {@link AcousticEchoCanceller} stage. The producer is the audio playback
+ * path (see {@link io.spokestack.spokestack.tts.SpokestackTTSOutput}),
+ * which writes PCM at its own sample rate and channel count; samples are
+ * downmixed to mono and linearly resampled to the pipeline's sample rate
+ * as they are written. The consumer is the echo canceller, which reads one
+ * pipeline frame of reference audio per processed frame, zero-filling
+ * whenever playback is idle.
+ * </p>
+ *
+ * <p>
+ * Playback and capture components constructed independently are connected
+ * by a process-wide broadcast. Each echo canceller consumes its own ring,
+ * created by {@link #tap()}, and audio broadcast by the playback path is
+ * written to every configured tap, so that any number of pipelines can
+ * cancel the same playback. A ring is inactive (and writes are discarded)
+ * until its echo canceller configures it, and only one consumer may read
+ * a ring at a time.
+ * </p>
+ */
+public final class EchoReference {
+    // configured taps, written by the broadcast producer
+    private static final List<EchoReference> TAPS =
+        new CopyOnWriteArrayList<>();
+
+    // broadcast playback format, owned by the producer
+    private static int broadcastRate;
+    private static int broadcastChannels;
+
+    // ring capacity, in samples (one second at the maximum sample rate)
+    // the ring is never reallocated, so that reconfiguration cannot
+    // invalidate positions held by the producer
+    private static final int CAPACITY = 48000 + 1;
+
+    // whether the ring receives broadcast playback audio
+    private final boolean tapped;
+
+    // consumer-owned state
+    private volatile short[] ring;
+    private volatile int rate;
+    private volatile int readPos;
+    private volatile long underruns;
+
+    // producer-owned state
+    private volatile int writePos;
+    private volatile long overruns;
+    private int sourceRate;
+    private int sourceChannels;
+    private float prevSample;
+    private double phase;
+    private boolean formatted;
+
+    /**
+     * constructs a new reference ring, for testing.
+     * the ring is inactive until {@link #configure(int)} is called.
+     */
+    public EchoReference() {
+        this(false);
+    }
+
+    private EchoReference(boolean isTap) {
+        this.tapped = isTap;
+    }
+
+    /**
+     * creates a reference ring that receives all broadcast playback audio
+     * once it is configured, until it is released.
+     * @return the new reference ring
+     */
+    public static EchoReference tap() {
+        return new EchoReference(true);
+    }
+
+    /**
+     * sets the format of subsequently broadcast playback audio.
+     * called by the playback path.
+     * @param sampleRate   playback sample rate, in Hz
+     * @param channelCount number of interleaved playback channels
+     */
+    public static void broadcastFormat(int sampleRate, int channelCount) {
+        broadcastRate = sampleRate;
+        broadcastChannels = channelCount;
+        for (EchoReference tap : TAPS)
+            tap.format(sampleRate, channelCount);
+    }
+
+    /**
+     * writes 16-bit interleaved playback audio to every configured tap.
+     * called by the playback path.
+     * @param pcm playback samples, in native byte order
+     */
+    public static void broadcast(ByteBuffer pcm) {
+        for (EchoReference tap : TAPS) {
+            // taps configured since the last format change
+            // are formatted by the producer on their first write
+            if (!tap.formatted)
+                tap.format(broadcastRate, broadcastChannels);
+            tap.write(pcm);
+        }
+    }
+
+    /**
+     * activates the ring for a pipeline sample rate, discarding any
+     * buffered reference audio. called by the consumer.
+     * @param sampleRate pipeline sample rate, in Hz
+     * @throws IllegalStateException if another consumer is reading the
+     * ring
+     */
+    public synchronized void configure(int sampleRate) {
+        if (this.rate != 0)
+            throw new IllegalStateException("reference in use");
+        if (this.ring == null)
+            this.ring = new short[CAPACITY];
+        this.readPos = this.writePos;
+        this.rate = sampleRate;
+        if (this.tapped)
+            TAPS.add(this);
+    }
+
+    /**
+     * deactivates the ring, discarding any subsequent writes.
+     * called by the consumer.
+     */
+    public synchronized void release() {
+        this.rate = 0;
+        if (this.tapped)
+            TAPS.remove(this);
+    }
+
+    /**
+     * @return true if an echo canceller is consuming the reference
+     */
+    public boolean isActive() {
+        return this.rate != 0;
+    }
+
+    /**
+     * @return the number of reference samples dropped because the ring
+     * was full
+     */
+    public long getOverruns() {
+        return this.overruns;
+    }
+
+    /**
+     * @return the number of frames that could only be partially filled
+     * with reference audio
+     */
+    public long getUnderruns() {
+        return this.underruns;
+    }
+
+    /**
+     * sets the format of subsequently written playback audio. audio with
+     * an unknown (non-positive) sample rate is discarded.
+     * called by the producer.
+     * @param sampleRate   playback sample rate, in Hz
+     * @param channelCount number of interleaved playback channels
+     */
+    public void format(int sampleRate, int channelCount) {
+        this.sourceRate = sampleRate;
+        this.sourceChannels = sampleRate > 0 ? channelCount : 0;
+        this.prevSample = 0;
+        this.phase = 0;
+        this.formatted = true;
+    }
+
+    /**
+     * writes 16-bit interleaved playback audio to the ring, from the
+     * buffer's position to its limit. the buffer is not modified.
+     * called by the producer.
+     * @param pcm playback samples, in native byte order
+     */
+    public void write(ByteBuffer pcm) {
+        int targetRate = this.rate;
+        short[] data = this.ring;
+        if (targetRate == 0 || data == null || this.sourceChannels <= 0)
+            return;
+
+        ByteBuffer samples = pcm.duplicate().order(ByteOrder.nativeOrder());
+        double step = (double) this.sourceRate / targetRate;
+        if (step <= 0)
+            return;
+        int frameSize = this.sourceChannels * 2;
+        int wpos = this.writePos;
+        int rpos = this.readPos;
+        for (int i = samples.position();
+             i + frameSize <= samples.limit();
+             i += frameSize) {
+            // downmix the playback frame
+            float sample = 0;
+            for (int c = 0; c < this.sourceChannels; c++)
+                sample += samples.getShort(i + c * 2);
+            sample /= this.sourceChannels;
+
+            // emit all target samples between the previous playback
+            // sample and this one, interpolating linearly
+            while (this.phase < 1) {
+                float value = this.prevSample
+                    + (float) this.phase * (sample - this.prevSample);
+                int next = (wpos + 1) % data.length;
+                if (next == rpos) {
+                    // refresh the consumer's position before dropping
+                    rpos = this.readPos;
+                    if (next == rpos) {
+                        this.overruns++;
+                        this.phase += step;
+                        continue;
+                    }
+                }
+                data[wpos] = (short) value;
+                wpos = next;
+                this.phase += step;
+            }
+            this.phase -= 1;
+            this.prevSample = sample;
+        }
+
+        // publish the written samples to the consumer
+        this.writePos = wpos;
+    }
+
+    /**
+     * reads reference audio into a frame, from its position to its limit,
+     * zero-filling any samples that have not yet been written.
+     * called by the consumer.
+     * @param frame frame buffer to fill, in native byte order
+     */
+    public void read(ByteBuffer frame) {
+        short[] data = this.ring;
+        int wpos = this.writePos;
+        int rpos = this.readPos;
+        boolean started = data != null && rpos != wpos;
+        boolean dry = false;
+        for (int i = frame.position(); i + 2 <= frame.limit(); i += 2) {
+            if (data != null && rpos != wpos) {
+                frame.putShort(i, data[rpos]);
+                rpos = (rpos + 1) % data.length;
+            } else {
+                frame.putShort(i, (short) 0);
+                dry = true;
+            }
+        }
+
+        // playback that ran dry mid-frame is an underrun,
+        // as opposed to playback that is simply idle
+        if (started && dry)
+            this.underruns++;
+
+        // release the consumed samples to the producer
+        this.readPos = rpos;
+    }
+}
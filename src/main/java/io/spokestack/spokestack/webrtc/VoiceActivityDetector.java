@@ -5,6 +5,8 @@ import java.nio.ByteBuffer;
 import io.spokestack.spokestack.SpeechConfig;
 import io.spokestack.spokestack.SpeechProcessor;
 import io.spokestack.spokestack.SpeechContext;
+import io.spokestack.spokestack.util.StartupTimeline;
+import io.spokestack.spokestack.util.TraceRing;
 
 /**
  * Voice Activity Detection (VAD) pipeline component
@@ -66,6 +68,10 @@ public class VoiceActivityDetector implements SpeechProcessor {
     private static final int MODE_AGGRESSIVE = 2;
     private static final int MODE_VERY_AGGRESSIVE = 3;
 
+    // speech edge trace ring event
+    private static final int TRACE_SPEECH =
+        TraceRing.register("vad", "vad: %.0f", "speech");
+
     private final int rate;
     private final long vadHandle;
     private final int riseLength;
@@ -117,9 +123,11 @@ public class VoiceActivityDetector implements SpeechProcessor {
               / frameWidth;
 
         // initialize the vad
+        long start = System.nanoTime();
         this.vadHandle = create(mode);
         if (this.vadHandle == 0)
             throw new OutOfMemoryError();
+        StartupTimeline.record("native create", start);
     }
 
     /**
@@ -158,10 +166,12 @@ public class VoiceActivityDetector implements SpeechProcessor {
             if (this.runValue && this.runLength >= this.riseLength) {
                 context.setSpeech(true);
                 context.traceInfo("vad: true");
+                TraceRing.record(TRACE_SPEECH, 1);
             }
             if (!this.runValue && this.runLength >= this.fallLength) {
                 context.setSpeech(false);
                 context.traceInfo("vad: false");
+                TraceRing.record(TRACE_SPEECH, 0);
             }
         }
     }
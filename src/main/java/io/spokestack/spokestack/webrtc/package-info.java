@@ -1,5 +1,6 @@
 /**
  * This package wraps the webrtc native modules for Voice Activity Detection
- * (VAD) and Automatic Gain Control (AGC).
+ * (VAD), Automatic Gain Control (AGC), Acoustic Noise Suppression (ANS), and
+ * Acoustic Echo Cancellation (AEC).
  */
 package io.spokestack.spokestack.webrtc;
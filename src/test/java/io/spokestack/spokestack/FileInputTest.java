@@ -0,0 +1,155 @@
+package io.spokestack.spokestack;
+
+import java.io.ByteArrayInputStream;
+import java.io.ByteArrayOutputStream;
+import java.io.EOFException;
+import java.io.InputStream;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class FileInputTest {
+    @Test
+    public void testRawPcm() throws Exception {
+        SpeechConfig config = new SpeechConfig().put("sample-rate", 16000);
+        FileInput input = new FileInput(config, pcm(0, 5));
+        ByteBuffer frame = frame(4);
+
+        // full frames
+        input.read(null, frame);
+        assertSamples(frame, 0, 1);
+        input.read(null, frame);
+        assertSamples(frame, 2, 3);
+
+        // the final frame is zero-padded
+        input.read(null, frame);
+        assertSamples(frame, 4, 0);
+
+        // subsequent reads end the stream
+        assertThrows(EOFException.class, new Executable() {
+            public void execute() throws Exception {
+                input.read(null, frame);
+            }
+        });
+        input.close();
+
+        // empty and very short streams are raw pcm
+        FileInput empty = new FileInput(config, pcm(0, 0));
+        assertThrows(EOFException.class, new Executable() {
+            public void execute() throws Exception {
+                empty.read(null, frame);
+            }
+        });
+        FileInput single = new FileInput(config, pcm(7, 1));
+        single.read(null, frame);
+        assertSamples(frame, 7, 0);
+    }
+
+    @Test
+    public void testWave() throws Exception {
+        SpeechConfig config = new SpeechConfig().put("sample-rate", 16000);
+
+        // invalid formats
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() throws Exception {
+                new FileInput(config, wave(3, 1, 16000, 16, 4));
+            }
+        });
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() throws Exception {
+                new FileInput(config, wave(1, 2, 16000, 16, 4));
+            }
+        });
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() throws Exception {
+                new FileInput(config, wave(1, 1, 8000, 16, 4));
+            }
+        });
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() throws Exception {
+                new FileInput(config, wave(1, 1, 16000, 8, 4));
+            }
+        });
+
+        // truncated header
+        assertThrows(EOFException.class, new Executable() {
+            public void execute() throws Exception {
+                byte[] header = new byte[20];
+                wave(1, 1, 16000, 16, 4).read(header);
+                new FileInput(config, new ByteArrayInputStream(header));
+            }
+        });
+
+        // valid file, with trailing chunks after the sample data
+        FileInput input = new FileInput(config, wave(1, 1, 16000, 16, 3));
+        ByteBuffer frame = frame(4);
+        input.read(null, frame);
+        assertSamples(frame, 0, 1);
+        input.read(null, frame);
+        assertSamples(frame, 2, 0);
+        assertThrows(EOFException.class, new Executable() {
+            public void execute() throws Exception {
+                input.read(null, frame);
+            }
+        });
+        input.close();
+    }
+
+    private static InputStream pcm(int first, int count) {
+        ByteBuffer data = ByteBuffer
+            .allocate(count * 2)
+            .order(ByteOrder.LITTLE_ENDIAN);
+        for (int i = 0; i < count; i++)
+            data.putShort((short) (first + i));
+        return new ByteArrayInputStream(data.array());
+    }
+
+    private static InputStream wave(
+            int format,
+            int channels,
+            int rate,
+            int bits,
+            int count) throws Exception {
+        ByteBuffer header = ByteBuffer
+            .allocate(64)
+            .order(ByteOrder.LITTLE_ENDIAN);
+        header.put("RIFF".getBytes("US-ASCII"));
+        header.putInt(0);
+        header.put("WAVE".getBytes("US-ASCII"));
+        // an unknown chunk with an odd size
+        header.put("LIST".getBytes("US-ASCII"));
+        header.putInt(1);
+        header.put((byte) 0).put((byte) 0);
+        header.put("fmt ".getBytes("US-ASCII"));
+        header.putInt(16);
+        header.putShort((short) format);
+        header.putShort((short) channels);
+        header.putInt(rate);
+        header.putInt(rate * channels * bits / 8);
+        header.putShort((short) (channels * bits / 8));
+        header.putShort((short) bits);
+        header.put("data".getBytes("US-ASCII"));
+        header.putInt(count * 2);
+
+        ByteArrayOutputStream stream = new ByteArrayOutputStream();
+        stream.write(header.array(), 0, header.position());
+        for (int i = 0; i < count; i++) {
+            stream.write(i & 0xFF);
+            stream.write(i >> 8);
+        }
+        stream.write("junk".getBytes("US-ASCII"));
+        return new ByteArrayInputStream(stream.toByteArray());
+    }
+
+    private static ByteBuffer frame(int size) {
+        return ByteBuffer.allocateDirect(size).order(ByteOrder.nativeOrder());
+    }
+
+    private static void assertSamples(ByteBuffer frame, int... expected) {
+        for (int i = 0; i < expected.length; i++)
+            assertEquals(expected[i], frame.getShort(i * 2));
+    }
+}
@@ -0,0 +1,85 @@
+package io.spokestack.spokestack;
+
+import java.nio.ByteBuffer;
+import java.util.*;
+
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class FrameBufferTest {
+    @Test
+    public void testConstruction() {
+        // invalid capacity
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { new FrameBuffer(0, 4); }
+        });
+
+        // valid buffer
+        FrameBuffer buffer = new FrameBuffer(3, 4);
+        assertEquals(3, buffer.size());
+        assertFalse(buffer.isEmpty());
+        for (ByteBuffer frame : buffer) {
+            assertEquals(4, frame.capacity());
+            assertTrue(frame.isDirect());
+        }
+    }
+
+    @Test
+    public void testRotation() {
+        FrameBuffer buffer = new FrameBuffer(3, 4);
+
+        // the rotated frame becomes the newest frame
+        for (int i = 1; i <= 5; i++) {
+            ByteBuffer frame = buffer.rotate();
+            assertEquals(0, frame.position());
+            frame.putInt(0, i);
+            assertSame(frame, buffer.getLast());
+        }
+        assertEquals(3, buffer.getFirst().getInt(0));
+        assertEquals(5, buffer.getLast().getInt(0));
+        assertEquals(3, buffer.peek().getInt(0));
+        assertEquals(5, buffer.peekLast().getInt(0));
+
+        // frames are iterated oldest to newest
+        List<Integer> values = new ArrayList<>();
+        for (ByteBuffer frame : buffer)
+            values.add(frame.getInt(0));
+        assertEquals(Arrays.asList(3, 4, 5), values);
+
+        // and newest to oldest
+        values.clear();
+        Iterator<ByteBuffer> it = buffer.descendingIterator();
+        while (it.hasNext())
+            values.add(it.next().getInt(0));
+        assertEquals(Arrays.asList(5, 4, 3), values);
+        assertThrows(NoSuchElementException.class, new Executable() {
+            public void execute() { it.next(); }
+        });
+
+        // no frames are allocated by rotation
+        Set<ByteBuffer> frames = Collections.newSetFromMap(
+            new IdentityHashMap<>());
+        for (int i = 0; i < 10; i++)
+            frames.add(buffer.rotate());
+        assertEquals(3, frames.size());
+    }
+
+    @Test
+    public void testUnsupported() {
+        final FrameBuffer buffer = new FrameBuffer(3, 4);
+        final ByteBuffer frame = ByteBuffer.allocateDirect(4);
+        assertThrows(UnsupportedOperationException.class, new Executable() {
+            public void execute() { buffer.addLast(frame); }
+        });
+        assertThrows(UnsupportedOperationException.class, new Executable() {
+            public void execute() { buffer.removeFirst(); }
+        });
+        assertThrows(UnsupportedOperationException.class, new Executable() {
+            public void execute() { buffer.add(frame); }
+        });
+        assertThrows(UnsupportedOperationException.class, new Executable() {
+            public void execute() { buffer.poll(); }
+        });
+    }
+}
@@ -0,0 +1,104 @@
+package io.spokestack.spokestack;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class FrameRingTest {
+    @Test
+    public void testConstruction() {
+        FrameRing ring;
+
+        // unit ring
+        ring = new FrameRing(1, 4);
+        assertEquals(1, ring.capacity());
+        assertTrue(ring.isEmpty());
+        assertFalse(ring.isFull());
+
+        // valid ring
+        ring = new FrameRing(10, 4);
+        assertEquals(10, ring.capacity());
+        assertTrue(ring.isEmpty());
+        assertFalse(ring.isFull());
+        assertEquals(0, ring.getOverruns());
+        assertEquals(0, ring.getUnderruns());
+    }
+
+    @Test
+    public void testReadWrite() {
+        final FrameRing ring = new FrameRing(2, 4);
+        final ByteBuffer frame = frame();
+
+        // invalid read
+        assertThrows(IllegalStateException.class, new Executable() {
+            public void execute() { ring.read(frame); }
+        });
+
+        // fill the ring
+        ring.claim().putInt(0, 1);
+        ring.publish();
+        ring.claim().putInt(0, 2);
+        ring.publish();
+        assertTrue(ring.isFull());
+
+        // overrun
+        assertNull(ring.claim());
+        assertEquals(1, ring.getOverruns());
+
+        // frames are read in order, stamped with the overruns that
+        // preceded them
+        assertTrue(ring.await(0));
+        assertEquals(0, ring.read(frame));
+        assertEquals(1, frame.getInt(0));
+        assertEquals(0, ring.read(frame));
+        assertEquals(2, frame.getInt(0));
+        assertTrue(ring.isEmpty());
+        ring.claim().putInt(0, 4);
+        ring.publish();
+        assertEquals(1, ring.read(frame));
+
+        // underrun
+        assertFalse(ring.await(1));
+        assertEquals(1, ring.getUnderruns());
+
+        // clear
+        ring.claim().putInt(0, 3);
+        ring.publish();
+        ring.clear();
+        assertTrue(ring.isEmpty());
+    }
+
+    @Test
+    public void testThreading() throws Exception {
+        final FrameRing ring = new FrameRing(4, 4);
+        final int count = 1000;
+        Thread producer = new Thread(() -> {
+            for (int i = 0; i < count; ) {
+                ByteBuffer frame = ring.claim();
+                if (frame != null) {
+                    frame.putInt(0, i++);
+                    ring.publish();
+                } else {
+                    Thread.yield();
+                }
+            }
+        });
+        producer.start();
+
+        ByteBuffer frame = frame();
+        for (int i = 0; i < count; i++) {
+            assertTrue(ring.await(1000));
+            ring.read(frame);
+            assertEquals(i, frame.getInt(0));
+        }
+        producer.join();
+        assertTrue(ring.isEmpty());
+    }
+
+    private ByteBuffer frame() {
+        return ByteBuffer.allocateDirect(4).order(ByteOrder.nativeOrder());
+    }
+}
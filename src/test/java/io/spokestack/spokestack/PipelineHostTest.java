@@ -0,0 +1,236 @@
+package io.spokestack.spokestack;
+
+import java.nio.ByteBuffer;
+import java.util.*;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+
+import androidx.annotation.NonNull;
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class PipelineHostTest {
+    @Test
+    public void testConstruction() throws Exception {
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() {
+                new PipelineHost.Builder()
+                    .setProperty("host-workers", 0)
+                    .build();
+            }
+        });
+
+        // stage construction failures are surfaced by open
+        PipelineHost host = new PipelineHost.Builder()
+            .addStageClass("io.spokestack.spokestack.PipelineHostTest$Stage")
+            .addStageClass("invalid")
+            .build();
+        assertThrows(ClassNotFoundException.class, new Executable() {
+            public void execute() throws Exception { host.open(); }
+        });
+        assertEquals(0, host.getStreamCount());
+
+        // no streams can be opened once closed
+        host.close();
+        assertThrows(IllegalStateException.class, new Executable() {
+            public void execute() throws Exception { host.open(); }
+        });
+    }
+
+    @Test
+    public void testOrdering() throws Exception {
+        Stage.frames.clear();
+        PipelineHost host = new PipelineHost.Builder()
+            .addStageClass("io.spokestack.spokestack.PipelineHostTest$Stage")
+            .setProperty("host-workers", 4)
+            .build();
+
+        // open many streams
+        int streamCount = 32;
+        int frameCount = 100;
+        List<PipelineHost.Stream> streams = new ArrayList<>();
+        for (int i = 0; i < streamCount; i++)
+            streams.add(host.open());
+        assertEquals(streamCount, host.getStreamCount());
+
+        // invalid frames
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() throws Exception {
+                streams.get(0).write(ByteBuffer.allocateDirect(4));
+            }
+        });
+
+        // interleave frames across the streams
+        ByteBuffer frame = ByteBuffer.allocateDirect(640);
+        for (int f = 0; f < frameCount; f++) {
+            for (int s = 0; s < streamCount; s++) {
+                frame.putInt(0, s);
+                frame.putInt(4, f);
+                streams.get(s).write(frame);
+            }
+        }
+
+        // each stream's frames are processed in order and timestamped
+        host.close();
+        assertEquals(0, host.getStreamCount());
+        assertEquals(streamCount, Stage.frames.size());
+        for (int s = 0; s < streamCount; s++) {
+            List<Integer> frames = Stage.frames.get(s);
+            assertEquals(frameCount, frames.size());
+            for (int f = 0; f < frameCount; f++)
+                assertEquals(f, (int) frames.get(f));
+        }
+        assertEquals(0, Stage.misplaced);
+
+        // closed streams reject audio
+        assertFalse(streams.get(0).offer(frame));
+        assertThrows(IllegalStateException.class, new Executable() {
+            public void execute() throws Exception {
+                streams.get(0).write(frame);
+            }
+        });
+
+        // closing again has no effect
+        streams.get(0).close();
+        assertEquals(0, host.getStreamCount());
+    }
+
+    @Test
+    public void testBackpressure() throws Exception {
+        BlockingStage.latch = new CountDownLatch(1);
+        PipelineHost host = new PipelineHost.Builder()
+            .addStageClass(
+                "io.spokestack.spokestack.PipelineHostTest$BlockingStage")
+            .setProperty("host-workers", 1)
+            .setProperty("host-queue-width", 100)
+            .build();
+        Listener listener = new Listener();
+        PipelineHost.Stream stream = host.open(listener);
+
+        // the first frame blocks the stage, and the next 5 fill the queue
+        ByteBuffer frame = ByteBuffer.allocateDirect(640);
+        stream.write(frame);
+        assertTrue(BlockingStage.started.await(1, TimeUnit.SECONDS));
+        for (int i = 0; i < 5; i++)
+            assertTrue(stream.offer(frame));
+
+        // further frames are dropped
+        assertFalse(stream.offer(frame));
+        assertEquals(1, stream.getOverruns());
+
+        // blocking writes wait for the stage
+        Thread writer = new Thread(() -> {
+            try {
+                stream.write(frame);
+            } catch (InterruptedException e) {
+                // exit
+            }
+        });
+        writer.start();
+        writer.join(50);
+        assertTrue(writer.isAlive());
+
+        BlockingStage.latch.countDown();
+        writer.join(1000);
+        assertFalse(writer.isAlive());
+
+        // all queued frames are processed before the host closes
+        host.close();
+        assertEquals(7, BlockingStage.count);
+        assertTrue(listener.events.contains(SpeechContext.Event.ACTIVATE));
+
+        // frames after the dropped frame keep their timestamps
+        assertEquals(
+            Arrays.asList(0L, 320L, 640L, 960L, 1280L, 1600L, 2240L),
+            BlockingStage.positions);
+    }
+
+    @Test
+    public void testStageFailure() throws Exception {
+        PipelineHost host = new PipelineHost.Builder()
+            .addStageClass(
+                "io.spokestack.spokestack.SpeechPipelineTest$FailStage")
+            .build();
+        Listener listener = new Listener();
+        PipelineHost.Stream stream = host.open(listener);
+        stream.write(ByteBuffer.allocateDirect(640));
+        host.close();
+
+        // process and close errors
+        assertEquals(
+            Arrays.asList(SpeechContext.Event.ERROR, SpeechContext.Event.ERROR),
+            listener.events);
+    }
+
+    public static class Stage implements SpeechProcessor {
+        public static final Map<Integer, List<Integer>> frames =
+            new ConcurrentHashMap<>();
+        public static volatile int misplaced;
+        private Integer stream;
+
+        public Stage(SpeechConfig config) {
+        }
+
+        public void reset() {
+        }
+
+        public void close() {
+        }
+
+        public void process(SpeechContext context, ByteBuffer frame) {
+            // each stage instance belongs to a single stream
+            int id = frame.getInt(0);
+            if (this.stream == null)
+                this.stream = id;
+            if (this.stream != id)
+                misplaced++;
+
+            int index = frame.getInt(4);
+            if (context.getSamplePosition() != index * 320L)
+                misplaced++;
+            frames.computeIfAbsent(id, k -> new ArrayList<>()).add(index);
+        }
+    }
+
+    public static class BlockingStage implements SpeechProcessor {
+        public static CountDownLatch latch;
+        public static CountDownLatch started;
+        public static volatile int count;
+        public static final List<Long> positions =
+            Collections.synchronizedList(new ArrayList<>());
+
+        public BlockingStage(SpeechConfig config) {
+            started = new CountDownLatch(1);
+            count = 0;
+            positions.clear();
+        }
+
+        public void reset() {
+        }
+
+        public void close() {
+        }
+
+        public void process(SpeechContext context, ByteBuffer frame)
+                throws Exception {
+            started.countDown();
+            latch.await();
+            positions.add(context.getSamplePosition());
+            count++;
+            context.setActive(true);
+        }
+    }
+
+    private static class Listener implements OnSpeechEventListener {
+        private final List<SpeechContext.Event> events =
+            Collections.synchronizedList(new ArrayList<>());
+
+        @Override
+        public void onEvent(@NonNull SpeechContext.Event event,
+                            @NonNull SpeechContext context) {
+            this.events.add(event);
+        }
+    }
+}
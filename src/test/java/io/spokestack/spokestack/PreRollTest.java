@@ -0,0 +1,213 @@
+package io.spokestack.spokestack;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.*;
+
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class PreRollTest {
+    @Test
+    public void testConstruction() {
+        // invalid capacity
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { new PreRoll(0, 8, false); }
+        });
+
+        // invalid frame size
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { new PreRoll(16, 0, false); }
+        });
+
+        // valid pre-rolls
+        new PreRoll(16, 8, false).close();
+        new PreRoll(16, 8, true).close();
+    }
+
+    @Test
+    public void testWriteRead() {
+        PreRoll preRoll = new PreRoll(10, 8, false);
+        assertEquals(10, preRoll.capacity());
+        assertEquals(0, preRoll.getPosition());
+        assertEquals(0, preRoll.getStart());
+
+        // partial history
+        preRoll.write(sampleFrame(0));
+        assertEquals(4, preRoll.getPosition());
+        assertEquals(0, preRoll.getFrameStart());
+        assertEquals(0, preRoll.getStart());
+
+        ByteBuffer frame = frame(8);
+        assertEquals(4, preRoll.read(0, frame));
+        assertEquals(8, frame.limit());
+        assertSamples(frame, 0, 1, 2, 3);
+
+        assertEquals(4, preRoll.read(2, frame));
+        assertEquals(4, frame.limit());
+        assertSamples(frame, 2, 3);
+
+        // nothing to read at the current position
+        assertEquals(4, preRoll.read(4, frame));
+        assertEquals(0, frame.limit());
+
+        // overwrite the oldest samples
+        preRoll.write(sampleFrame(4));
+        preRoll.write(sampleFrame(8));
+        assertEquals(12, preRoll.getPosition());
+        assertEquals(8, preRoll.getFrameStart());
+        assertEquals(2, preRoll.getStart());
+
+        // reads of overwritten samples start at the oldest sample
+        assertEquals(6, preRoll.read(0, frame));
+        assertSamples(frame, 2, 3, 4, 5);
+        assertEquals(10, preRoll.read(6, frame));
+        assertSamples(frame, 6, 7, 8, 9);
+
+        preRoll.close();
+    }
+
+    @Test
+    public void testReplay() {
+        PreRoll preRoll = new PreRoll(10, 8, false);
+        for (int i = 0; i < 4; i++)
+            preRoll.write(sampleFrame(i * 4));
+
+        // replay is clamped to the history and ends at the current position
+        List<Short> samples = new ArrayList<>();
+        for (ByteBuffer chunk : preRoll.replay(0)) {
+            while (chunk.hasRemaining())
+                samples.add(chunk.getShort());
+        }
+        List<Short> expected = new ArrayList<>();
+        for (int i = 6; i < 16; i++)
+            expected.add((short) i);
+        assertEquals(expected, samples);
+
+        // replay from the most recent frame
+        samples.clear();
+        for (ByteBuffer chunk : preRoll.replay(preRoll.getFrameStart())) {
+            while (chunk.hasRemaining())
+                samples.add(chunk.getShort());
+        }
+        assertEquals(expected.subList(6, 10), samples);
+
+        // replay from the current position
+        Iterator<ByteBuffer> it = preRoll.replay(16).iterator();
+        assertFalse(it.hasNext());
+        assertThrows(NoSuchElementException.class, new Executable() {
+            public void execute() { it.next(); }
+        });
+
+        preRoll.close();
+    }
+
+    @Test
+    public void testCompression() {
+        PreRoll preRoll = new PreRoll(64, 128, true);
+        ByteBuffer input = frame(128);
+        for (int i = 0; i < 64; i++)
+            input.putShort((short) (Math.sin(i / 4.0) * 20000));
+        preRoll.write(input);
+
+        // mu-law samples are within a few percent of the originals
+        ByteBuffer output = frame(128);
+        preRoll.read(0, output);
+        for (int i = 0; i < 64; i++) {
+            short expect = input.getShort(i * 2);
+            short actual = output.getShort(i * 2);
+            assertEquals(expect, actual, Math.abs(expect) * 0.06 + 8);
+        }
+
+        preRoll.close();
+    }
+
+    @Test
+    public void testContextReplay() {
+        SpeechContext context = new SpeechContext(new SpeechConfig());
+        FrameBuffer buffer = new FrameBuffer(1, 8);
+        PreRoll preRoll = new PreRoll(100, 8, false);
+        context.attachBuffer(buffer);
+
+        // without a pre-roll, the frame buffer is replayed
+        assertSame(buffer, context.getReplay());
+        context.attachPreRoll(preRoll);
+        assertSame(preRoll, context.getPreRoll());
+        assertEquals(-1, context.getSpeechOnset());
+
+        // without speech, the frame buffer is replayed
+        preRoll.write(sampleFrame(0));
+        preRoll.write(sampleFrame(4));
+        assertSame(buffer, context.getReplay());
+
+        // speech onset is captured on the first speech frame
+        context.setSpeech(true);
+        assertEquals(4, context.getSpeechOnset());
+        preRoll.write(sampleFrame(8));
+        context.setSpeech(true);
+        assertEquals(4, context.getSpeechOnset());
+
+        List<Short> samples = new ArrayList<>();
+        for (ByteBuffer chunk : context.getReplay()) {
+            while (chunk.hasRemaining())
+                samples.add(chunk.getShort());
+        }
+        assertEquals(
+            Arrays.asList(
+                (short) 4, (short) 5, (short) 6, (short) 7,
+                (short) 8, (short) 9, (short) 10, (short) 11),
+            samples);
+
+        // reset clears the onset
+        context.reset();
+        assertEquals(-1, context.getSpeechOnset());
+        assertSame(buffer, context.getReplay());
+
+        context.detachPreRoll();
+        assertNull(context.getPreRoll());
+        preRoll.close();
+    }
+
+    @Test
+    public void testPipeline() throws Exception {
+        SpeechPipeline pipeline = new SpeechPipeline.Builder()
+            .setInputClass(SampleInput.class.getName())
+            .setProperty("preroll-width", 1000)
+            .setProperty("preroll-compression", "invalid")
+            .build();
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() throws Exception { pipeline.start(); }
+        });
+        assertNull(pipeline.getContext().getPreRoll());
+    }
+
+    private static ByteBuffer frame(int size) {
+        return ByteBuffer.allocateDirect(size).order(ByteOrder.nativeOrder());
+    }
+
+    private static ByteBuffer sampleFrame(int first) {
+        ByteBuffer frame = frame(8);
+        for (int i = 0; i < 4; i++)
+            frame.putShort((short) (first + i));
+        frame.rewind();
+        return frame;
+    }
+
+    private static void assertSamples(ByteBuffer frame, int... expected) {
+        assertEquals(expected.length * 2, frame.remaining());
+        for (int sample : expected)
+            assertEquals(sample, frame.getShort());
+    }
+
+    public static class SampleInput implements SpeechInput {
+        public SampleInput(SpeechConfig config) {
+        }
+
+        public void close() {
+        }
+
+        public void read(SpeechContext context, ByteBuffer frame) {
+        }
+    }
+}
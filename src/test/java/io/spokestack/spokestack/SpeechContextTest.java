@@ -1,6 +1,7 @@
 package io.spokestack.spokestack;
 
 import java.util.*;
+import java.util.concurrent.Semaphore;
 import java.nio.ByteBuffer;
 
 import androidx.annotation.NonNull;
@@ -182,6 +183,78 @@ public class SpeechContextTest implements OnSpeechEventListener {
         context.reset();
     }
 
+    @Test
+    public void testAsyncDispatch() throws Exception {
+        assertThrows(IllegalArgumentException.class, () ->
+            new SpeechContext(new SpeechConfig()
+                .put("event-dispatch", "invalid")));
+        assertThrows(IllegalArgumentException.class, () ->
+            new SpeechContext(new SpeechConfig()
+                .put("event-dispatch", "async")
+                .put("event-queue-size", 0)));
+
+        SpeechConfig config = new SpeechConfig()
+            .put("event-dispatch", "async")
+            .put("event-queue-size", 4)
+            .put("trace-level", EventTracer.Level.DEBUG.value());
+        SpeechContext context = new SpeechContext(config);
+        assertEquals(0, context.getDroppedEvents());
+
+        // block the dispatcher on the first event
+        Semaphore gate = new Semaphore(0);
+        List<String> received = Collections.synchronizedList(
+            new ArrayList<>());
+        context.addOnSpeechEventListener((event, ctx) -> {
+            if (received.isEmpty())
+                gate.acquire();
+            if (event == Event.TRACE)
+                received.add("trace:" + ctx.getMessage());
+            else
+                received.add(event + ":" + ctx.getTranscript());
+        });
+        context.setActive(true);
+        while (!gate.hasQueuedThreads())
+            Thread.sleep(1);
+
+        // dispatching never blocks on the listener,
+        // and snapshots the context at the time of the event
+        context.setTranscript("a");
+        context.dispatch(Event.PARTIAL_RECOGNIZE);
+        context.traceDebug("test %d", 1);
+        context.setTranscript("ab");
+        context.dispatch(Event.PARTIAL_RECOGNIZE);
+        context.traceDebug("test %d", 2);
+        context.traceDebug("test %d", 3);
+
+        // the queue is full, so traces are dropped,
+        // but queued partials are still replaced
+        context.traceDebug("test %d", 4);
+        context.setTranscript("abc");
+        context.dispatch(Event.PARTIAL_RECOGNIZE);
+        assertEquals(1, context.getDroppedEvents());
+        assertEquals(null, context.getMessage());
+
+        // other events displace the oldest traces
+        context.setTranscript("final");
+        context.dispatch(Event.RECOGNIZE);
+        context.reset();
+        assertEquals(3, context.getDroppedEvents());
+
+        // deliver the queued events, in order
+        gate.release();
+        long deadline = System.currentTimeMillis() + 1000;
+        while (received.size() < 5 && System.currentTimeMillis() < deadline)
+            Thread.sleep(1);
+        assertEquals(
+            Arrays.asList(
+                "activate:",
+                "partial_recognize:abc",
+                "trace:test 3",
+                "recognize:final",
+                "deactivate:"),
+            received);
+    }
+
     @Test
     public void testSpeechEvents() {
         assertEquals("activate", Event.ACTIVATE.toString());
@@ -1,5 +1,7 @@
 package io.spokestack.spokestack;
 
+import java.io.File;
+import java.io.FileOutputStream;
 import java.lang.reflect.Field;
 import java.lang.reflect.InvocationTargetException;
 import java.util.*;
@@ -9,6 +11,8 @@ import java.nio.ByteBuffer;
 import androidx.annotation.NonNull;
 import io.spokestack.spokestack.android.AudioRecordError;
 import io.spokestack.spokestack.util.EventTracer;
+import io.spokestack.spokestack.util.LatencyHistogram;
+import io.spokestack.spokestack.util.StartupTimeline;
 import org.junit.After;
 import org.junit.Before;
 import org.junit.Test;
@@ -180,10 +184,14 @@ public class SpeechPipelineTest implements OnSpeechEventListener {
         pipeline.start();
         assertEquals(SpeechContext.Event.TRACE, this.events.get(0));
 
-        // first frame
+        // first frame, followed by the startup timeline trace
         transact(false);
         assertEquals(SpeechContext.Event.ACTIVATE, this.events.get(0));
         assertTrue(pipeline.getContext().isActive());
+        while (!this.events.contains(SpeechContext.Event.TRACE)) {
+            Thread.sleep(1);
+        }
+        assertNotNull(pipeline.getStartupTimeline().find("first frame"));
 
         // next frame
         transact(false);
@@ -239,6 +247,50 @@ public class SpeechPipelineTest implements OnSpeechEventListener {
         assertTrue(FreeInput.counter > frames);
     }
 
+    @Test
+    public void testStandby() throws Exception {
+        final SpeechPipeline pipeline = new SpeechPipeline.Builder()
+              .setInputClass("io.spokestack.spokestack.SpeechTestUtils$FreeInput")
+              .addStageClass("io.spokestack.spokestack.SpeechPipelineTest$CountStage")
+              .setProperty("pause-mode", "standby")
+              .setProperty("capture-buffer-width", 100)
+              .build();
+
+        CountStage.instances = 0;
+        pipeline.start();
+        Thread.sleep(5);
+        assertTrue(FreeInput.counter > 0);
+        assertEquals(0, pipeline.getResumeLatency());
+
+        // standby releases the input, but not the stages
+        pipeline.pause();
+        assertTrue(pipeline.isStandby());
+        Thread.sleep(20);
+        assertEquals(-1, FreeInput.counter);
+        assertTrue(pipeline.isRunning());
+        assertTrue(CountStage.open);
+
+        // resuming reopens the input without recreating the stages
+        pipeline.resume();
+        assertFalse(pipeline.isStandby());
+        Thread.sleep(10);
+        assertTrue(FreeInput.counter > 0);
+        assertEquals(1, CountStage.instances);
+        assertTrue(pipeline.getResumeLatency() > 0);
+
+        pipeline.stop();
+        assertFalse(CountStage.open);
+
+        // invalid pause mode
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() {
+                new SpeechPipeline.Builder()
+                    .setProperty("pause-mode", "invalid")
+                    .build();
+            }
+        });
+    }
+
     @Test
     public void testInputFailure() throws Exception {
         SpeechPipeline pipeline = new SpeechPipeline.Builder()
@@ -254,6 +306,212 @@ public class SpeechPipelineTest implements OnSpeechEventListener {
         assertEquals(SpeechContext.Event.ERROR, this.events.get(0));
     }
 
+    @Test
+    public void testCaptureThread() throws Exception {
+        final SpeechPipeline pipeline = new SpeechPipeline.Builder()
+            .setInputClass("io.spokestack.spokestack.SpeechPipelineTest$Input")
+            .addStageClass("io.spokestack.spokestack.SpeechPipelineTest$Stage")
+            .setProperty("sample-rate", 16000)
+            .setProperty("frame-width", 20)
+            .setProperty("buffer-width", 300)
+            .setProperty("capture-buffer-width", 100)
+            .addOnSpeechEventListener(this)
+            .build();
+        pipeline.start();
+        assertTrue(pipeline.isRunning());
+
+        // frames are delivered through the capture ring, in order
+        transact(false);
+        assertEquals(SpeechContext.Event.ACTIVATE, this.events.get(0));
+        transact(false);
+        assertEquals(SpeechContext.Event.DEACTIVATE, this.events.get(0));
+        transact(false);
+        assertEquals(SpeechContext.Event.ACTIVATE, this.events.get(0));
+        assertEquals(0, pipeline.getCaptureOverruns());
+
+        // shutdown
+        Input.stop();
+        pipeline.close();
+        assertFalse(pipeline.isRunning());
+        assertEquals(-1, Input.counter);
+        assertFalse(Stage.open);
+    }
+
+    @Test
+    public void testCaptureFailure() throws Exception {
+        SpeechPipeline pipeline = new SpeechPipeline.Builder()
+            .setInputClass("io.spokestack.spokestack.SpeechPipelineTest$FailInput")
+            .setProperty("capture-buffer-width", 100)
+            .addOnSpeechEventListener(this)
+            .build();
+        pipeline.start();
+
+        // wait for pipeline to shut down due to error
+        while (pipeline.isRunning()) {
+            Thread.sleep(1);
+        }
+        assertEquals(SpeechContext.Event.ERROR, this.events.get(0));
+    }
+
+    @Test
+    public void testBatch() throws Exception {
+        // write a 1s raw pcm file, in 20ms frames
+        File file = File.createTempFile("spokestack", ".pcm");
+        file.deleteOnExit();
+        try (FileOutputStream stream = new FileOutputStream(file)) {
+            stream.write(new byte[16000 * 2]);
+        }
+
+        final SpeechPipeline pipeline = new SpeechPipeline.Builder()
+            .setInputClass("io.spokestack.spokestack.FileInput")
+            .addStageClass(
+                "io.spokestack.spokestack.SpeechPipelineTest$PositionStage")
+            .setProperty("input-path", file.getPath())
+            .setProperty("capture-buffer-width", 100)
+            .addOnSpeechEventListener(this)
+            .build();
+
+        // all frames are processed on the calling thread,
+        // and the end of the file is not an error
+        PositionStage.positions.clear();
+        pipeline.runBatch();
+        assertFalse(pipeline.isRunning());
+        assertEquals(0, pipeline.getCaptureOverruns());
+        assertFalse(this.events.contains(SpeechContext.Event.ERROR));
+        assertEquals(50, PositionStage.positions.size());
+        for (int i = 0; i < 50; i++)
+            assertEquals(i * 320L, (long) PositionStage.positions.get(i));
+        assertSame(Thread.currentThread(), PositionStage.thread);
+
+        // batches can be rerun, but not while the pipeline is running
+        PositionStage.positions.clear();
+        pipeline.runBatch();
+        assertEquals(50, PositionStage.positions.size());
+        assertEquals(0L, (long) PositionStage.positions.get(0));
+
+        SpeechPipeline running = new SpeechPipeline.Builder()
+            .setInputClass("io.spokestack.spokestack.SpeechPipelineTest$Input")
+            .build();
+        running.start();
+        assertThrows(IllegalStateException.class, running::runBatch);
+        Input.stop();
+        running.stop();
+    }
+
+    @Test
+    public void testGating() throws Exception {
+        // write a 1s raw pcm file, in 20ms frames
+        File file = File.createTempFile("spokestack", ".pcm");
+        file.deleteOnExit();
+        try (FileOutputStream stream = new FileOutputStream(file)) {
+            stream.write(new byte[16000 * 2]);
+        }
+
+        final SpeechPipeline pipeline = new SpeechPipeline.Builder()
+            .setInputClass("io.spokestack.spokestack.FileInput")
+            .addStageClass(
+                "io.spokestack.spokestack.SpeechPipelineTest$ToggleStage")
+            .addStageClass(
+                "io.spokestack.spokestack.SpeechPipelineTest$GatedStage")
+            .setProperty("input-path", file.getPath())
+            .build();
+
+        // the gated stage sees the active frames (10-19),
+        // and the frame that deactivates the pipeline
+        GatedStage.positions.clear();
+        pipeline.runBatch();
+        assertEquals(11, GatedStage.positions.size());
+        for (int i = 0; i < 11; i++)
+            assertEquals((i + 10) * 320L, (long) GatedStage.positions.get(i));
+        assertArrayEquals(new long[] {0, 39}, pipeline.getSkippedFrames());
+    }
+
+    @Test
+    public void testLatency() throws Exception {
+        // write a 200ms raw pcm file, in 20ms frames
+        File file = File.createTempFile("spokestack", ".pcm");
+        file.deleteOnExit();
+        try (FileOutputStream stream = new FileOutputStream(file)) {
+            stream.write(new byte[3200 * 2]);
+        }
+
+        final SpeechPipeline pipeline = new SpeechPipeline.Builder()
+            .setInputClass("io.spokestack.spokestack.FileInput")
+            .addStageClass(
+                "io.spokestack.spokestack.SpeechPipelineTest$PositionStage")
+            .addStageClass(
+                "io.spokestack.spokestack.SpeechPipelineTest$SlowStage")
+            .setProperty("input-path", file.getPath())
+            .setProperty("trace-level", EventTracer.Level.PERF.value())
+            .setProperty("latency-trace-interval", 100)
+            .addOnSpeechEventListener(this)
+            .build();
+        assertTrue(pipeline.getStageLatencies().isEmpty());
+        assertEquals(0, pipeline.getFrameLatency().getCount());
+        pipeline.runBatch();
+
+        // every stage and frame was timed
+        assertEquals(2, pipeline.getStageLatencies().size());
+        for (LatencyHistogram latency : pipeline.getStageLatencies())
+            assertEquals(10, latency.getCount());
+        assertEquals(10, pipeline.getFrameLatency().getCount());
+
+        // the slow frame overran its deadline
+        assertEquals(1, pipeline.getDeadlineOverruns());
+        assertTrue(pipeline.getStageLatencies().get(1).getMax() >= 30000000);
+        assertTrue(pipeline.getFrameLatency().getMax() >= 30000000);
+
+        // the histograms were traced every 5 frames,
+        // after the startup timeline was traced on the first frame
+        int traces = 0;
+        for (SpeechContext.Event event : this.events) {
+            if (event == SpeechContext.Event.TRACE)
+                traces++;
+        }
+        assertEquals(7, traces);
+    }
+
+    @Test
+    public void testStartupTimeline() throws Exception {
+        // write a 100ms raw pcm file, in 20ms frames
+        File file = File.createTempFile("spokestack", ".pcm");
+        file.deleteOnExit();
+        try (FileOutputStream stream = new FileOutputStream(file)) {
+            stream.write(new byte[1600 * 2]);
+        }
+
+        final SpeechPipeline pipeline = new SpeechPipeline.Builder()
+            .setInputClass("io.spokestack.spokestack.FileInput")
+            .addStageClass(
+                "io.spokestack.spokestack.SpeechPipelineTest$LoadStage")
+            .addStageClass(
+                "io.spokestack.spokestack.SpeechPipelineTest$SlowStage")
+            .setProperty("input-path", file.getPath())
+            .build();
+        pipeline.runBatch();
+
+        // the input, the stages, and the work within them were recorded
+        StartupTimeline timeline = pipeline.getStartupTimeline();
+        StartupTimeline.Span input = timeline.find("FileInput");
+        StartupTimeline.Span stage = timeline.find("LoadStage");
+        StartupTimeline.Span load = timeline.find("LoadStage/load");
+        assertNotNull(input);
+        assertNotNull(stage);
+        assertNotNull(timeline.find("SlowStage"));
+        assertTrue(load.getDuration() >= 10000000);
+        assertTrue(stage.getDuration() >= load.getDuration());
+        assertTrue(stage.getStart() >= input.getStart() + input.getDuration());
+
+        // the first frame includes construction and the slow stage
+        StartupTimeline.Span first = timeline.find("first frame");
+        assertEquals(0, first.getStart());
+        assertTrue(first.getDuration() >= 40000000);
+
+        // the timeline is only attached during construction
+        assertNull(StartupTimeline.current());
+        assertTrue(timeline.toString().contains("\"LoadStage/load\""));
+    }
+
     @Test
     public void testStageFailure() throws Exception {
         SpeechPipeline pipeline = new SpeechPipeline.Builder()
@@ -272,6 +530,38 @@ public class SpeechPipelineTest implements OnSpeechEventListener {
         assertEquals(SpeechContext.Event.ERROR, this.events.get(0));
     }
 
+    @Test
+    public void testSwapModels() throws Exception {
+        SwapStage.pending = 0;
+        SpeechPipeline pipeline = new SpeechPipeline.Builder()
+            .setInputClass("io.spokestack.spokestack.SpeechPipelineTest$Input")
+            .addStageClass("io.spokestack.spokestack.SpeechPipelineTest$SwapStage")
+            .addStageClass("io.spokestack.spokestack.SpeechPipelineTest$FailSwapStage")
+            .build();
+        pipeline.start();
+
+        // configurations without models are ignored
+        assertFalse(pipeline.swapModels(new SpeechConfig()));
+
+        // all stages accept the swap
+        SpeechConfig models = new SpeechConfig().put("model-path", "model");
+        assertTrue(pipeline.swapModels(models));
+        assertEquals(2, SwapStage.pending);
+
+        // a stage that rejects the swap cancels it in the other stages
+        SwapStage.pending = 0;
+        assertThrows(IllegalArgumentException.class,
+            () -> pipeline.swapModels(models.put("swap-fail", true)));
+        assertEquals(0, SwapStage.pending);
+
+        Input.stop();
+        pipeline.stop();
+
+        // stopped pipelines reject swaps
+        assertThrows(IllegalStateException.class,
+            () -> pipeline.swapModels(new SpeechConfig()));
+    }
+
     @Test
     public void testContextManagement() throws Exception {
         SpeechPipeline pipeline = new SpeechPipeline.Builder()
@@ -408,6 +698,119 @@ public class SpeechPipelineTest implements OnSpeechEventListener {
         }
     }
 
+    public static class PositionStage implements SpeechProcessor {
+        public static final List<Long> positions = new ArrayList<>();
+        public static Thread thread;
+
+        public PositionStage(SpeechConfig config) {
+        }
+
+        public void reset() {
+        }
+
+        public void close() {
+        }
+
+        public void process(SpeechContext context, ByteBuffer frame) {
+            positions.add(context.getSamplePosition());
+            thread = Thread.currentThread();
+        }
+    }
+
+    public static class CountStage implements SpeechProcessor {
+        public static int instances;
+        public static boolean open;
+
+        public CountStage(SpeechConfig config) {
+            instances++;
+            open = true;
+        }
+
+        public void reset() {
+        }
+
+        public void close() {
+            open = false;
+        }
+
+        public void process(SpeechContext context, ByteBuffer frame) {
+        }
+    }
+
+    public static class ToggleStage implements SpeechProcessor {
+        public ToggleStage(SpeechConfig config) {
+        }
+
+        public void reset() {
+        }
+
+        public void close() {
+        }
+
+        public void process(SpeechContext context, ByteBuffer frame) {
+            long position = context.getSamplePosition();
+            context.setActive(position >= 3200 && position < 6400);
+        }
+    }
+
+    public static class GatedStage implements SpeechProcessor {
+        public static final List<Long> positions = new ArrayList<>();
+
+        public GatedStage(SpeechConfig config) {
+        }
+
+        public Set<State> getStates() {
+            return ACTIVE_STATES;
+        }
+
+        public void reset() {
+        }
+
+        public void close() {
+        }
+
+        public void process(SpeechContext context, ByteBuffer frame) {
+            positions.add(context.getSamplePosition());
+        }
+    }
+
+    public static class LoadStage implements SpeechProcessor {
+        public LoadStage(SpeechConfig config) throws InterruptedException {
+            long start = System.nanoTime();
+            Thread.sleep(10);
+            StartupTimeline.record("load", start);
+        }
+
+        public void reset() {
+        }
+
+        public void close() {
+        }
+
+        public void process(SpeechContext context, ByteBuffer frame) {
+        }
+    }
+
+    public static class SlowStage implements SpeechProcessor {
+        private boolean slow = true;
+
+        public SlowStage(SpeechConfig config) {
+        }
+
+        public void reset() {
+        }
+
+        public void close() {
+        }
+
+        public void process(SpeechContext context, ByteBuffer frame)
+                throws InterruptedException {
+            if (this.slow)
+                Thread.sleep(30);
+            this.slow = false;
+        }
+    }
+
     public static class FailInput implements SpeechInput {
         public FailInput(SpeechConfig config) {
         }
@@ -440,6 +843,48 @@ public class SpeechPipelineTest implements OnSpeechEventListener {
         }
     }
 
+    public static class SwapStage implements SpeechProcessor {
+        public static int pending;
+
+        public SwapStage(SpeechConfig config) {
+        }
+
+        public void reset() {
+        }
+
+        public void close() {
+        }
+
+        public void process(SpeechContext context, ByteBuffer frame) {
+        }
+
+        @Override
+        public boolean swapModels(SpeechConfig config) {
+            if (!config.containsKey("model-path"))
+                return false;
+            pending++;
+            return true;
+        }
+
+        @Override
+        public void cancelSwap() {
+            pending--;
+        }
+    }
+
+    public static class FailSwapStage extends SwapStage {
+        public FailSwapStage(SpeechConfig config) {
+            super(config);
+        }
+
+        @Override
+        public boolean swapModels(SpeechConfig config) {
+            if (config.containsKey("swap-fail"))
+                throw new IllegalArgumentException("invalid model");
+            return super.swapModels(config);
+        }
+    }
+
     public static class ConfigRequiredStage implements SpeechProcessor {
         public ConfigRequiredStage(SpeechConfig config) {
             config.getString("required-property");
@@ -14,6 +14,7 @@ import static org.mockito.Mockito.*;
 import io.spokestack.spokestack.OnSpeechEventListener;
 import io.spokestack.spokestack.SpeechConfig;
 import io.spokestack.spokestack.SpeechContext;
+import io.spokestack.spokestack.tensorflow.TensorFormat;
 import io.spokestack.spokestack.tensorflow.TensorflowModel;
 
 public class KeywordRecognizerTest {
@@ -189,6 +190,107 @@ public class KeywordRecognizerTest {
     }
 
 
+    @Test
+    public void testSwapModels() throws Exception {
+        SpeechConfig config = testConfig();
+        TestEnv env = new TestEnv(config);
+
+        // configurations without keyword models are ignored
+        assertFalse(env.recognizer.swapModels(new SpeechConfig()));
+
+        // new models are deferred until the current utterance ends
+        TestEnv next = new TestEnv(config);
+        doReturn(next.filter)
+            .doReturn(next.encode)
+            .doReturn(next.detect)
+            .when(env.loader).load();
+
+        env.context.setActive(true);
+        env.process();
+        assertTrue(env.recognizer.swapModels(testConfig()
+            .put("keyword-classes", "cat,bird")));
+        env.detect.setOutputs(0.5f, 0.9f);
+        env.process();
+
+        env.context.setActive(false);
+        env.process();
+
+        assertEquals("dog", env.context.getTranscript());
+        verify(env.detect, never()).close();
+
+        // and are swapped in, with their classes, at the next activation
+        env.context.setActive(true);
+        next.detect.setOutputs(0.9f, 0.5f);
+        env.process();
+
+        env.context.setActive(false);
+        env.process();
+
+        verify(env.detect).close();
+        assertEquals(SpeechContext.Event.RECOGNIZE, env.event);
+        assertEquals("cat", env.context.getTranscript());
+
+        // models that don't match their classes raise an error
+        TestEnv bad = new TestEnv(config);
+        doReturn(bad.filter)
+            .doReturn(bad.encode)
+            .doReturn(bad.detect)
+            .when(env.loader).load();
+        assertTrue(env.recognizer.swapModels(testConfig()
+            .put("keyword-classes", "up,dog,cat")));
+
+        env.context.setActive(true);
+        env.process();
+
+        assertEquals(SpeechContext.Event.ERROR, env.event);
+        verify(bad.detect).close();
+        verify(next.detect, never()).close();
+
+        // models loaded before a load failure are released
+        TestEnv partial = new TestEnv(config);
+        doReturn(partial.filter)
+            .doReturn(partial.encode)
+            .doThrow(new IllegalArgumentException("invalid model"))
+            .when(env.loader).load();
+        assertThrows(IllegalArgumentException.class,
+            () -> env.recognizer.swapModels(config));
+        verify(partial.filter).close();
+        verify(partial.encode).close();
+
+        // swaps are rejected once closed
+        env.recognizer.close();
+        assertThrows(IllegalStateException.class,
+            () -> env.recognizer.swapModels(config));
+    }
+
+    @Test
+    public void testLoadFailure() throws Exception {
+        // models that fail to load in the background (here, because the
+        // model files don't exist) raise a single error
+        TestEnv env = new TestEnv(testConfig()
+            .put("model-loading", "parallel"));
+        for (int i = 0; i < 100 && env.event == null; i++) {
+            env.process();
+            Thread.sleep(10);
+        }
+        assertEquals(SpeechContext.Event.ERROR, env.event);
+        assertEquals(IllegalStateException.class,
+            env.context.getError().getClass());
+
+        // after which the stage remains disabled
+        env.event = null;
+        env.process();
+        env.process();
+        assertNull(env.event);
+        verify(env.filter, never()).run();
+
+        // until models are swapped in to replace the failed ones
+        assertTrue(env.recognizer.swapModels(testConfig()));
+        env.process();
+        assertNull(env.event);
+        verify(env.filter, atLeastOnce()).run();
+    }
+
     public SpeechConfig testConfig() {
         return new SpeechConfig()
             .put("sample-rate", 16000)
@@ -282,6 +384,11 @@ public class KeywordRecognizerTest {
             doCallRealMethod().when(this.filter).run();
             doCallRealMethod().when(this.encode).run();
             doCallRealMethod().when(this.detect).run();
+            for (TestModel model : new TestModel[] {
+                    this.filter, this.encode, this.detect}) {
+                doReturn(TensorFormat.FLOAT).when(model).inputFormat(0);
+                doReturn(TensorFormat.FLOAT).when(model).outputFormat(0);
+            }
             doReturn(this.filter)
                 .doReturn(this.encode)
                 .doReturn(this.detect)
@@ -0,0 +1,97 @@
+package io.spokestack.spokestack.nlu.tensorflow;
+
+import io.spokestack.spokestack.nlu.NLUResult;
+
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Paths;
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * compares batched NLU classification throughput at several batch sizes.
+ *
+ * <p>
+ * This is a host harness rather than a unit test, since it requires the
+ * TensorFlow Lite native library. It can be run from the test classpath of
+ * any environment that provides it, for example:
+ * </p>
+ * <pre>
+ * mvn exec:java -Dexec.classpathScope=test \
+ *   -Dexec.mainClass=io.spokestack.spokestack.nlu.tensorflow.NLUBenchmark \
+ *   -Dexec.args="nlu.tflite metadata.json vocab.txt utterances.txt"
+ * </pre>
+ *
+ * <p>
+ * The utterance file contains one utterance per line. For each batch size,
+ * the harness classifies all of the utterances once to warm up, and then
+ * reports the time taken to classify them again, the throughput in
+ * utterances per second, and the number of utterances that failed.
+ * </p>
+ */
+public final class NLUBenchmark {
+    private static final int[] BATCH_SIZES = {1, 2, 4, 8, 16, 32, 64};
+
+    private NLUBenchmark() {
+    }
+
+    public static void main(String[] args) throws Exception {
+        if (args.length < 4) {
+            System.err.println("usage: NLUBenchmark <model-path> "
+                + "<metadata-path> <vocab-path> <utterance-path>");
+            System.exit(1);
+        }
+        List<String> utterances = readUtterances(args[3]);
+        System.out.printf("%10s %10s %12s %12s %8s%n",
+            "batch", "count", "total-ms", "utt/s", "errors");
+        for (int batchSize : BATCH_SIZES) {
+            run(args, utterances, batchSize);
+        }
+    }
+
+    private static List<String> readUtterances(String path)
+            throws IOException {
+        List<String> utterances = new ArrayList<>();
+        for (String line : Files.readAllLines(
+            Paths.get(path), StandardCharsets.UTF_8)) {
+            if (!line.trim().isEmpty()) {
+                utterances.add(line.trim());
+            }
+        }
+        return utterances;
+    }
+
+    private static void run(String[] args,
+                            List<String> utterances,
+                            int batchSize) throws Exception {
+        TensorflowNLU nlu = new TensorflowNLU.Builder()
+            .setProperty("nlu-model-path", args[0])
+            .setProperty("nlu-metadata-path", args[1])
+            .setProperty("wordpiece-vocab-path", args[2])
+            .setProperty("nlu-batch-size", batchSize)
+            .build();
+        try {
+            nlu.classifyBatch(utterances).get();
+
+            long start = System.nanoTime();
+            List<NLUResult> results = nlu.classifyBatch(utterances).get();
+            double elapsed = (System.nanoTime() - start) / 1e9;
+
+            int errors = 0;
+            for (NLUResult result : results) {
+                if (result.getError() != null) {
+                    errors++;
+                }
+            }
+            System.out.printf("%10d %10d %12.1f %12.1f %8d%n",
+                batchSize,
+                results.size(),
+                elapsed * 1e3,
+                results.size() / elapsed,
+                errors);
+        } finally {
+            nlu.close();
+        }
+    }
+}
@@ -7,6 +7,7 @@ import io.spokestack.spokestack.nlu.NLUContext;
 import io.spokestack.spokestack.nlu.NLUManager;
 import io.spokestack.spokestack.nlu.NLUResult;
 import io.spokestack.spokestack.nlu.NLUService;
+import io.spokestack.spokestack.tensorflow.TensorFormat;
 import io.spokestack.spokestack.tensorflow.TensorflowModel;
 import io.spokestack.spokestack.util.AsyncResult;
 
@@ -79,30 +80,37 @@ public class NLUTestUtils {
             // create/mock tensorflow-lite models
             int maxTokens = 100;
             this.loader = spy(TensorflowModel.Loader.class);
-            this.testModel = mock(TestModel.class);
+            this.testModel = mockModel(maxTokens);
+            doReturn(this.testModel)
+                  .when(this.loader).load();
+
+            this.nluBuilder =
+                  new TensorflowNLU.Builder()
+                        .setConfig(config)
+                        .setModelLoader(this.loader)
+                        .setTextEncoder(this);
+        }
 
+        public TestModel mockModel(int maxTokens) {
+            TestModel model = mock(TestModel.class);
             doReturn(ByteBuffer
-                  .allocateDirect(maxTokens * metadata.getIntents().length * 4)
+                  .allocateDirect(maxTokens * 4)
                   .order(ByteOrder.nativeOrder()))
-                  .when(this.testModel).inputs(0);
+                  .when(model).inputs(0);
             doReturn(ByteBuffer
                   .allocateDirect(metadata.getIntents().length * 4)
                   .order(ByteOrder.nativeOrder()))
-                  .when(this.testModel).outputs(0);
+                  .when(model).outputs(0);
             doReturn(ByteBuffer
                   .allocateDirect(maxTokens * metadata.getTags().length * 4)
                   .order(ByteOrder.nativeOrder()))
-                  .when(this.testModel).outputs(1);
-            doReturn(4).when(this.testModel).getInputSize();
-            doCallRealMethod().when(this.testModel).run();
-            doReturn(this.testModel)
-                  .when(this.loader).load();
-
-            this.nluBuilder =
-                  new TensorflowNLU.Builder()
-                        .setConfig(config)
-                        .setModelLoader(this.loader)
-                        .setTextEncoder(this);
+                  .when(model).outputs(1);
+            doReturn(4).when(model).getInputSize();
+            doCallRealMethod().when(model).run();
+            doReturn(TensorFormat.INT32).when(model).inputFormat(0);
+            doReturn(TensorFormat.FLOAT).when(model).outputFormat(0);
+            doReturn(TensorFormat.FLOAT).when(model).outputFormat(1);
+            return model;
         }
 
         private Metadata loadMetadata(String metadataPath)
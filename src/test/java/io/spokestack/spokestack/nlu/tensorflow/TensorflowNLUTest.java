@@ -12,7 +12,11 @@ import org.junit.runner.RunWith;
 import org.powermock.core.classloader.annotations.PrepareForTest;
 import org.powermock.modules.junit4.PowerMockRunner;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.Arrays;
 import java.util.HashMap;
+import java.util.List;
 import java.util.Map;
 import java.util.concurrent.ThreadFactory;
 import java.util.concurrent.atomic.AtomicBoolean;
@@ -20,6 +24,12 @@ import java.util.concurrent.atomic.AtomicBoolean;
 import static io.spokestack.spokestack.nlu.tensorflow.NLUTestUtils.TestEnv;
 import static io.spokestack.spokestack.nlu.tensorflow.NLUTestUtils.testConfig;
 import static org.junit.jupiter.api.Assertions.*;
+import static org.mockito.ArgumentMatchers.anyInt;
+import static org.mockito.Mockito.doAnswer;
+import static org.mockito.Mockito.doReturn;
+import static org.mockito.Mockito.never;
+import static org.mockito.Mockito.times;
+import static org.mockito.Mockito.verify;
 import static org.powermock.api.mockito.PowerMockito.mockStatic;
 
 @RunWith(PowerMockRunner.class)
@@ -142,6 +152,160 @@ public class TensorflowNLUTest {
         assertTrue(result.getContext().isEmpty());
     }
 
+    @Test
+    public void classifyBatch() throws Exception {
+        TestEnv env = new TestEnv(testConfig().put("nlu-batch-size", 2));
+        int numIntents = env.metadata.getIntents().length;
+
+        // simulate resizing the model's batch dimension, predicting
+        // intent r for each batch row r
+        ByteBuffer[] buffers = {
+              env.testModel.inputs(0),
+              env.testModel.outputs(0),
+              env.testModel.outputs(1)
+        };
+        int[] rowSizes = new int[buffers.length];
+        for (int i = 0; i < buffers.length; i++) {
+            rowSizes[i] = buffers[i].capacity();
+        }
+        doAnswer(invocation -> {
+            int rows = invocation.getArgument(0);
+            for (int i = 0; i < buffers.length; i++) {
+                buffers[i] = ByteBuffer
+                      .allocateDirect(rowSizes[i] * rows)
+                      .order(ByteOrder.nativeOrder());
+            }
+            for (int r = 0; r < rows; r++) {
+                buffers[1].putFloat((r * numIntents + r) * 4, 10);
+            }
+            return null;
+        }).when(env.testModel).setBatchSize(anyInt());
+        doAnswer(invocation -> buffers[0]).when(env.testModel).inputs(0);
+        doAnswer(invocation -> buffers[1]).when(env.testModel).outputs(0);
+        doAnswer(invocation -> buffers[2]).when(env.testModel).outputs(1);
+        env.nlu = env.nluBuilder.build();
+
+        StringBuilder tooManyTokens = new StringBuilder();
+        for (int i = 0; i <= env.nlu.getMaxTokens(); i++) {
+            tooManyTokens.append("a ");
+        }
+        List<String> utterances = Arrays.asList(
+              "a b", "c d", "error", "e f g", tooManyTokens.toString());
+        List<NLUResult> results = env.nlu.classifyBatch(utterances).get();
+
+        // utterances are packed into batches of 2, padding the last one,
+        // and each result is read from its own row; failures only affect
+        // their own results
+        verify(env.testModel, times(3)).setBatchSize(2);
+        verify(env.testModel).setBatchSize(1);
+        verify(env.testModel, times(4)).setBatchSize(anyInt());
+        assertEquals(utterances.size(), results.size());
+        for (int i = 0; i < results.size(); i++) {
+            assertEquals(utterances.get(i), results.get(i).getUtterance());
+        }
+        assertEquals("accept", results.get(0).getIntent());
+        assertEquals(10.0, results.get(0).getConfidence());
+        assertEquals("reject", results.get(1).getIntent());
+        assertEquals(IllegalStateException.class,
+              results.get(2).getError().getClass());
+        assertEquals("reject", results.get(3).getIntent());
+        assertNull(results.get(3).getError());
+        assertEquals(IllegalArgumentException.class,
+              results.get(4).getError().getClass());
+
+        // the job restores the single-utterance batch, so that single
+        // classification runs without resizing
+        env.classify("a b").get();
+        verify(env.testModel).setBatchSize(1);
+    }
+
+    @Test
+    public void lengthBuckets() throws Exception {
+        TestEnv env = new TestEnv(
+              testConfig().put("nlu-length-buckets", "16, 4, 200"));
+        int numIntents = env.metadata.getIntents().length;
+        NLUTestUtils.TestModel shortModel = env.mockModel(4);
+        NLUTestUtils.TestModel mediumModel = env.mockModel(16);
+        doReturn(env.testModel, shortModel, mediumModel)
+              .when(env.loader).load();
+
+        // each bucket below the model's maximum length is loaded once,
+        // resized, and warmed up
+        env.nlu = env.nluBuilder.build();
+        env.nlu.classify("").get();
+        verify(shortModel).setInputLength(4);
+        verify(mediumModel).setInputLength(16);
+        verify(env.testModel, never()).setInputLength(anyInt());
+
+        // utterances are padded to the shortest bucket that also fits the
+        // separator token
+        shortModel.setOutputs(buildIntentResult(1, numIntents), new float[0]);
+        NLUResult result = env.classify("a b c").get();
+        assertNull(result.getError());
+        assertEquals("reject", result.getIntent());
+        assertEquals(1, shortModel.inputs(0).getInt(3 * 4));
+        verify(mediumModel, times(1)).run();
+
+        env.classify("a b c d").get();
+        verify(mediumModel, times(2)).run();
+
+        StringBuilder longUtterance = new StringBuilder();
+        for (int i = 0; i < 16; i++) {
+            longUtterance.append("a ");
+        }
+        env.classify(longUtterance.toString()).get();
+        verify(mediumModel, times(2)).run();
+
+        // a batch is padded to the bucket of its longest utterance
+        int[] rowSizes = {
+              16 * 4,
+              numIntents * 4,
+              16 * env.metadata.getTags().length * 4
+        };
+        for (int i = 0; i < rowSizes.length; i++) {
+            ByteBuffer rows = ByteBuffer
+                  .allocateDirect(2 * rowSizes[i])
+                  .order(ByteOrder.nativeOrder());
+            if (i == 0) {
+                doReturn(rows).when(mediumModel).inputs(0);
+            } else {
+                doReturn(rows).when(mediumModel).outputs(i - 1);
+            }
+        }
+        List<NLUResult> results = env.nlu
+              .classifyBatch(Arrays.asList("a", "a b c d e"))
+              .get();
+        verify(mediumModel).setBatchSize(2);
+        verify(mediumModel, times(3)).run();
+        assertNull(results.get(0).getError());
+        assertNull(results.get(1).getError());
+
+        // invalid buckets
+        assertThrows(IllegalArgumentException.class, () ->
+              new TestEnv(testConfig().put("nlu-length-buckets", "8,x"))
+                    .nluBuilder.build());
+        assertThrows(IllegalArgumentException.class, () ->
+              new TestEnv(testConfig().put("nlu-length-buckets", "0"))
+                    .nluBuilder.build());
+
+        // all models are closed with the NLU
+        env.nlu.close();
+        verify(shortModel).close();
+        verify(mediumModel).close();
+        verify(env.testModel).close();
+    }
+
+    @Test
+    public void closeAfterLoadFailure() throws Exception {
+        // the NLU can be closed even if its model never loaded
+        TestEnv env = new TestEnv(testConfig());
+        env.nlu = env.nluBuilder
+              .setProperty("nlu-metadata-path", "missing.json")
+              .build();
+        env.nlu.close();
+        verify(env.testModel, never()).close();
+    }
+
     private float[] buildIntentResult(int index, int numIntents) {
         float[] result = new float[numIntents];
         result[index] = 10;
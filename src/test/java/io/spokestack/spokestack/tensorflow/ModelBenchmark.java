@@ -0,0 +1,90 @@
+package io.spokestack.spokestack.tensorflow;
+
+import java.util.Arrays;
+
+/**
+ * compares TensorFlow Lite interpreter options on the same models.
+ *
+ * <p>
+ * This is a host harness rather than a unit test, since it requires the
+ * TensorFlow Lite native library. It can be run from the test classpath of
+ * any environment that provides it, for example:
+ * </p>
+ * <pre>
+ * mvn exec:java -Dexec.classpathScope=test \
+ *   -Dexec.mainClass=io.spokestack.spokestack.tensorflow.ModelBenchmark \
+ *   -Dexec.args="500 filter.tflite encode.tflite detect.tflite"
+ * </pre>
+ *
+ * <p>
+ * For each model and configuration, the harness reports the load time and
+ * the mean, median and 95th percentile inference latency over the given
+ * number of runs, after an equal number of warmup runs. Inputs are left
+ * zeroed, which is valid for both the audio models and the NLU model's
+ * token ids.
+ * </p>
+ */
+public final class ModelBenchmark {
+    private static final ModelOptions[] CONFIGURATIONS = {
+        new ModelOptions(),
+        new ModelOptions().setThreads(1),
+        new ModelOptions().setThreads(2),
+        new ModelOptions().setThreads(4),
+        new ModelOptions().setFp16(true),
+        new ModelOptions().setXnnpack(true),
+        new ModelOptions().setXnnpack(true).setThreads(4),
+    };
+
+    private ModelBenchmark() {
+    }
+
+    public static void main(String[] args) {
+        if (args.length < 2) {
+            System.err.println(
+                "usage: ModelBenchmark <iterations> <model-path>...");
+            System.exit(1);
+        }
+        int iterations = Integer.parseInt(args[0]);
+        System.out.printf("%-24s %-46s %9s %9s %9s %9s%n",
+            "model", "options", "load-ms", "mean-us", "p50-us", "p95-us");
+        for (int i = 1; i < args.length; i++) {
+            for (ModelOptions options : CONFIGURATIONS)
+                run(args[i], options, iterations);
+        }
+    }
+
+    private static void run(String path, ModelOptions options, int count) {
+        long start = System.nanoTime();
+        TensorflowModel model = new TensorflowModel.Loader()
+            .setOptions(options)
+            .setPath(path)
+            .load();
+        double loadMs = (System.nanoTime() - start) / 1e6;
+
+        try {
+            long[] times = new long[count];
+            for (int i = 0; i < count; i++)
+                model.run();
+            for (int i = 0; i < count; i++) {
+                start = System.nanoTime();
+                model.run();
+                times[i] = System.nanoTime() - start;
+            }
+
+            Arrays.sort(times);
+            long total = 0;
+            for (long time : times)
+                total += time;
+            String name = path.substring(path.lastIndexOf('/') + 1);
+            System.out.printf("%-24s %-46s %9.2f %9.1f %9.1f %9.1f%n",
+                name,
+                options,
+                loadMs,
+                total / 1e3 / count,
+                times[count / 2] / 1e3,
+                times[count * 95 / 100] / 1e3);
+        } finally {
+            model.close();
+        }
+    }
+}
@@ -0,0 +1,86 @@
+package io.spokestack.spokestack.tensorflow;
+
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.nio.MappedByteBuffer;
+
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class ModelCacheTest {
+    @Test
+    public void testSharing() throws Exception {
+        final File file = createModel(100);
+        String path = file.getPath();
+        long resident = ModelCache.getResidentBytes();
+        long saved = ModelCache.getSavedBytes();
+
+        // the first reference maps the file
+        MappedByteBuffer first = ModelCache.acquire(path);
+        assertEquals(100, first.capacity());
+        assertEquals(resident + 100, ModelCache.getResidentBytes());
+        assertEquals(saved, ModelCache.getSavedBytes());
+
+        // later references share it
+        long reuses = ModelCache.getReuses();
+        MappedByteBuffer second = ModelCache.acquire(file.getAbsolutePath());
+        assertSame(first, second);
+        assertEquals(reuses + 1, ModelCache.getReuses());
+        assertEquals(resident + 100, ModelCache.getResidentBytes());
+        assertEquals(saved + 100, ModelCache.getSavedBytes());
+
+        // the file remains resident until all references are released
+        ModelCache.release(first);
+        assertEquals(resident + 100, ModelCache.getResidentBytes());
+        assertEquals(saved, ModelCache.getSavedBytes());
+        ModelCache.release(second);
+        assertEquals(resident, ModelCache.getResidentBytes());
+
+        // extra releases are ignored
+        ModelCache.release(first);
+        assertEquals(resident, ModelCache.getResidentBytes());
+
+        // trimmed files are mapped again
+        ModelCache.trim();
+        MappedByteBuffer third = ModelCache.acquire(path);
+        assertNotSame(first, third);
+
+        // a file replaced at the same path is mapped again, while the
+        // previous file remains referenced until it is released
+        writeModel(file, 200);
+        MappedByteBuffer replaced = ModelCache.acquire(path);
+        assertNotSame(third, replaced);
+        assertEquals(200, replaced.capacity());
+        assertEquals(resident + 300, ModelCache.getResidentBytes());
+        ModelCache.release(third);
+        assertEquals(resident + 200, ModelCache.getResidentBytes());
+        assertSame(replaced, ModelCache.acquire(path));
+        ModelCache.release(replaced);
+        ModelCache.release(replaced);
+        assertEquals(resident, ModelCache.getResidentBytes());
+        ModelCache.trim();
+
+        // invalid file
+        assertThrows(IOException.class, new Executable() {
+            public void execute() throws Exception {
+                ModelCache.acquire(file.getPath() + ".missing");
+            }
+        });
+        file.delete();
+    }
+
+    private File createModel(int size) throws IOException {
+        File file = File.createTempFile("model", ".tflite");
+        file.deleteOnExit();
+        writeModel(file, size);
+        return file;
+    }
+
+    private void writeModel(File file, int size) throws IOException {
+        try (FileOutputStream stream = new FileOutputStream(file)) {
+            stream.write(new byte[size]);
+        }
+    }
+}
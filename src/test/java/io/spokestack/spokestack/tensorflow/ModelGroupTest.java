@@ -0,0 +1,113 @@
+package io.spokestack.spokestack.tensorflow;
+
+import java.util.concurrent.CountDownLatch;
+
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+import static org.mockito.Mockito.*;
+
+import io.spokestack.spokestack.SpeechConfig;
+import io.spokestack.spokestack.util.StartupTimeline;
+
+public class ModelGroupTest {
+    @Test
+    public void testSerial() throws Exception {
+        final TensorflowModel.Loader loader =
+            spy(TensorflowModel.Loader.class);
+        final TensorflowModel first = mock(TensorflowModel.class);
+        final TensorflowModel second = mock(TensorflowModel.class);
+        doReturn(first).doReturn(second).when(loader).load();
+
+        // models are loaded in order, on the calling thread
+        ModelGroup models = new ModelGroup(new SpeechConfig());
+        assertEquals(0, models.add("first", loader.setPath("first-path")));
+        assertEquals(1, models.add("second", loader.setPath("second-path")));
+        verify(loader, times(2)).load();
+        assertTrue(models.isReady());
+        assertEquals(2, models.size());
+        assertSame(first, models.get(0));
+        assertSame(second, models.get(1));
+        assertEquals("second", models.getName(1));
+        assertTrue(models.getLoadTime(0) >= 0);
+
+        models.close();
+        verify(first).close();
+        verify(second).close();
+
+        // invalid loading mode
+        final SpeechConfig config = new SpeechConfig()
+            .put("model-loading", "invalid");
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { new ModelGroup(config); }
+        });
+    }
+
+    @Test
+    public void testParallel() throws Exception {
+        final CountDownLatch latch = new CountDownLatch(1);
+        final TensorflowModel model = mock(TensorflowModel.class);
+        SpeechConfig config = new SpeechConfig()
+            .put("model-loading", "parallel");
+
+        // models load in the background until released,
+        // recording into the startup timeline attached at construction
+        StartupTimeline timeline = new StartupTimeline();
+        timeline.attach();
+        timeline.setScope("Stage");
+        final ModelGroup models = new ModelGroup(config);
+        models.add("first", new TestLoader(latch, model));
+        models.add("second", new TestLoader(latch, null));
+        StartupTimeline.detach();
+        assertFalse(models.isReady());
+        assertThrows(IllegalStateException.class, new Executable() {
+            public void execute() { models.get(0); }
+        });
+
+        latch.countDown();
+        models.await();
+        assertTrue(models.isReady());
+        assertSame(model, models.get(0));
+        assertTrue(models.getLoadTime(0) > 0);
+        assertEquals(
+            models.getLoadTime(0),
+            timeline.find("Stage/model first").getDuration());
+        assertNull(timeline.find("Stage/model second"));
+
+        // load failures are reported when the model is retrieved
+        assertThrows(IllegalStateException.class, new Executable() {
+            public void execute() { models.get(1); }
+        });
+
+        models.close();
+        verify(model).close();
+    }
+
+    public static class TestLoader extends TensorflowModel.Loader {
+        private final CountDownLatch latch;
+        private final TensorflowModel model;
+
+        public TestLoader(CountDownLatch latch, TensorflowModel model) {
+            this.latch = latch;
+            this.model = model;
+        }
+
+        @Override
+        public TensorflowModel.Loader copy() {
+            return this;
+        }
+
+        @Override
+        public TensorflowModel load() {
+            try {
+                this.latch.await();
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+            }
+            if (this.model == null)
+                throw new IllegalArgumentException("load failed");
+            return this.model;
+        }
+    }
+}
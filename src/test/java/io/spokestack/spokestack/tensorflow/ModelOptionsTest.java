@@ -0,0 +1,44 @@
+package io.spokestack.spokestack.tensorflow;
+
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+import io.spokestack.spokestack.SpeechConfig;
+
+public class ModelOptionsTest {
+    @Test
+    public void testConfig() {
+        // defaults
+        ModelOptions options = new ModelOptions(new SpeechConfig(), "wake");
+        assertEquals(-1, options.getThreads());
+        assertFalse(options.isXnnpack());
+        assertFalse(options.isFp16());
+        assertFalse(options.isCancellable());
+
+        // configured values, by prefix
+        SpeechConfig config = new SpeechConfig()
+            .put("nlu-threads", 4)
+            .put("nlu-xnnpack", "true")
+            .put("nlu-fp16", "true")
+            .put("nlu-cancellable", "true");
+        options = new ModelOptions(config, "nlu");
+        assertEquals(4, options.getThreads());
+        assertTrue(options.isXnnpack());
+        assertTrue(options.isFp16());
+        assertTrue(options.isCancellable());
+        assertEquals(-1, new ModelOptions(config, "wake").getThreads());
+
+        // invalid values
+        final SpeechConfig threads = new SpeechConfig()
+            .put("keyword-threads", 0);
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { new ModelOptions(threads, "keyword"); }
+        });
+        final SpeechConfig flag = new SpeechConfig()
+            .put("keyword-xnnpack", "yes");
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { new ModelOptions(flag, "keyword"); }
+        });
+    }
+}
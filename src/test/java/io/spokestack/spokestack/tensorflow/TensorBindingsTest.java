@@ -0,0 +1,150 @@
+package io.spokestack.spokestack.tensorflow;
+
+import java.lang.management.ManagementFactory;
+import java.nio.ByteBuffer;
+import java.util.Map;
+
+import org.junit.Assume;
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class TensorBindingsTest {
+    private static final int[][] STATE = {{1, 1}};
+
+    @Test
+    public void testStateless() {
+        TensorBindings bindings =
+            new TensorBindings(new int[]{8}, new int[]{4, 12}, new int[0][]);
+        assertEquals(1, bindings.getInputCount());
+        assertEquals(2, bindings.getOutputCount());
+        assertEquals(0, bindings.getStateCount());
+        assertEquals(8, bindings.input(0).capacity());
+        assertEquals(12, bindings.output(1).capacity());
+
+        // arguments are bound to the buffers, and stay bound across runs
+        ByteBuffer input = bindings.input(0);
+        input.putFloat(1).putFloat(2);
+        run(bindings);
+        assertSame(input, bindings.input(0));
+        assertSame(input, bindings.inputArray()[0]);
+        assertSame(bindings.output(1), bindings.outputMap().get(1));
+        assertEquals(0, bindings.input(0).position());
+        assertEquals(0, bindings.output(0).position());
+        assertEquals(3.0f, bindings.output(0).getFloat());
+    }
+
+    @Test
+    public void testState() {
+        TensorBindings bindings =
+            new TensorBindings(new int[]{4, 8}, new int[]{4, 8}, STATE);
+        ByteBuffer first = bindings.state(0);
+        assertSame(bindings.input(1), first);
+        first.putFloat(1).putFloat(1);
+
+        // the state output becomes the next state input
+        run(bindings);
+        ByteBuffer second = bindings.state(0);
+        assertNotSame(first, second);
+        assertSame(first, bindings.output(1));
+        assertSame(second, bindings.inputArray()[1]);
+        assertSame(first, bindings.outputMap().get(1));
+        assertEquals(2.0f, second.getFloat());
+        second.rewind();
+
+        // and back again
+        run(bindings);
+        assertSame(first, bindings.state(0));
+        assertSame(second, bindings.output(1));
+    }
+
+    @Test
+    public void testMultipleStates() {
+        // two states, one of which moves position between input and output
+        TensorBindings bindings = new TensorBindings(
+            new int[]{4, 8, 12},
+            new int[]{4, 12, 8},
+            new int[][]{{1, 2}, {2, 1}});
+        assertEquals(2, bindings.getStateCount());
+        assertEquals(2, bindings.getStateInput(1));
+        ByteBuffer first = bindings.state(0);
+        ByteBuffer second = bindings.state(1);
+        assertSame(bindings.input(1), first);
+        assertSame(bindings.input(2), second);
+
+        // all states are fed back together
+        bindings.prepare();
+        bindings.complete();
+        assertSame(bindings.output(2), first);
+        assertSame(bindings.output(1), second);
+        assertSame(bindings.inputArray()[1], bindings.state(0));
+        assertSame(bindings.inputArray()[2], bindings.state(1));
+        bindings.prepare();
+        bindings.complete();
+        assertSame(first, bindings.state(0));
+        assertSame(second, bindings.state(1));
+
+        // invalid states
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() {
+                new TensorBindings(new int[]{4, 8}, new int[]{4, 4}, STATE);
+            }
+        });
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() {
+                new TensorBindings(
+                    new int[]{4, 4},
+                    new int[]{4, 4},
+                    new int[][]{{1, 1}, {1, 0}});
+            }
+        });
+    }
+
+    @Test
+    public void testAllocation() {
+        java.lang.management.ThreadMXBean mx =
+            ManagementFactory.getThreadMXBean();
+        Assume.assumeTrue(mx instanceof com.sun.management.ThreadMXBean);
+        com.sun.management.ThreadMXBean threads =
+            (com.sun.management.ThreadMXBean) mx;
+        Assume.assumeTrue(threads.isThreadAllocatedMemorySupported());
+        threads.setThreadAllocatedMemoryEnabled(true);
+        long thread = Thread.currentThread().getId();
+
+        TensorBindings bindings =
+            new TensorBindings(new int[]{4, 8}, new int[]{4, 8}, STATE);
+        int runs = 10000;
+        for (int i = 0; i < runs; i++)
+            run(bindings);
+
+        // measure the overhead of measuring, then a batch of runs
+        long start = threads.getThreadAllocatedBytes(thread);
+        long overhead = threads.getThreadAllocatedBytes(thread) - start;
+        start = threads.getThreadAllocatedBytes(thread);
+        for (int i = 0; i < runs; i++)
+            run(bindings);
+        long allocated =
+            threads.getThreadAllocatedBytes(thread) - start - overhead;
+        assertEquals(0, allocated / runs);
+    }
+
+    /**
+     * runs the bindings through a fake interpreter that writes the sum of
+     * each input's first two floats to the corresponding output, in the
+     * same way the interpreter copies into (and advances) the outputs.
+     */
+    private void run(TensorBindings bindings) {
+        bindings.prepare();
+        Object[] inputs = bindings.inputArray();
+        Map<Integer, Object> outputs = bindings.outputMap();
+        for (int i = 0; i < inputs.length; i++) {
+            ByteBuffer in = (ByteBuffer) inputs[i];
+            ByteBuffer out = (ByteBuffer) outputs.get(i);
+            float sum = in.getFloat(0);
+            if (in.capacity() >= 8)
+                sum += in.getFloat(4);
+            out.putFloat(sum);
+        }
+        bindings.complete();
+    }
+}
@@ -0,0 +1,69 @@
+package io.spokestack.spokestack.tensorflow;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+import io.spokestack.spokestack.tensorflow.TensorflowModel.Loader.DType;
+
+public class TensorFormatTest {
+    @Test
+    public void testUnquantized() {
+        ByteBuffer buffer = allocate(8);
+        TensorFormat.FLOAT.put(buffer, 1.5f);
+        TensorFormat.INT32.put(buffer, 42.4f);
+        assertEquals(8, buffer.position());
+
+        buffer.rewind();
+        assertEquals(1.5f, TensorFormat.FLOAT.get(buffer));
+        assertEquals(42f, TensorFormat.INT32.get(buffer));
+        assertEquals(4, TensorFormat.FLOAT.getSize());
+        assertEquals("FLOAT", TensorFormat.FLOAT.toString());
+    }
+
+    @Test
+    public void testQuantized() {
+        ByteBuffer buffer = allocate(4);
+
+        // signed, with clamping at the type's range
+        TensorFormat int8 = new TensorFormat(DType.INT8, 0.5f, -10);
+        assertEquals(1, int8.getSize());
+        int8.put(buffer, 2.0f);
+        int8.put(buffer, 1000f);
+        buffer.rewind();
+        assertEquals(-6, buffer.get(0));
+        assertEquals(2.0f, int8.get(buffer));
+        assertEquals(Byte.MAX_VALUE, buffer.get(1));
+        assertEquals((127 + 10) * 0.5f, int8.get(buffer));
+
+        // unsigned, where encoded values above 127 must not sign-extend
+        buffer.rewind();
+        TensorFormat uint8 = new TensorFormat(DType.UINT8, 1f / 255, 0);
+        uint8.put(buffer, 1.0f);
+        uint8.put(buffer, -1.0f);
+        buffer.rewind();
+        assertEquals(1.0f, uint8.get(buffer), 1e-6);
+        assertEquals(0f, uint8.get(buffer));
+        assertEquals("UINT8(" + (1f / 255) + ",0)", uint8.toString());
+
+        // equality covers the quantization parameters
+        assertEquals(int8, new TensorFormat(DType.INT8, 0.5f, -10));
+        assertEquals(int8.hashCode(),
+            new TensorFormat(DType.INT8, 0.5f, -10).hashCode());
+        assertNotEquals(int8, new TensorFormat(DType.INT8, 0.5f, 0));
+        assertNotEquals(int8, new TensorFormat(DType.UINT8, 0.5f, -10));
+        assertNotEquals(int8, TensorFormat.FLOAT);
+
+        // invalid scale
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { new TensorFormat(DType.INT8, 0, 0); }
+        });
+    }
+
+    private ByteBuffer allocate(int size) {
+        return ByteBuffer.allocateDirect(size).order(ByteOrder.nativeOrder());
+    }
+}
@@ -0,0 +1,24 @@
+package io.spokestack.spokestack.tensorflow;
+
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class TensorflowModelTest {
+    @Test
+    public void testStatePairs() {
+        final TensorflowModel.Loader loader = new TensorflowModel.Loader();
+
+        // valid specifications
+        assertSame(loader, loader.addStatePairs("1"));
+        loader.addStatePairs("1:2, 3 : 4");
+        loader.setStatePosition(1).addStatePair(2, 3);
+
+        // invalid specifications
+        for (final String spec : new String[] {"", "a", "1:", "1:2:3", "-1"}) {
+            assertThrows(IllegalArgumentException.class, new Executable() {
+                public void execute() { loader.addStatePairs(spec); }
+            });
+        }
+    }
+}
@@ -0,0 +1,58 @@
+package io.spokestack.spokestack.util;
+
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class LatencyHistogramTest {
+    @Test
+    public void testEmpty() {
+        LatencyHistogram histogram = new LatencyHistogram();
+        assertEquals(0, histogram.getCount());
+        assertEquals(0, histogram.getMax());
+        assertEquals(0, histogram.getPercentile(50));
+
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { histogram.getPercentile(-1); }
+        });
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { histogram.getPercentile(101); }
+        });
+    }
+
+    @Test
+    public void testPercentiles() {
+        LatencyHistogram histogram = new LatencyHistogram();
+
+        // 1..1000us
+        for (int i = 1; i <= 1000; i++)
+            histogram.record(i * 1000L);
+        assertEquals(1000, histogram.getCount());
+        assertEquals(1000000, histogram.getMax());
+
+        // percentiles are accurate to a bucket (12.5%)
+        assertEquals(500000, histogram.getPercentile(50), 500000 * 0.125);
+        assertEquals(950000, histogram.getPercentile(95), 950000 * 0.125);
+        assertEquals(990000, histogram.getPercentile(99), 990000 * 0.125);
+        assertEquals(1000000, histogram.getPercentile(100));
+        assertTrue(histogram.getPercentile(50) >= 500000);
+
+        // small values are exact
+        histogram.reset();
+        assertEquals(0, histogram.getCount());
+        histogram.record(3000);
+        histogram.record(5000);
+        assertEquals(4000, histogram.getPercentile(50));
+        assertEquals(5000, histogram.getPercentile(99));
+        assertEquals(5000, histogram.getMax());
+
+        // out-of-range values are clamped to the last bucket
+        histogram.record(Long.MAX_VALUE);
+        assertEquals(Long.MAX_VALUE, histogram.getMax());
+        assertEquals(Long.MAX_VALUE, histogram.getPercentile(100));
+        histogram.record(-1);
+        assertEquals(1000, histogram.getPercentile(0));
+
+        assertTrue(histogram.toString().startsWith("n 4 p50"));
+    }
+}
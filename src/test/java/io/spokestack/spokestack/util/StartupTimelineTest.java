@@ -0,0 +1,80 @@
+package io.spokestack.spokestack.util;
+
+import java.io.StringWriter;
+
+import org.junit.After;
+import org.junit.Test;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class StartupTimelineTest {
+    @After
+    public void after() {
+        StartupTimeline.detach();
+    }
+
+    @Test
+    public void testDetached() {
+        // recording without an attached timeline is a no-op
+        assertNull(StartupTimeline.current());
+        StartupTimeline.record("ignored", System.nanoTime());
+
+        StartupTimeline timeline = new StartupTimeline();
+        assertTrue(timeline.getSpans().isEmpty());
+        assertNull(timeline.find("ignored"));
+    }
+
+    @Test
+    public void testRecord() throws Exception {
+        StartupTimeline timeline = new StartupTimeline();
+        timeline.attach();
+        assertSame(timeline, StartupTimeline.current());
+
+        // spans are relative to the timeline's origin
+        long origin = timeline.getOrigin();
+        timeline.add("input", origin + 1000, origin + 3000);
+        StartupTimeline.Span input = timeline.find("input");
+        assertEquals(1000, input.getStart());
+        assertEquals(2000, input.getDuration());
+
+        // recorded spans are qualified by the current scope
+        timeline.setScope("Stage");
+        assertEquals("Stage/model", timeline.qualify("model"));
+        StartupTimeline.record("model", System.nanoTime());
+        timeline.setScope("");
+        assertEquals("model", timeline.qualify("model"));
+        assertNotNull(timeline.find("Stage/model"));
+
+        // spans can be recorded from other threads
+        Thread thread = new Thread(
+            () -> timeline.add("background", origin, System.nanoTime()));
+        thread.start();
+        thread.join();
+        assertEquals(3, timeline.getSpans().size());
+        assertEquals("background", timeline.getSpans().get(2).getName());
+
+        StartupTimeline.detach();
+        assertNull(StartupTimeline.current());
+    }
+
+    @Test
+    public void testExport() throws Exception {
+        StartupTimeline timeline = new StartupTimeline();
+        long origin = timeline.getOrigin();
+        timeline.add("Stage", origin + 500000, origin + 2500000);
+        timeline.add("\"quoted\"", origin, origin + 1000000);
+
+        StringWriter out = new StringWriter();
+        timeline.export(out);
+        assertEquals(
+            "{\"spans\":["
+                + "\n{\"name\":\"Stage\",\"start\":0.500,\"duration\":2.000},"
+                + "\n{\"name\":\"\\\"quoted\\\"\",\"start\":0.000,"
+                + "\"duration\":1.000}"
+                + "\n]}\n",
+            out.toString());
+        assertEquals(out.toString(), timeline.toString());
+        assertEquals(
+            "Stage at 0.5ms took 2.0ms",
+            timeline.getSpans().get(0).toString());
+    }
+}
@@ -0,0 +1,101 @@
+package io.spokestack.spokestack.util;
+
+import java.io.StringWriter;
+import java.util.List;
+
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+public class TraceRingTest {
+    @Before
+    public void before() {
+        // the ring is process-wide, so start each test with it empty
+        assertEquals(128, TraceRing.enable(100));
+        TraceRing.drain();
+    }
+
+    @Test
+    public void testRegister() {
+        int first = TraceRing.register("test-first", "first");
+        int second = TraceRing.register("test-second", "second %.0f", "x");
+        assertNotEquals(first, second);
+        assertEquals(first, TraceRing.register("test-first", "ignored"));
+
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() {
+                TraceRing.register("test-args", "", "a", "b", "c", "d", "e");
+            }
+        });
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { TraceRing.enable(0); }
+        });
+    }
+
+    @Test
+    public void testRecord() {
+        int instant = TraceRing.register("test-instant", "value %.1f");
+        int counter = TraceRing.register(
+            "test-counter",
+            "counter %.0f %.0f",
+            "a",
+            "b");
+
+        long start = System.nanoTime();
+        TraceRing.record(instant, 1.5);
+        TraceRing.record(counter, 2, 3);
+        TraceRing.record(instant);
+        long end = System.nanoTime();
+
+        List<TraceRing.Entry> entries = TraceRing.drain();
+        assertEquals(3, entries.size());
+        assertEquals(instant, entries.get(0).getId());
+        assertEquals("test-instant", entries.get(0).getName());
+        assertEquals("value 1.5", entries.get(0).getMessage());
+        assertEquals("counter 2 3", entries.get(1).getMessage());
+        assertEquals(3, entries.get(1).getArg(1));
+        assertEquals("value 0.0", entries.get(2).toString());
+        for (TraceRing.Entry entry : entries) {
+            assertTrue(entry.getTime() >= start);
+            assertTrue(entry.getTime() <= end);
+        }
+
+        // drained entries are removed
+        assertTrue(TraceRing.drain().isEmpty());
+    }
+
+    @Test
+    public void testOverflow() {
+        int event = TraceRing.register("test-overflow", "%.0f");
+        long lost = TraceRing.getLost();
+
+        // the oldest records are overwritten and counted as lost
+        for (int i = 0; i < 200; i++)
+            TraceRing.record(event, i);
+        List<TraceRing.Entry> entries = TraceRing.drain();
+        assertEquals(128, entries.size());
+        assertEquals(72, entries.get(0).getArg(0));
+        assertEquals(199, entries.get(127).getArg(0));
+        assertEquals(lost + 72, TraceRing.getLost());
+    }
+
+    @Test
+    public void testExport() throws Exception {
+        int instant = TraceRing.register("test-export", "say \"%.0f\"");
+        int counter = TraceRing.register("test-level", "%.1f", "level");
+        TraceRing.record(instant, 1);
+        TraceRing.record(counter, 2.5);
+
+        StringWriter writer = new StringWriter();
+        TraceRing.export(TraceRing.drain(), writer);
+        String json = writer.toString();
+        assertTrue(json.startsWith("{\"traceEvents\":["));
+        assertTrue(json.contains(
+            "{\"name\":\"test-export\",\"ph\":\"i\",\"s\":\"g\""));
+        assertTrue(json.contains("\"message\":\"say \\\"1\\\"\""));
+        assertTrue(json.contains("{\"name\":\"test-level\",\"ph\":\"C\""));
+        assertTrue(json.contains("\"args\":{\"level\":2.5}"));
+        assertTrue(json.endsWith("]}\n"));
+    }
+}
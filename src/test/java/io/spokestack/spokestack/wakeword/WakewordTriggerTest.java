@@ -2,6 +2,8 @@ package io.spokestack.spokestack.wakeword;
 
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
+import java.time.Duration;
+import java.util.concurrent.CountDownLatch;
 
 import androidx.annotation.NonNull;
 import org.junit.Test;
@@ -13,6 +15,7 @@ import static org.mockito.Mockito.*;
 import io.spokestack.spokestack.OnSpeechEventListener;
 import io.spokestack.spokestack.SpeechConfig;
 import io.spokestack.spokestack.SpeechContext;
+import io.spokestack.spokestack.tensorflow.TensorFormat;
 import io.spokestack.spokestack.tensorflow.TensorflowModel;
 
 public class WakewordTriggerTest {
@@ -237,6 +240,145 @@ public class WakewordTriggerTest {
         assertNotNull(env.context.getMessage());
     }
 
+    @Test
+    public void testSwapModels() throws Exception {
+        SpeechConfig config = testConfig();
+        TestEnv env = new TestEnv(config);
+
+        // configurations without wakeword models are ignored
+        assertFalse(env.wake.swapModels(new SpeechConfig()));
+
+        // compatible models are swapped in at the next frame
+        TestEnv next = new TestEnv(config);
+        doReturn(next.filter)
+            .doReturn(next.encode)
+            .doReturn(next.detect)
+            .when(env.loader).load();
+        assertTrue(env.wake.swapModels(config));
+
+        env.context.setSpeech(true);
+        next.detect.setOutputs(1);
+        env.process();
+
+        verify(env.filter).close();
+        verify(env.encode).close();
+        verify(env.detect).close();
+        verify(env.detect, never()).run();
+        verify(next.detect, atLeastOnce()).run();
+        assertEquals(SpeechContext.Event.ACTIVATE, env.event);
+
+        // incompatible models raise an error and are discarded
+        TestEnv bad = new TestEnv(testConfig().put("wake-encode-width", 64));
+        doReturn(bad.filter)
+            .doReturn(bad.encode)
+            .doReturn(bad.detect)
+            .when(env.loader).load();
+        assertTrue(env.wake.swapModels(config));
+
+        env.context.setActive(false);
+        next.detect.setOutputs(0);
+        env.process();
+
+        assertEquals(SpeechContext.Event.ERROR, env.event);
+        verify(bad.detect).close();
+        verify(next.detect, never()).close();
+
+        // models loaded before a load failure are released
+        TestEnv partial = new TestEnv(config);
+        doReturn(partial.filter)
+            .doReturn(partial.encode)
+            .doThrow(new IllegalArgumentException("invalid model"))
+            .when(env.loader).load();
+        assertThrows(IllegalArgumentException.class,
+            () -> env.wake.swapModels(config));
+        verify(partial.filter).close();
+        verify(partial.encode).close();
+
+        // pending models are released on close
+        doReturn(bad.filter)
+            .doReturn(bad.encode)
+            .doReturn(bad.detect)
+            .when(env.loader).load();
+        env.wake.swapModels(config);
+        env.wake.close();
+        verify(next.detect).close();
+        verify(bad.detect, times(2)).close();
+
+        // and swaps are rejected once closed
+        assertThrows(IllegalStateException.class,
+            () -> env.wake.swapModels(config));
+    }
+
+    @Test
+    public void testSwapDuringLoad() throws Exception {
+        SpeechConfig config = testConfig();
+        TestEnv env = new TestEnv(config);
+
+        // a loaded swap is pending
+        TestEnv next = new TestEnv(config);
+        doReturn(next.filter)
+            .doReturn(next.encode)
+            .doReturn(next.detect)
+            .when(env.loader).load();
+        assertTrue(env.wake.swapModels(config));
+
+        // while another swap loads on a separate thread
+        TestEnv slow = new TestEnv(config);
+        CountDownLatch loading = new CountDownLatch(1);
+        CountDownLatch release = new CountDownLatch(1);
+        doAnswer(invocation -> {
+            loading.countDown();
+            release.await();
+            return slow.filter;
+        })
+            .doReturn(slow.encode)
+            .doReturn(slow.detect)
+            .when(env.loader).load();
+        Thread swapper = new Thread(() -> env.wake.swapModels(config));
+        swapper.start();
+        loading.await();
+
+        // the pipeline thread attaches the pending swap without waiting
+        assertTimeoutPreemptively(Duration.ofSeconds(1), () -> env.process());
+        verify(env.detect).close();
+        release.countDown();
+        swapper.join();
+
+        // and the later swap is attached at the next frame
+        env.process();
+        verify(next.detect).close();
+        verify(slow.detect, never()).close();
+        env.wake.close();
+    }
+
+    @Test
+    public void testLoadFailure() throws Exception {
+        // models that fail to load in the background (here, because the
+        // model files don't exist) raise a single error
+        TestEnv env = new TestEnv(testConfig()
+            .put("model-loading", "parallel"));
+        for (int i = 0; i < 100 && env.event == null; i++) {
+            env.process();
+            Thread.sleep(10);
+        }
+        assertEquals(SpeechContext.Event.ERROR, env.event);
+        assertEquals(IllegalStateException.class,
+            env.context.getError().getClass());
+
+        // after which the stage remains disabled
+        env.event = null;
+        env.process();
+        env.process();
+        assertNull(env.event);
+        verify(env.detect, never()).run();
+
+        // until models are swapped in to replace the failed ones
+        assertTrue(env.wake.swapModels(testConfig()));
+        env.process();
+        assertNull(env.event);
+        verify(env.detect, atLeastOnce()).run();
+    }
+
     public SpeechConfig testConfig() {
         return new SpeechConfig()
             .put("sample-rate", 16000)
@@ -330,6 +472,11 @@ public class WakewordTriggerTest {
             doCallRealMethod().when(this.filter).run();
             doCallRealMethod().when(this.encode).run();
             doCallRealMethod().when(this.detect).run();
+            for (TestModel model : new TestModel[] {
+                    this.filter, this.encode, this.detect}) {
+                doReturn(TensorFormat.FLOAT).when(model).inputFormat(0);
+                doReturn(TensorFormat.FLOAT).when(model).outputFormat(0);
+            }
             doReturn(this.filter)
                 .doReturn(this.encode)
                 .doReturn(this.detect)
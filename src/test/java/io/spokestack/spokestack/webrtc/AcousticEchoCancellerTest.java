@@ -0,0 +1,297 @@
+import java.util.*;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+import org.junit.Test;
+import org.junit.jupiter.api.function.Executable;
+import static org.junit.jupiter.api.Assertions.*;
+
+import io.spokestack.spokestack.SpeechConfig;
+import io.spokestack.spokestack.SpeechContext;
+import io.spokestack.spokestack.webrtc.AcousticEchoCanceller;
+import io.spokestack.spokestack.webrtc.EchoReference;
+
+public class AcousticEchoCancellerTest {
+
+    @Test
+    public void testConstruction() {
+        final EchoReference reference = new EchoReference();
+
+        // default config
+        final SpeechConfig config = new SpeechConfig();
+        config.put("sample-rate", 8000);
+        config.put("frame-width", 10);
+        new AcousticEchoCanceller(config, reference).close();
+
+        // invalid sample rate
+        config.put("sample-rate", 44100);
+        config.put("frame-width", 20);
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() {
+                new AcousticEchoCanceller(config, reference);
+            }
+        });
+
+        // invalid frame width
+        config.put("sample-rate", 8000);
+        config.put("frame-width", 25);
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() {
+                new AcousticEchoCanceller(config, reference);
+            }
+        });
+
+        // invalid policy
+        config.put("frame-width", 20);
+        config.put("aec-policy", "invalid");
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() {
+                new AcousticEchoCanceller(config, reference);
+            }
+        });
+        config.put("aec-policy", "moderate");
+
+        // invalid delay
+        config.put("aec-delay", -1);
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() {
+                new AcousticEchoCanceller(config, reference);
+            }
+        });
+        config.put("aec-delay", 50);
+
+        // valid rates
+        for (int rate : new int[] {8000, 16000, 32000, 48000}) {
+            config.put("sample-rate", rate);
+            new AcousticEchoCanceller(config, reference).close();
+        }
+
+        // valid policies
+        config.put("aec-policy", "conservative");
+        new AcousticEchoCanceller(config, reference).close();
+        config.put("aec-policy", "moderate");
+        new AcousticEchoCanceller(config, reference).close();
+        config.put("aec-policy", "aggressive");
+        new AcousticEchoCanceller(config, reference).close();
+
+        // a reference has a single consumer
+        AcousticEchoCanceller aec =
+            new AcousticEchoCanceller(config, reference);
+        assertThrows(IllegalStateException.class, new Executable() {
+            public void execute() {
+                new AcousticEchoCanceller(config, reference);
+            }
+        });
+
+        // close coverage
+        aec.close();
+        assertFalse(reference.isActive());
+    }
+
+    @Test
+    public void testProcessing() {
+        final SpeechConfig config = new SpeechConfig()
+            .put("sample-rate", 16000)
+            .put("frame-width", 20)
+            .put("aec-delay", 0);
+        final SpeechContext context = new SpeechContext(config);
+        final EchoReference reference = new EchoReference();
+
+        // invalid frame
+        final AcousticEchoCanceller invalid =
+            new AcousticEchoCanceller(config, reference);
+        assertThrows(IllegalStateException.class, new Executable() {
+            public void execute() {
+                invalid.process(context, ByteBuffer.allocateDirect(1));
+            }
+        });
+        invalid.close();
+
+        // silent far end, near end passes through
+        AcousticEchoCanceller aec =
+            new AcousticEchoCanceller(config, reference);
+        ByteBuffer expect = sinFrame(config);
+        ByteBuffer actual = sinFrame(config);
+        for (int i = 0; i < 10; i++)
+            aec.process(context, sinFrame(config));        // warmup
+        aec.process(context, actual);
+        assertEquals(rms(expect), rms(actual), 3);
+        aec.close();
+
+        // echo cancellation
+        // the near end is a delayed, attenuated copy of the far end
+        aec = new AcousticEchoCanceller(config, reference);
+        reference.format(16000, 1);
+        Random rng = new Random(42);
+        int delay = 40;
+        short[] history = new short[delay];
+        double input = 0;
+        double output = 0;
+        for (int i = 0; i < 250; i++) {
+            ByteBuffer far = sampleBuffer(config);
+            ByteBuffer near = sampleBuffer(config);
+            for (int j = 0; j < far.capacity() / 2; j++) {
+                short sample = (short) (rng.nextGaussian() * 3000);
+                far.putShort(j * 2, sample);
+                near.putShort(j * 2, (short) (history[j % delay] / 2));
+                history[j % delay] = sample;
+            }
+            reference.write(far);
+            aec.process(context, near);
+
+            // measure the last second, after convergence
+            if (i >= 200) {
+                input += energy(far) / 4;
+                output += energy(near);
+            }
+        }
+        assertTrue(10 * Math.log10(input / output) > 10);
+        assertEquals(0, reference.getOverruns());
+        aec.close();
+    }
+
+    @Test
+    public void testReference() {
+        EchoReference reference = new EchoReference();
+        ByteBuffer frame = ByteBuffer
+            .allocateDirect(320)
+            .order(ByteOrder.nativeOrder());
+
+        // inactive reference discards writes
+        reference.format(48000, 2);
+        reference.write(stereoBuffer(480, (short) 1000));
+        assertFalse(reference.isActive());
+        reference.configure(16000);
+        reference.read(frame);
+        assertEquals(0, frame.getShort(0));
+        assertEquals(0, reference.getUnderruns());
+
+        // downmixed and resampled, 10ms of 48kHz stereo is 160 samples
+        reference.format(48000, 2);
+        reference.write(stereoBuffer(480, (short) 1000));
+        frame.clear();
+        reference.read(frame);
+        assertEquals(1000, frame.getShort(100 * 2));
+        assertEquals(1000, frame.getShort(159 * 2));
+        assertEquals(0, reference.getUnderruns());
+
+        // partial frame
+        reference.write(stereoBuffer(240, (short) 1000));
+        frame.clear();
+        reference.read(frame);
+        assertEquals(1000, frame.getShort(0));
+        assertEquals(0, frame.getShort(159 * 2));
+        assertEquals(1, reference.getUnderruns());
+
+        // unknown sample rates are discarded
+        reference.format(0, 2);
+        reference.write(stereoBuffer(480, (short) 1000));
+        reference.format(-1, 2);
+        reference.write(stereoBuffer(480, (short) 1000));
+        frame.clear();
+        reference.read(frame);
+        assertEquals(0, frame.getShort(0));
+        reference.format(48000, 2);
+
+        // overrun
+        reference.write(stereoBuffer(48000 * 4, (short) 1000));
+        assertTrue(reference.getOverruns() > 0);
+
+        // reconfiguration discards buffered audio
+        reference.write(stereoBuffer(480, (short) 1000));
+        reference.release();
+        reference.configure(16000);
+        frame.clear();
+        reference.read(frame);
+        assertEquals(0, frame.getShort(0));
+
+        reference.release();
+        assertFalse(reference.isActive());
+    }
+
+    @Test
+    public void testBroadcast() {
+        EchoReference first = EchoReference.tap();
+        EchoReference second = EchoReference.tap();
+        ByteBuffer frame = ByteBuffer
+            .allocateDirect(320)
+            .order(ByteOrder.nativeOrder());
+
+        // each configured tap receives the broadcast,
+        // including taps configured after the format was set
+        EchoReference.broadcastFormat(48000, 2);
+        first.configure(16000);
+        second.configure(16000);
+        EchoReference.broadcast(stereoBuffer(480, (short) 1000));
+        first.read(frame);
+        assertEquals(1000, frame.getShort(159 * 2));
+        frame.clear();
+        second.read(frame);
+        assertEquals(1000, frame.getShort(159 * 2));
+
+        // releasing one tap leaves the others active
+        first.release();
+        assertFalse(first.isActive());
+        assertTrue(second.isActive());
+        EchoReference.broadcast(stereoBuffer(480, (short) 2000));
+        frame.clear();
+        first.read(frame);
+        assertEquals(0, frame.getShort(0));
+        frame.clear();
+        second.read(frame);
+        assertEquals(2000, frame.getShort(159 * 2));
+        second.release();
+    }
+
+    private ByteBuffer stereoBuffer(int frames, short value) {
+        ByteBuffer buffer = ByteBuffer
+            .allocateDirect(frames * 4)
+            .order(ByteOrder.nativeOrder());
+        for (int i = 0; i < frames * 2; i++)
+            buffer.putShort(i * 2, value);
+        return buffer;
+    }
+
+    private ByteBuffer sinFrame(SpeechConfig config) {
+        ByteBuffer frame = sampleBuffer(config);
+        double rate = config.getInteger("sample-rate");
+        double freq = 100;
+        for (int i = 0; i < frame.capacity() / 2; i++) {
+            double sample = Math.sin(i / (rate / freq) * 2 * Math.PI);
+            frame.putShort(i * 2, (short)(sample * Short.MAX_VALUE / 2));
+        }
+        return frame;
+    }
+
+    private ByteBuffer sampleBuffer(SpeechConfig config) {
+        int samples = config.getInteger("sample-rate")
+            / 1000
+            * config.getInteger("frame-width");
+        return ByteBuffer
+            .allocateDirect(samples * 2)
+            .order(ByteOrder.nativeOrder());
+    }
+
+    private double energy(ByteBuffer signal) {
+        double sum = 0;
+        for (int i = 0; i < signal.capacity() / 2; i++) {
+            double sample = signal.getShort(i * 2);
+            sum += sample * sample;
+        }
+        return Math.max(sum, 1);
+    }
+
+    private double rms(ByteBuffer signal) {
+        double sum = 0;
+        int count = 0;
+
+        signal.rewind();
+        while (signal.hasRemaining()) {
+            double sample = (double) signal.getShort() / Short.MAX_VALUE;
+            sum += sample * sample;
+            count++;
+        }
+
+        return 20 * Math.log10(Math.max(Math.sqrt(sum / count), 1e-5) / 2e-5);
+    }
+}
@@ -21,7 +21,7 @@ public class AcousticNoiseSuppressorTest {
         new AcousticNoiseSuppressor(config);
 
         // invalid sample rate
-        config.put("sample-rate", 48000);
+        config.put("sample-rate", 44100);
         config.put("frame-width", 20);
         assertThrows(IllegalArgumentException.class, new Executable() {
             public void execute() { new AcousticNoiseSuppressor(config); }
@@ -42,6 +42,14 @@ public class AcousticNoiseSuppressorTest {
             public void execute() { new AcousticNoiseSuppressor(config); }
         });
 
+        // invalid backend
+        config.put("ans-policy", "mild");
+        config.put("ans-backend", "invalid");
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { new AcousticNoiseSuppressor(config); }
+        });
+        config.put("ans-backend", "fixed");
+
         // valid config
         config.put("sample-rate", 16000);
         config.put("frame-width", 20);
@@ -55,6 +63,8 @@ public class AcousticNoiseSuppressorTest {
         new AcousticNoiseSuppressor(config);
         config.put("sample-rate", 32000);
         new AcousticNoiseSuppressor(config);
+        config.put("sample-rate", 48000);
+        new AcousticNoiseSuppressor(config);
 
         // valid widths
         config.put("frame-width", 10);
@@ -71,6 +81,14 @@ public class AcousticNoiseSuppressorTest {
         new AcousticNoiseSuppressor(config);
         config.put("ans-policy", "very-aggressive");
         new AcousticNoiseSuppressor(config);
+        config.put("ans-policy", "adaptive");
+        new AcousticNoiseSuppressor(config);
+
+        // valid backends
+        config.put("ans-backend", "fixed");
+        new AcousticNoiseSuppressor(config);
+        config.put("ans-backend", "float");
+        new AcousticNoiseSuppressor(config);
 
         // close coverage
         new AcousticNoiseSuppressor(config).close();
@@ -113,6 +131,108 @@ public class AcousticNoiseSuppressorTest {
         assertEquals(rms(expect), rms(actual), 3);
     }
 
+    @Test
+    public void testFloatProcessing() {
+        for (int rate : new int[] {8000, 16000, 32000, 48000}) {
+            final SpeechConfig config = new SpeechConfig()
+                .put("sample-rate", rate)
+                .put("frame-width", 20)
+                .put("ans-policy", "medium")
+                .put("ans-backend", "float");
+            final SpeechContext context = new SpeechContext(config);
+
+            AcousticNoiseSuppressor ans = new AcousticNoiseSuppressor(config);
+            ByteBuffer expect = sinFrame(config);
+            ByteBuffer actual = addNoise(sinFrame(config));
+            ans.process(context, addNoise(sinFrame(config)));   // warmup
+            ans.process(context, actual);
+            assertEquals(rms(expect), rms(actual), 3);
+            ans.close();
+        }
+    }
+
+    @Test
+    public void testFullBandProcessing() {
+        for (int rate : new int[] {32000, 48000}) {
+            final SpeechConfig config = new SpeechConfig()
+                .put("sample-rate", rate)
+                .put("frame-width", 20)
+                .put("ans-policy", "medium");
+            final SpeechContext context = new SpeechContext(config);
+            AcousticNoiseSuppressor ans;
+            ByteBuffer actual;
+            ByteBuffer expect;
+
+            // high band preservation
+            // most of the test signal's energy is above 8kHz, so a
+            // discarded high band would attenuate it by ~8dB
+            ans = new AcousticNoiseSuppressor(config);
+            expect = mixFrame(config);
+            actual = mixFrame(config);
+            ans.process(context, mixFrame(config));             // warmup
+            ans.process(context, actual);
+            assertEquals(rms(expect), rms(actual), 3);
+
+            // valid suppression
+            ans = new AcousticNoiseSuppressor(config);
+            expect = sinFrame(config);
+            actual = addNoise(sinFrame(config));
+            ans.process(context, addNoise(sinFrame(config)));   // warmup
+            ans.process(context, actual);
+            assertEquals(rms(expect), rms(actual), 3);
+        }
+    }
+
+    @Test
+    public void testAdaptiveProcessing() {
+        for (String backend : new String[] {"fixed", "float"}) {
+            final SpeechConfig config = new SpeechConfig()
+                .put("sample-rate", 16000)
+                .put("frame-width", 20)
+                .put("ans-policy", "adaptive")
+                .put("ans-backend", backend);
+            final SpeechContext context = new SpeechContext(config);
+            AcousticNoiseSuppressor ans = new AcousticNoiseSuppressor(config);
+            Random rng = new Random(42);
+
+            // quiet environment, suppression is bypassed
+            assertFalse(ans.isBypassed());
+            for (int i = 0; i < 150; i++)
+                ans.process(context, noiseFrame(config, rng, 0.0003));
+            assertTrue(ans.isBypassed());
+            assertTrue(ans.getSnr() > 35);
+            assertEquals(-71, ans.getNoiseLevel(), 3);
+
+            // bypassed audio passes through
+            ByteBuffer expect = sinFrame(config);
+            ByteBuffer actual = sinFrame(config);
+            ans.process(context, actual);
+            assertEquals(rms(expect), rms(actual), 3);
+
+            // noisy environment, suppression is engaged
+            for (int i = 0; i < 200; i++)
+                ans.process(context, noiseFrame(config, rng, 0.3));
+            assertFalse(ans.isBypassed());
+            assertTrue(ans.getPolicy() >= 2);
+            assertTrue(ans.getSnr() < 10);
+
+            ans.close();
+        }
+    }
+
+    private ByteBuffer noiseFrame(
+            SpeechConfig config,
+            Random rng,
+            double level) {
+        ByteBuffer frame = sampleBuffer(config);
+        for (int i = 0; i < frame.capacity() / 2; i++) {
+            double sample = rng.nextGaussian() * level;
+            sample = Math.min(Math.max(sample, -1.0), 1.0);
+            frame.putShort(i * 2, (short)(sample * Short.MAX_VALUE));
+        }
+        return frame;
+    }
+
     private ByteBuffer sinFrame(SpeechConfig config) {
         ByteBuffer frame = sampleBuffer(config);
         double rate = config.getInteger("sample-rate");
@@ -124,6 +244,18 @@ public class AcousticNoiseSuppressorTest {
         return frame;
     }
 
+    private ByteBuffer mixFrame(SpeechConfig config) {
+        ByteBuffer frame = sampleBuffer(config);
+        double rate = config.getInteger("sample-rate");
+        for (int i = 0; i < frame.capacity() / 2; i++) {
+            double sample =
+                0.3 * Math.sin(i / (rate / 100) * 2 * Math.PI)
+                + 0.7 * Math.sin(i / (rate / 10000) * 2 * Math.PI);
+            frame.putShort(i * 2, (short)(sample * Short.MAX_VALUE));
+        }
+        return frame;
+    }
+
     private ByteBuffer addNoise(ByteBuffer frame) {
         Random rng = new Random(42);
         double snr = Math.pow(10, 10 / 20.0);
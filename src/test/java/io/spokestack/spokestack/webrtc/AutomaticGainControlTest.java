@@ -8,10 +8,13 @@ import org.junit.jupiter.api.function.Executable;
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
 
+import static org.junit.jupiter.api.Assertions.assertEquals;
 import static org.junit.jupiter.api.Assertions.assertThrows;
 import static org.junit.jupiter.api.Assertions.assertTrue;
 
 public class AutomaticGainControlTest {
+    // rms() reference level relative to full scale, in dB
+    private static final double REFERENCE_DB = 20 * Math.log10(2e-5);
 
     @Test
     public void testConstruction() {
@@ -47,6 +50,21 @@ public class AutomaticGainControlTest {
             public void execute() { new AutomaticGainControl(config); }
         });
 
+        // invalid mode
+        config.put("agc-compression-gain-db", 9);
+        config.put("agc-mode", "invalid");
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { new AutomaticGainControl(config); }
+        });
+        config.put("agc-mode", "adaptive-digital");
+
+        // invalid limiter
+        config.put("agc-limiter", "invalid");
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() { new AutomaticGainControl(config); }
+        });
+        config.put("agc-limiter", false);
+
         // valid config
         config.put("sample-rate", 16000);
         config.put("frame-width", 20);
@@ -68,6 +86,18 @@ public class AutomaticGainControlTest {
         config.put("frame-width", 20);
         new AutomaticGainControl(config);
 
+        // valid modes
+        config.put("agc-mode", "adaptive-digital");
+        new AutomaticGainControl(config);
+        config.put("agc-mode", "fixed-digital");
+        new AutomaticGainControl(config);
+
+        // valid limiter settings
+        config.put("agc-limiter", true);
+        new AutomaticGainControl(config);
+        config.put("agc-limiter", "false");
+        new AutomaticGainControl(config);
+
         // close coverage
         new AutomaticGainControl(config).close();
     }
@@ -108,6 +138,57 @@ public class AutomaticGainControlTest {
         assertTrue(rms(frame) < level);
     }
 
+    @Test
+    public void testTelemetry() {
+        final SpeechConfig config = new SpeechConfig()
+            .put("sample-rate", 8000)
+            .put("frame-width", 10)
+            .put("agc-target-level-dbfs", 9)
+            .put("agc-compression-gain-db", 15);
+        final SpeechContext context = new SpeechContext(config);
+        AutomaticGainControl agc;
+        ByteBuffer frame;
+
+        // levels are only measured when enabled
+        agc = new AutomaticGainControl(config);
+        agc.process(context, sinFrame(config, 0.08));
+        assertEquals(0f, agc.getGain());
+        assertEquals(0f, agc.getLevel());
+
+        // invalid telemetry flag
+        config.put("agc-telemetry", "invalid");
+        assertThrows(IllegalArgumentException.class, new Executable() {
+            public void execute() {
+                new AutomaticGainControl(config);
+            }
+        });
+        config.put("agc-telemetry", true);
+
+        // amplification
+        agc = new AutomaticGainControl(config);
+        frame = sinFrame(config, 0.08);
+        agc.process(context, frame);
+        assertTrue(agc.getGain() > 0);
+        assertEquals(rms(frame) - REFERENCE_DB, agc.getLevel(), 0.1);
+
+        // attenuation
+        agc = new AutomaticGainControl(config);
+        frame = sinFrame(config, 1.0);
+        agc.process(context, frame);
+        assertTrue(agc.getGain() < 0);
+        assertEquals(rms(frame) - REFERENCE_DB, agc.getLevel(), 0.1);
+
+        // fixed gain with limiting
+        config.put("agc-mode", "fixed-digital");
+        config.put("agc-limiter", true);
+        agc = new AutomaticGainControl(config);
+        for (int i = 0; i < 10; i++) {
+            frame = sinFrame(config, 1.0);
+            agc.process(context, frame);
+        }
+        assertEquals(rms(frame) - REFERENCE_DB, agc.getLevel(), 0.1);
+    }
+
     @Test
     public void testTracing() {
         final SpeechConfig config = new SpeechConfig()